@@ -0,0 +1,10 @@
+#version 330
+
+in vec4 vColor;
+in vec2 vTexcoord;
+
+out vec4 fColor;
+
+void main () {
+    fColor = vColor;
+}
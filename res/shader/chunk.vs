@@ -0,0 +1,47 @@
+#version 330
+
+uniform mat4 P;
+uniform mat4 V;
+uniform mat4 M;
+
+uniform vec4 C;
+
+// Packed Vertex (see chunkmesh.h).
+layout(location=5) in uvec2 vertex_data;
+
+out vec4 vColor;
+out vec2 vTexcoord;
+
+// Block Colors (enum block_type).
+const vec4 colors[6] = vec4[6](
+    vec4(1.00, 0.00, 1.00, 1.0),    // Air (never meshed)
+    vec4(0.50, 0.50, 0.52, 1.0),    // Stone
+    vec4(0.45, 0.32, 0.20, 1.0),    // Dirt
+    vec4(0.30, 0.60, 0.20, 1.0),    // Grass
+    vec4(0.86, 0.80, 0.56, 1.0),    // Sand
+    vec4(1.00, 0.85, 0.40, 1.0)     // Torch
+);
+
+// Face Shading (enum chunk_face).
+const float shade[6] = float[6](0.75, 0.75, 0.55, 1.0, 0.85, 0.85);
+
+void main () {
+    uint a = vertex_data.x;
+    uint b = vertex_data.y;
+
+    vec3 position = vec3(float(a & 31u), float((a >> 5) & 31u), float((a >> 10) & 31u));
+    uint face = (a >> 15) & 7u;
+    uint block = b & 0xFFFFu;
+    uint sky = (b >> 20) & 15u;
+    uint torch = (b >> 16) & 15u;
+
+    // Light Levels (see light.h): each level is 80% of the one above, with a little ambient.
+    float level = float(max(sky, torch));
+    float light = 0.05 + 0.95 * pow(0.8, 15.0 - level);
+
+    vColor = colors[min(block, 5u)] * C;
+    vColor.rgb *= shade[face] * light;
+    vTexcoord = vec2(float((a >> 18) & 31u), float((a >> 23) & 31u));
+
+    gl_Position = P*V*M*vec4(position, 1.0);
+}
@@ -8,7 +8,9 @@ uniform vec4 C;
 uniform vec4 T;
 
 uniform sampler2D image;
-uniform bool use_image;
+uniform sampler2DArray image_array;
+uniform int use_image;
+uniform float layer;
 
 in vec4 vColor;
 in vec2 vTexcoord;
@@ -17,4 +19,10 @@ out vec4 fColor;
 
 void main () {
     fColor = vColor;
+
+    if (use_image == 1) {
+        fColor *= texture(image, vTexcoord);
+    } else if (use_image == 2) {
+        fColor *= texture(image_array, vec3(vTexcoord, layer));
+    }
 }
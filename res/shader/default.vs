@@ -17,7 +17,7 @@ out vec2 vTexcoord;
 
 void main () {
     vColor = color * C;
-    vTexcoord = texcoord;
+    vTexcoord = T.xy + texcoord * T.zw;
 
     gl_Position = P*V*M*position;
 }
@@ -0,0 +1,185 @@
+#include "atlas.h"
+
+#include "array.h"
+#include "render.h"
+#include "lodepng.h"
+
+
+static void entry_destroy (void* item) {
+    struct atlas_entry* entry = item;
+    free(entry->pixels);
+    free(entry);
+}
+
+// Sort entries tallest first.
+static int compare_height (const void* a, const void* b) {
+    const struct atlas_entry* ea = *(struct atlas_entry* const*) a;
+    const struct atlas_entry* eb = *(struct atlas_entry* const*) b;
+    return (int) eb->height - (int) ea->height;
+}
+
+// Shelf-pack all entries into width*height, returns false if they don't fit.
+static bool pack (Atlas* atlas, struct atlas_entry** sorted, uint32_t width, uint32_t height) {
+    uint32_t pad = atlas->padding;
+    uint32_t x = 0, y = 0, shelf = 0;
+
+    for (int i = 0; i < atlas->entries->size; i++) {
+        struct atlas_entry* e = sorted[i];
+        uint32_t w = e->width + 2*pad;
+        uint32_t h = e->height + 2*pad;
+
+        if (w > width) return false;
+
+        // Start a new shelf.
+        if (x + w > width) {
+            x = 0;
+            y += shelf;
+            shelf = 0;
+        }
+
+        if (y + h > height) return false;
+
+        e->x = x + pad;
+        e->y = y + pad;
+
+        x += w;
+        if (h > shelf) shelf = h;
+    }
+
+    return true;
+}
+
+// Copy an entry into the atlas, repeating its edge pixels into the padding.
+static void blit (Atlas* atlas, uint8_t* dst, struct atlas_entry* e) {
+    int32_t pad = atlas->padding;
+
+    for (int32_t y = -pad; y < (int32_t) e->height + pad; y++) {
+        int32_t sy = y < 0 ? 0 : (y >= e->height ? e->height - 1 : y);
+
+        for (int32_t x = -pad; x < (int32_t) e->width + pad; x++) {
+            int32_t sx = x < 0 ? 0 : (x >= e->width ? e->width - 1 : x);
+
+            const uint8_t* s = e->pixels + 4 * (sy * e->width + sx);
+            uint8_t* d = dst + 4 * ((e->y + y) * atlas->width + (e->x + x));
+            memcpy(d, s, 4);
+        }
+    }
+}
+
+Atlas* atlas_create (uint32_t padding) {
+    // Allocate and Initialize.
+    Atlas* atlas = malloc(sizeof(Atlas));
+    atlas->entries = array_create();
+    atlas->padding = padding;
+    atlas->width = 0;
+    atlas->height = 0;
+    atlas->image = NULL;
+
+    return atlas;
+}
+
+void atlas_destroy (Atlas* atlas) {
+    array_destroy_callback(atlas->entries, entry_destroy);
+    free(atlas);
+}
+
+int32_t atlas_add_file (Atlas* atlas, const char* file) {
+    uint8_t* data;
+    uint32_t width, height;
+
+    // Decode.
+    uint32_t result = lodepng_decode32_file(&data, &width, &height, file);
+    if (result != 0) {
+        printf("Texture Load Error %d: %s\n", result, file);
+        return -1;
+    }
+
+    int32_t index = atlas_add_pixels(atlas, data, width, height);
+    free(data);
+
+    return index;
+}
+
+int32_t atlas_add_pixels (Atlas* atlas, const uint8_t* data, uint32_t width, uint32_t height) {
+    if (atlas->image != NULL || width == 0 || height == 0) return -1;
+
+    // Allocate and Initialize.
+    struct atlas_entry* entry = malloc(sizeof(struct atlas_entry));
+    entry->pixels = malloc(width * height * 4);
+    memcpy(entry->pixels, data, width * height * 4);
+    entry->width = width;
+    entry->height = height;
+    entry->x = 0;
+    entry->y = 0;
+
+    array_add(atlas->entries, entry);
+
+    return atlas->entries->size - 1;
+}
+
+Image* atlas_build (Atlas* atlas, uint32_t max_size) {
+    if (atlas->image != NULL) return atlas->image;
+
+    uint32_t count = atlas->entries->size;
+    if (count == 0) return NULL;
+
+    // Sort a copy of the entries (indices must stay stable).
+    struct atlas_entry** sorted = malloc(count * sizeof(struct atlas_entry*));
+    memcpy(sorted, atlas->entries->data, count * sizeof(struct atlas_entry*));
+    qsort(sorted, count, sizeof(struct atlas_entry*), compare_height);
+
+    // Starting size: smallest power of two square holding the total area.
+    uint64_t area = 0;
+    for (int i = 0; i < count; i++) {
+        area += (uint64_t) (sorted[i]->width + 2*atlas->padding) * (sorted[i]->height + 2*atlas->padding);
+    }
+    uint32_t width = 16, height = 16;
+    while ((uint64_t) width * height < area) {
+        if (width <= height) width *= 2; else height *= 2;
+    }
+
+    // Grow until everything fits (the starting size may already be too large).
+    while (width <= max_size && height <= max_size && !pack(atlas, sorted, width, height)) {
+        if (width <= height) width *= 2; else height *= 2;
+    }
+    free(sorted);
+
+    if (width > max_size || height > max_size) {
+        printf("Atlas Overflow: %d images do not fit in %dx%d\n", count, max_size, max_size);
+        return NULL;
+    }
+
+    atlas->width = width;
+    atlas->height = height;
+
+    // Compose.
+    uint8_t* pixels = calloc(width * height, 4);
+    for (int i = 0; i < count; i++) {
+        struct atlas_entry* entry = atlas->entries->data[i];
+        blit(atlas, pixels, entry);
+
+        free(entry->pixels);
+        entry->pixels = NULL;
+    }
+
+    // Upload.
+    atlas->image = image_create_pixels(pixels, width, height);
+    free(pixels);
+
+    return atlas->image;
+}
+
+Vec4f atlas_get_texture (Atlas* atlas, int32_t index) {
+    struct atlas_entry* entry = array_get(atlas->entries, index);
+    if (entry == NULL || atlas->image == NULL) return cons4f(0,0,1,1);
+
+    float w = atlas->width;
+    float h = atlas->height;
+
+    return cons4f(entry->x / w, entry->y / h, entry->width / w, entry->height / h);
+}
+
+Vec2f atlas_map_texcoord (Atlas* atlas, int32_t index, Vec2f texcoord) {
+    Vec4f t = atlas_get_texture(atlas, index);
+    return cons2f(t.x + texcoord.x * t.z, t.y + texcoord.y * t.w);
+}
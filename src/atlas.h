@@ -0,0 +1,57 @@
+#pragma once
+
+#include "main.h"
+
+// TEXTURE ATLAS
+//
+// - Packs many small RGBA images into a single Image, so differently textured
+//   objects can share one texture (and one draw call).
+// - Sub-images are packed into shelves, tallest first, with 'padding' pixels around
+//   each one. The padding repeats the sub-image's edge pixels to stop bleeding.
+// - Each sub-image is addressed through its texture transform (x, y, w, h), which is
+//   the value for DrawInfo::texture (the 'T' uniform), or can be applied to texcoords
+//   directly when batching many sub-images into one shape.
+
+
+struct atlas_entry {
+    // Source Pixels (RGBA8, released once built).
+    uint8_t* pixels;
+
+    // Size and Packed Position (in pixels).
+    uint32_t width, height;
+    uint32_t x, y;
+};
+
+struct atlas {
+    // Entries (struct atlas_entry*).
+    Array* entries;
+
+    // Padding around each entry (in pixels).
+    uint32_t padding;
+
+    // Packed Size.
+    uint32_t width, height;
+
+    // Built Image (NULL until atlas_build).
+    Image* image;
+};
+
+// Create and Destroy Atlas Objects.
+//  - atlas_destroy does not destroy the built image.
+Atlas* atlas_create (uint32_t padding);
+void atlas_destroy (Atlas* atlas);
+
+// Add Sub-Images.
+//  - Returns the sub-image index, or -1 on error.
+int32_t atlas_add_file (Atlas* atlas, const char* file);
+int32_t atlas_add_pixels (Atlas* atlas, const uint8_t* data, uint32_t width, uint32_t height);
+
+// Pack and upload all sub-images.
+//  - Returns NULL if they don't fit into max_size*max_size.
+Image* atlas_build (Atlas* atlas, uint32_t max_size);
+
+// Texture Transform of a Sub-Image.
+Vec4f atlas_get_texture (Atlas* atlas, int32_t index);
+
+// Map a texcoord in [0,1]^2 to the sub-image within the atlas.
+Vec2f atlas_map_texcoord (Atlas* atlas, int32_t index, Vec2f texcoord);
@@ -0,0 +1,434 @@
+#include "bvh.h"
+
+#include "entity.h"
+
+
+#define BVH_STACK 64
+
+// Below this depth, nodes are split in half by count (keeps the tree within the stack).
+#define BVH_MAX_SAH_DEPTH 32
+
+struct bin {
+    Vec3f min, max;
+    uint32_t count;
+};
+
+static inline Vec3f min3f (Vec3f a, Vec3f b) {
+    return cons3f(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z);
+}
+
+static inline Vec3f max3f (Vec3f a, Vec3f b) {
+    return cons3f(a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z);
+}
+
+static inline float area (Vec3f min, Vec3f max) {
+    Vec3f d = sub3f(max, min);
+    return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+static inline float axis (Vec3f v, int a) {
+    return a == 0 ? v.x : a == 1 ? v.y : v.z;
+}
+
+static void empty_bounds (Vec3f* min, Vec3f* max) {
+    *min = cons3f(INFINITY, INFINITY, INFINITY);
+    *max = cons3f(-INFINITY, -INFINITY, -INFINITY);
+}
+
+static void item_bounds (Bvh* bvh, uint32_t i) {
+    Entity* e = bvh->items[i];
+    Vec3f extent = entity_extent(e);
+    bvh->item_min[i] = sub3f(e->pos, extent);
+    bvh->item_max[i] = add3f(e->pos, extent);
+}
+
+static void swap_items (Bvh* bvh, uint32_t i, uint32_t j) {
+    Entity* e = bvh->items[i]; bvh->items[i] = bvh->items[j]; bvh->items[j] = e;
+    Vec3f v = bvh->item_min[i]; bvh->item_min[i] = bvh->item_min[j]; bvh->item_min[j] = v;
+    v = bvh->item_max[i]; bvh->item_max[i] = bvh->item_max[j]; bvh->item_max[j] = v;
+    v = bvh->item_center[i]; bvh->item_center[i] = bvh->item_center[j]; bvh->item_center[j] = v;
+}
+
+
+//
+// Build.
+//
+
+static void build_node (Bvh* bvh, uint32_t index, uint32_t first, uint32_t count, uint32_t depth) {
+    struct bvh_node* node = &bvh->nodes[index];
+
+    // Bounds of the items and of their centers.
+    Vec3f cmin, cmax;
+    empty_bounds(&node->min, &node->max);
+    empty_bounds(&cmin, &cmax);
+    for (uint32_t i = first; i < first + count; i++) {
+        node->min = min3f(node->min, bvh->item_min[i]);
+        node->max = max3f(node->max, bvh->item_max[i]);
+        cmin = min3f(cmin, bvh->item_center[i]);
+        cmax = max3f(cmax, bvh->item_center[i]);
+    }
+
+    node->first = first;
+    node->count = count;
+    if (count <= BVH_LEAF_SIZE) return;
+
+    // Find the cheapest split over the bin boundaries.
+    float best_cost = INFINITY;
+    uint32_t best_split = 0;
+
+    // Bin along the axis where the centers are spread the most.
+    Vec3f spread = sub3f(cmax, cmin);
+    int a = (spread.x >= spread.y && spread.x >= spread.z) ? 0 : (spread.y >= spread.z) ? 1 : 2;
+    float lo = axis(cmin, a);
+    float hi = axis(cmax, a);
+
+    if (hi > lo && depth < BVH_MAX_SAH_DEPTH) {
+        struct bin bins[BVH_BINS];
+        for (int b = 0; b < BVH_BINS; b++) {
+            empty_bounds(&bins[b].min, &bins[b].max);
+            bins[b].count = 0;
+        }
+
+        float scale = BVH_BINS / (hi - lo);
+        for (uint32_t i = first; i < first + count; i++) {
+            int b = (int) ((axis(bvh->item_center[i], a) - lo) * scale);
+            if (b > BVH_BINS - 1) b = BVH_BINS - 1;
+            bins[b].min = min3f(bins[b].min, bvh->item_min[i]);
+            bins[b].max = max3f(bins[b].max, bvh->item_max[i]);
+            bins[b].count++;
+        }
+
+        // Sweep from the right, then from the left.
+        float right_area[BVH_BINS];
+        uint32_t right_count[BVH_BINS];
+        Vec3f min, max;
+        uint32_t n = 0;
+        empty_bounds(&min, &max);
+        for (int b = BVH_BINS - 1; b > 0; b--) {
+            min = min3f(min, bins[b].min);
+            max = max3f(max, bins[b].max);
+            n += bins[b].count;
+            right_area[b] = n > 0 ? area(min, max) : 0;
+            right_count[b] = n;
+        }
+
+        n = 0;
+        empty_bounds(&min, &max);
+        for (int b = 0; b < BVH_BINS - 1; b++) {
+            min = min3f(min, bins[b].min);
+            max = max3f(max, bins[b].max);
+            n += bins[b].count;
+            if (n == 0 || right_count[b+1] == 0) continue;
+
+            float cost = n * area(min, max) + right_count[b+1] * right_area[b+1];
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_split = b + 1;
+            }
+        }
+    }
+
+    uint32_t mid;
+    if (best_split == 0) {
+        // All centers coincide (or the tree is too deep), split the list in half.
+        mid = first + count/2;
+    } else {
+        // Leaves are cheaper for small nodes that don't split well.
+        float leaf_cost = count * area(node->min, node->max);
+        if (count <= BVH_LEAF_SIZE * 4 && best_cost >= leaf_cost) return;
+
+        // Partition.
+        float scale = BVH_BINS / (hi - lo);
+        uint32_t i = first;
+        uint32_t j = first + count;
+        while (i < j) {
+            int b = (int) ((axis(bvh->item_center[i], a) - lo) * scale);
+            if (b > BVH_BINS - 1) b = BVH_BINS - 1;
+            if ((uint32_t) b < best_split) {
+                i++;
+            } else {
+                swap_items(bvh, i, --j);
+            }
+        }
+        mid = i;
+    }
+
+    // Children.
+    uint32_t left = bvh->node_count;
+    bvh->node_count += 2;
+
+    node->first = left;
+    node->count = 0;
+
+    build_node(bvh, left, first, mid - first, depth + 1);
+    build_node(bvh, left + 1, mid, first + count - mid, depth + 1);
+}
+
+// Summed area of all nodes relative to the root, the expected traversal cost of a random ray.
+static float tree_cost (const Bvh* bvh) {
+    float root = area(bvh->nodes[0].min, bvh->nodes[0].max);
+    if (!(root > 0)) return 0;
+
+    float sum = 0;
+    for (uint32_t i = 0; i < bvh->node_count; i++) {
+        sum += area(bvh->nodes[i].min, bvh->nodes[i].max);
+    }
+    return sum / root;
+}
+
+Bvh* bvh_create () {
+    // Allocate and Initialize.
+    Bvh* bvh = malloc(sizeof(Bvh));
+    bvh->nodes = NULL;
+    bvh->node_count = 0;
+    bvh->items = NULL;
+    bvh->item_min = NULL;
+    bvh->item_max = NULL;
+    bvh->item_center = NULL;
+    bvh->count = 0;
+    bvh->capacity = 0;
+    bvh->refits = 0;
+    bvh->build_cost = 0;
+
+    return bvh;
+}
+
+void bvh_destroy (Bvh* bvh) {
+    free(bvh->nodes);
+    free(bvh->items);
+    free(bvh->item_min);
+    free(bvh->item_max);
+    free(bvh->item_center);
+    free(bvh);
+}
+
+void bvh_build (Bvh* bvh, Entity* const* entities, uint32_t count) {
+    if (count > bvh->capacity) {
+        bvh->capacity = count;
+        bvh->nodes = realloc(bvh->nodes, 2 * count * sizeof(struct bvh_node));
+        bvh->items = realloc(bvh->items, count * sizeof(Entity*));
+        bvh->item_min = realloc(bvh->item_min, count * sizeof(Vec3f));
+        bvh->item_max = realloc(bvh->item_max, count * sizeof(Vec3f));
+        bvh->item_center = realloc(bvh->item_center, count * sizeof(Vec3f));
+    }
+
+    // Collect entities that take up space.
+    bvh->count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (entities[i]->radius > 0) {
+            bvh->items[bvh->count] = entities[i];
+            item_bounds(bvh, bvh->count);
+            bvh->item_center[bvh->count] = entities[i]->pos;
+            bvh->count++;
+        }
+    }
+
+    bvh->node_count = 0;
+    bvh->refits = 0;
+    bvh->build_cost = 0;
+    if (bvh->count == 0) return;
+
+    bvh->node_count = 1;
+    build_node(bvh, 0, 0, bvh->count, 0);
+    bvh->build_cost = tree_cost(bvh);
+}
+
+void bvh_refit (Bvh* bvh) {
+    if (bvh->node_count == 0) return;
+
+    for (uint32_t i = 0; i < bvh->count; i++) {
+        item_bounds(bvh, i);
+    }
+
+    // Children come after their parents, so a reverse pass is bottom-up.
+    for (uint32_t i = bvh->node_count; i-- > 0;) {
+        struct bvh_node* node = &bvh->nodes[i];
+        if (node->count > 0) {
+            empty_bounds(&node->min, &node->max);
+            for (uint32_t j = node->first; j < node->first + node->count; j++) {
+                node->min = min3f(node->min, bvh->item_min[j]);
+                node->max = max3f(node->max, bvh->item_max[j]);
+            }
+        } else {
+            struct bvh_node* l = &bvh->nodes[node->first];
+            struct bvh_node* r = &bvh->nodes[node->first + 1];
+            node->min = min3f(l->min, r->min);
+            node->max = max3f(l->max, r->max);
+        }
+    }
+
+    bvh->refits++;
+}
+
+void bvh_update (Bvh* bvh, Entity* const* entities, uint32_t count, bool changed) {
+    if (changed || bvh->refits >= BVH_REBUILD_TICKS) {
+        bvh_build(bvh, entities, count);
+        return;
+    }
+
+    bvh_refit(bvh);
+    if (tree_cost(bvh) > BVH_REBUILD_COST * bvh->build_cost) {
+        bvh_build(bvh, entities, count);
+    }
+}
+
+
+//
+// Queries.
+//
+
+// Ray against a box, returns the entry distance (or INFINITY).
+static inline float ray_box (Vec3f origin, Vec3f inv, float maxdist, Vec3f min, Vec3f max) {
+    float tx1 = (min.x - origin.x) * inv.x, tx2 = (max.x - origin.x) * inv.x;
+    float ty1 = (min.y - origin.y) * inv.y, ty2 = (max.y - origin.y) * inv.y;
+    float tz1 = (min.z - origin.z) * inv.z, tz2 = (max.z - origin.z) * inv.z;
+
+    float tmin = fmaxf(fmaxf(fminf(tx1, tx2), fminf(ty1, ty2)), fmaxf(fminf(tz1, tz2), 0));
+    float tmax = fminf(fminf(fmaxf(tx1, tx2), fmaxf(ty1, ty2)), fminf(fmaxf(tz1, tz2), maxdist));
+
+    return tmin <= tmax ? tmin : INFINITY;
+}
+
+// Ray against a sphere, returns the entry distance if in [0, best).
+static inline float ray_sphere (Vec3f origin, Vec3f dir, Vec3f center, float r, float best) {
+    Vec3f oc = sub3f(origin, center);
+    float b = dot3f(oc, dir);
+    float c = dot3f(oc, oc) - r*r;
+    float h = b*b - c;
+    if (h < 0) return best;
+
+    float t = -b - sqrtf(h);
+    return (t >= 0 && t < best) ? t : best;
+}
+
+float bvh_ray_capsule (Vec3f origin, Vec3f dir, Vec3f center, float r, float hs) {
+    float best = INFINITY;
+
+    if (hs > 0) {
+        // Side (infinite cylinder, limited to the segment).
+        float ox = origin.x - center.x;
+        float oz = origin.z - center.z;
+        float a = dir.x*dir.x + dir.z*dir.z;
+        if (a > 1e-12f) {
+            float b = ox*dir.x + oz*dir.z;
+            float c = ox*ox + oz*oz - r*r;
+            float h = b*b - a*c;
+            if (h >= 0) {
+                float t = (-b - sqrtf(h)) / a;
+                float y = origin.y + t*dir.y - center.y;
+                if (t >= 0 && fabsf(y) <= hs) best = t;
+            }
+        }
+
+        // Caps.
+        best = ray_sphere(origin, dir, cons3f(center.x, center.y - hs, center.z), r, best);
+        best = ray_sphere(origin, dir, cons3f(center.x, center.y + hs, center.z), r, best);
+    } else {
+        best = ray_sphere(origin, dir, center, r, best);
+    }
+
+    return best;
+}
+
+bool bvh_raycast (const Bvh* bvh, Vec3f origin, Vec3f dir, float maxdist,
+                  entity_filter_fn filter, void* user, RayHit* hit) {
+    hit->entity = NULL;
+    hit->dist = maxdist;
+    if (bvh->node_count == 0) return false;
+
+    Vec3f inv = cons3f(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+
+    uint32_t stack[BVH_STACK];
+    uint32_t top = 0;
+    uint32_t index = 0;
+
+    if (ray_box(origin, inv, maxdist, bvh->nodes[0].min, bvh->nodes[0].max) == INFINITY) return false;
+
+    while (true) {
+        const struct bvh_node* node = &bvh->nodes[index];
+
+        if (node->count > 0) {
+            // Leaf: test the capsules.
+            for (uint32_t i = node->first; i < node->first + node->count; i++) {
+                Entity* e = bvh->items[i];
+                float t = bvh_ray_capsule(origin, dir, e->pos, e->radius, entity_half_segment(e));
+                if (t >= hit->dist) continue;
+                if (filter != NULL && !filter(e, user)) continue;
+
+                hit->entity = e;
+                hit->dist = t;
+            }
+        } else {
+            // Inner node: visit the nearer child first.
+            uint32_t l = node->first;
+            uint32_t r = node->first + 1;
+            float tl = ray_box(origin, inv, hit->dist, bvh->nodes[l].min, bvh->nodes[l].max);
+            float tr = ray_box(origin, inv, hit->dist, bvh->nodes[r].min, bvh->nodes[r].max);
+
+            if (tl > tr) {
+                float t = tl; tl = tr; tr = t;
+                uint32_t i = l; l = r; r = i;
+            }
+
+            if (tl != INFINITY) {
+                if (tr != INFINITY && top < BVH_STACK) stack[top++] = r;
+                index = l;
+                continue;
+            }
+        }
+
+        // Pop, skipping nodes beyond the closest hit so far.
+        bool found = false;
+        while (top > 0) {
+            index = stack[--top];
+            if (ray_box(origin, inv, hit->dist, bvh->nodes[index].min, bvh->nodes[index].max) != INFINITY) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) break;
+    }
+
+    if (hit->entity == NULL) return false;
+
+    // Contact Point and Normal (from the closest point on the capsule's segment).
+    Entity* e = hit->entity;
+    float hs = entity_half_segment(e);
+    hit->point = add3f(origin, scale3f(hit->dist, dir));
+    float y = hit->point.y - e->pos.y;
+    if (y > hs) y = hs;
+    if (y < -hs) y = -hs;
+    hit->normal = normalize3f(sub3f(hit->point, cons3f(e->pos.x, e->pos.y + y, e->pos.z)));
+
+    return true;
+}
+
+void bvh_query_aabb (const Bvh* bvh, Vec3f min, Vec3f max, entity_query_fn fn, void* user) {
+    if (bvh->node_count == 0) return;
+
+    uint32_t stack[BVH_STACK];
+    uint32_t top = 0;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        const struct bvh_node* node = &bvh->nodes[stack[--top]];
+
+        if (node->max.x < min.x || node->min.x > max.x ||
+            node->max.y < min.y || node->min.y > max.y ||
+            node->max.z < min.z || node->min.z > max.z) continue;
+
+        if (node->count > 0) {
+            for (uint32_t i = node->first; i < node->first + node->count; i++) {
+                Vec3f imin = bvh->item_min[i];
+                Vec3f imax = bvh->item_max[i];
+                if (imax.x < min.x || imin.x > max.x ||
+                    imax.y < min.y || imin.y > max.y ||
+                    imax.z < min.z || imin.z > max.z) continue;
+                fn(bvh->items[i], user);
+            }
+        } else if (top + 2 <= BVH_STACK) {
+            stack[top++] = node->first;
+            stack[top++] = node->first + 1;
+        }
+    }
+}
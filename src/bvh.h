@@ -0,0 +1,86 @@
+#pragma once
+
+#include "main.h"
+
+// BOUNDING VOLUME HIERARCHY
+//
+// - A binary tree of boxes over entity capsules (see entity.h), for ray and
+//   box queries. Entities with radius 0 are left out.
+// - bvh_build sorts entities into the tree with a binned surface area heuristic.
+// - bvh_refit moves the boxes along with the entities without changing the tree.
+//   This is fast, but the tree gets looser the further entities move away from
+//   where they were built, so bvh_update rebuilds every BVH_REBUILD_TICKS ticks,
+//   or earlier once the refitted tree costs BVH_REBUILD_COST times the built one.
+// - The tree holds plain entity pointers (no references), so it has to be
+//   rebuilt whenever entities are removed.
+// - Nodes are stored parents before children, with both children of a node
+//   next to each other.
+
+#define BVH_LEAF_SIZE 4
+#define BVH_BINS 16
+#define BVH_REBUILD_TICKS 120
+#define BVH_REBUILD_COST 1.5f
+
+// Return false to skip an entity.
+typedef bool (*entity_filter_fn) (Entity* entity, void* user);
+
+// Called for every entity whose box overlaps the query.
+typedef void (*entity_query_fn) (Entity* entity, void* user);
+
+struct bvh_node {
+    Vec3f min;
+    uint32_t first;     // First item (leaf) or left child (inner node).
+    Vec3f max;
+    uint32_t count;     // Number of items, 0 for inner nodes.
+};
+
+struct bvh {
+    // Nodes (root is nodes[0]).
+    struct bvh_node* nodes;
+    uint32_t node_count;
+
+    // Items, in leaf order.
+    Entity** items;
+    Vec3f* item_min;
+    Vec3f* item_max;
+    Vec3f* item_center;     // Build only.
+    uint32_t count;
+    uint32_t capacity;
+
+    // Refits since the last build, and the tree cost (summed node areas) at build time.
+    uint32_t refits;
+    float build_cost;
+};
+
+struct ray_hit {
+    Entity* entity;     // NULL if nothing was hit.
+    float dist;
+    Vec3f point;
+    Vec3f normal;
+};
+
+// Create and Destroy BVHs.
+Bvh* bvh_create ();
+void bvh_destroy (Bvh* bvh);
+
+// Rebuild from scratch.
+void bvh_build (Bvh* bvh, Entity* const* entities, uint32_t count);
+
+// Move boxes along with their entities.
+void bvh_refit (Bvh* bvh);
+
+// Once per tick: refit, or rebuild if 'changed' (entities added or removed) or the tree is stale.
+void bvh_update (Bvh* bvh, Entity* const* entities, uint32_t count, bool changed);
+
+// Closest hit along a ray.
+//  - 'dir' must be normalized. 'filter' may be NULL.
+//  - Rays starting inside an entity don't hit it.
+bool bvh_raycast (const Bvh* bvh, Vec3f origin, Vec3f dir, float maxdist,
+                  entity_filter_fn filter, void* user, RayHit* hit);
+
+// Distance along a ray to an upright capsule, INFINITY if missed (or starting inside).
+//  - 'dir' must be normalized.
+float bvh_ray_capsule (Vec3f origin, Vec3f dir, Vec3f center, float radius, float half_segment);
+
+// Every entity whose box overlaps [min, max].
+void bvh_query_aabb (const Bvh* bvh, Vec3f min, Vec3f max, entity_query_fn fn, void* user);
@@ -0,0 +1,232 @@
+#include "chunkmesh.h"
+
+#include "render.h"
+#include "light.h"
+
+
+ChunkMesh* chunkmesh_create () {
+    // Allocate and Initialize.
+    ChunkMesh* mesh = malloc(sizeof(ChunkMesh));
+    mesh->capacity = 1024;
+    mesh->vertices = malloc(mesh->capacity * 2 * sizeof(uint32_t));
+    mesh->size = 0;
+    mesh->quads = 0;
+    mesh->faces = 0;
+    mesh->connections = 0;
+
+    return mesh;
+}
+
+void chunkmesh_destroy (ChunkMesh* mesh) {
+    free(mesh->vertices);
+    free(mesh);
+}
+
+void chunkmesh_gather (World* world, Vec3i pos, uint16_t* blocks, uint8_t* light) {
+    // Center and Face Neighbours (-x, +x, -y, +y, -z, +z).
+    Chunk* center = world_get_chunk(world, pos);
+    Chunk* side[6] = {
+        world_get_chunk(world, (Vec3i) {pos.i - 1, pos.j, pos.k}),
+        world_get_chunk(world, (Vec3i) {pos.i + 1, pos.j, pos.k}),
+        world_get_chunk(world, (Vec3i) {pos.i, pos.j - 1, pos.k}),
+        world_get_chunk(world, (Vec3i) {pos.i, pos.j + 1, pos.k}),
+        world_get_chunk(world, (Vec3i) {pos.i, pos.j, pos.k - 1}),
+        world_get_chunk(world, (Vec3i) {pos.i, pos.j, pos.k + 1}),
+    };
+
+    for (int32_t y = -1; y <= CHUNK_SIZE; y++) {
+        for (int32_t z = -1; z <= CHUNK_SIZE; z++) {
+            for (int32_t x = -1; x <= CHUNK_SIZE; x++) {
+                bool ox = x < 0 || x >= CHUNK_SIZE;
+                bool oy = y < 0 || y >= CHUNK_SIZE;
+                bool oz = z < 0 || z >= CHUNK_SIZE;
+
+                // Edges and corners are never looked at.
+                Chunk* chunk = NULL;
+                if (ox + oy + oz == 0) chunk = center;
+                else if (ox + oy + oz > 1) chunk = NULL;
+                else if (ox) chunk = side[x < 0 ? 0 : 1];
+                else if (oy) chunk = side[y < 0 ? 2 : 3];
+                else chunk = side[z < 0 ? 4 : 5];
+
+                if (chunk != NULL) {
+                    uint32_t index = chunk_index(x, y, z);
+                    *blocks++ = chunk_get(chunk, index);
+                    *light++ = chunk_get_light(chunk, index);
+                } else {
+                    *blocks++ = BLOCK_AIR;
+                    *light++ = LIGHT_MAX << 4;
+                }
+            }
+        }
+    }
+}
+
+static void emit_quad (ChunkMesh* mesh, uint32_t face, uint32_t d, uint32_t u, uint32_t v,
+                       uint32_t s, uint32_t i, uint32_t j, uint32_t w, uint32_t h, uint32_t key) {
+    if (mesh->size + 4 > mesh->capacity) {
+        mesh->capacity *= 2;
+        mesh->vertices = realloc(mesh->vertices, mesh->capacity * 2 * sizeof(uint32_t));
+    }
+
+    // Corners along (u,v), counter-clockwise seen from the +d side.
+    uint32_t cu[4] = {i, i + w, i + w, i};
+    uint32_t cv[4] = {j, j, j + h, j + h};
+    uint32_t tu[4] = {0, w, w, 0};
+    uint32_t tv[4] = {0, 0, h, h};
+
+    // Negative faces wind the other way.
+    static const uint32_t order[2][4] = {{0, 3, 2, 1}, {0, 1, 2, 3}};
+    uint32_t positive = face & 1;
+
+    for (uint32_t n = 0; n < 4; n++) {
+        uint32_t k = order[positive][n];
+        uint32_t c[3];
+        c[d] = s + positive;
+        c[u] = cu[k];
+        c[v] = cv[k];
+
+        uint32_t* vertex = mesh->vertices + (mesh->size + n) * 2;
+        vertex[0] = c[0] | c[1] << 5 | c[2] << 10 | face << 15 | tu[k] << 18 | tv[k] << 23;
+        vertex[1] = key;
+    }
+
+    mesh->size += 4;
+    mesh->quads++;
+}
+
+// Flood fill the open cells from the chunk's sides, joining the sides each region touches.
+static uint16_t find_connections (const uint16_t* blocks) {
+    uint64_t seen[CHUNK_VOLUME / 64] = {0};
+    uint16_t stack[CHUNK_VOLUME];
+    uint16_t connections = 0;
+
+    for (uint32_t start = 0; start < CHUNK_VOLUME; start++) {
+        int32_t x = start & CHUNK_MASK;
+        int32_t z = (start >> CHUNK_BITS) & CHUNK_MASK;
+        int32_t y = start >> (2 * CHUNK_BITS);
+
+        // Regions that matter touch a side, so start from side cells only.
+        bool side = x == 0 || x == CHUNK_MASK || y == 0 || y == CHUNK_MASK || z == 0 || z == CHUNK_MASK;
+        if (!side || (seen[start >> 6] >> (start & 63)) & 1) continue;
+        if (block_is_opaque(blocks[chunkmesh_index(x, y, z)])) continue;
+
+        uint32_t sides = 0;
+        uint32_t size = 0;
+        stack[size++] = start;
+        seen[start >> 6] |= 1ull << (start & 63);
+
+        while (size > 0) {
+            uint32_t cell = stack[--size];
+            int32_t c[3] = {cell & CHUNK_MASK, cell >> (2 * CHUNK_BITS), (cell >> CHUNK_BITS) & CHUNK_MASK};
+
+            for (uint32_t face = 0; face < 6; face++) {
+                int32_t n[3] = {c[0], c[1], c[2]};
+                n[face >> 1] += (face & 1) ? 1 : -1;
+
+                if (n[face >> 1] < 0 || n[face >> 1] >= CHUNK_SIZE) {
+                    sides |= 1u << face;
+                    continue;
+                }
+
+                uint32_t next = chunk_index(n[0], n[1], n[2]);
+                if ((seen[next >> 6] >> (next & 63)) & 1) continue;
+                if (block_is_opaque(blocks[chunkmesh_index(n[0], n[1], n[2])])) continue;
+
+                seen[next >> 6] |= 1ull << (next & 63);
+                stack[size++] = next;
+            }
+        }
+
+        for (uint32_t a = 0; a < 6; a++) {
+            for (uint32_t b = a + 1; b < 6; b++) {
+                if ((sides >> a & 1) && (sides >> b & 1)) connections |= chunkmesh_connection(a, b);
+            }
+        }
+        if (connections == CHUNKMESH_CONNECT_ALL) break;
+    }
+
+    return connections;
+}
+
+void chunkmesh_build (ChunkMesh* mesh, const uint16_t* blocks, const uint8_t* light) {
+    mesh->size = 0;
+    mesh->quads = 0;
+    mesh->faces = 0;
+    mesh->connections = find_connections(blocks);
+
+    // Snapshot strides along x, y and z.
+    const int32_t stride[3] = {1, CHUNKMESH_EDGE * CHUNKMESH_EDGE, CHUNKMESH_EDGE};
+    const int32_t origin = chunkmesh_index(0, 0, 0);
+
+    // Face keys (block | light << 16, as in word 1), 0 where no face.
+    uint32_t mask[CHUNK_SIZE * CHUNK_SIZE];
+
+    for (uint32_t face = 0; face < 6; face++) {
+        int32_t d = face >> 1;
+        uint32_t u = (d + 1) % 3;
+        uint32_t v = (d + 2) % 3;
+        int32_t step = (face & 1) ? stride[d] : -stride[d];
+
+        for (int32_t s = 0; s < CHUNK_SIZE; s++) {
+            // Visible faces of this slice.
+            uint32_t visible = 0;
+            for (int32_t j = 0; j < CHUNK_SIZE; j++) {
+                int32_t offset = origin + s * stride[d] + j * stride[v];
+                const uint16_t* row = blocks + offset;
+                const uint8_t* front = light + offset + step;
+                for (int32_t i = 0; i < CHUNK_SIZE; i++) {
+                    uint16_t block = row[i * stride[u]];
+                    uint16_t next = row[i * stride[u] + step];
+                    bool show = block != BLOCK_AIR && !block_is_opaque(next) && next != block;
+                    mask[j * CHUNK_SIZE + i] = show ? block | (uint32_t) front[i * stride[u]] << 16 : 0;
+                    visible += show;
+                }
+            }
+
+            mesh->faces += visible;
+            if (visible == 0) continue;
+
+            // Greedy Merge.
+            for (uint32_t j = 0; j < CHUNK_SIZE; j++) {
+                for (uint32_t i = 0; i < CHUNK_SIZE;) {
+                    uint32_t key = mask[j * CHUNK_SIZE + i];
+                    if (key == 0) {
+                        i++;
+                        continue;
+                    }
+
+                    // Grow along u.
+                    uint32_t w = 1;
+                    while (i + w < CHUNK_SIZE && mask[j * CHUNK_SIZE + i + w] == key) w++;
+
+                    // Grow along v while the whole row matches.
+                    uint32_t h = 1;
+                    while (j + h < CHUNK_SIZE) {
+                        uint32_t* row = mask + (j + h) * CHUNK_SIZE + i;
+                        uint32_t k = 0;
+                        while (k < w && row[k] == key) k++;
+                        if (k < w) break;
+                        h++;
+                    }
+
+                    emit_quad(mesh, face, d, u, v, s, i, j, w, h, key);
+
+                    // Consume.
+                    for (uint32_t y = 0; y < h; y++) {
+                        memset(mask + (j + y) * CHUNK_SIZE + i, 0, w * sizeof(uint32_t));
+                    }
+                    i += w;
+                }
+            }
+        }
+    }
+}
+
+Shape* chunkmesh_export (ChunkMesh* mesh, uint32_t usage) {
+    return shape_create_packed(mesh->vertices, mesh->size, usage);
+}
+
+void chunkmesh_update (ChunkMesh* mesh, Shape* shape) {
+    shape_resize(shape, mesh->vertices, mesh->size);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "main.h"
+
+#include "world.h"
+
+// CHUNK MESHER
+//
+// - Turns a chunk into packed quads for shape_create_packed (see render.h).
+// - Meshing works on a snapshot: the chunk's blocks and light plus a one block border
+//   taken from the six neighbouring chunks (CHUNKMESH_EDGE^3 block ids and light bytes).
+//   chunkmesh_gather copies it out of the world, chunkmesh_build only reads the snapshot,
+//   so it can run on any thread while the world keeps changing.
+// - Faces between a block and an opaque neighbour (or the same transparent block)
+//   are culled, including across chunk borders. Missing neighbour chunks count as air.
+// - Each face takes the light of the cell in front of it (see light.h). Missing neighbour
+//   chunks count as open sky.
+// - Connections: which pairs of the chunk's six sides are joined through open
+//   (non-opaque) cells, one bit per pair (chunkmesh_connection), for cave culling
+//   (see chunkrender.h). Open regions touching fewer than two sides join nothing.
+// - The remaining faces are merged greedily: on each slice, runs of faces with the same
+//   block and light grow along u, then along v as long as whole rows match, into one quad.
+//
+// Packed Vertex (2 x uint32):
+//
+//      word 0:  x:5  y:5  z:5  face:3  u:5  v:5        (bits 0-27)
+//      word 1:  block:16  light:8                      (bits 0-23)
+//
+//      - (x,y,z) is the corner in chunk-local blocks (0..16).
+//      - face is one of enum chunk_face, the normal direction.
+//      - (u,v) is the corner in blocks along the quad, for tiling textures.
+//      - light is the light byte of the cell in front: sky level in the high nibble,
+//        block light level in the low nibble.
+
+#define CHUNKMESH_EDGE (CHUNK_SIZE + 2)
+#define CHUNKMESH_VOLUME (CHUNKMESH_EDGE * CHUNKMESH_EDGE * CHUNKMESH_EDGE)
+
+enum chunk_face {
+    FACE_NEG_X,
+    FACE_POS_X,
+    FACE_NEG_Y,
+    FACE_POS_Y,
+    FACE_NEG_Z,
+    FACE_POS_Z,
+};
+
+struct chunk_mesh {
+    // Packed Vertices (2 uint32 each, 4 per quad).
+    uint32_t* vertices;
+    uint32_t size;              // Number of vertices.
+    uint32_t capacity;
+
+    // Side pairs joined through open cells (chunkmesh_connection bits).
+    uint16_t connections;
+
+    // Statistics of the last build.
+    uint32_t quads;             // Quads emitted (greedy).
+    uint32_t faces;             // Visible block faces (one quad each without merging).
+};
+
+// Index of snapshot cell for chunk-local (x,y,z), each in -1..CHUNK_SIZE.
+static inline
+uint32_t chunkmesh_index (int32_t x, int32_t y, int32_t z) {
+    return ((y + 1) * CHUNKMESH_EDGE + (z + 1)) * CHUNKMESH_EDGE + (x + 1);
+}
+
+// Bit of the connection between sides 'a' and 'b' (enum chunk_face, a != b).
+#define CHUNKMESH_CONNECT_ALL 0x7FFF
+
+static inline
+uint16_t chunkmesh_connection (uint32_t a, uint32_t b) {
+    // Pairs in order (0,1), (0,2) .. (0,5), (1,2) .. (4,5).
+    static const uint8_t first[6] = {0, 5, 9, 12, 14, 15};
+    if (a > b) {
+        uint32_t t = a;
+        a = b;
+        b = t;
+    }
+    return 1u << (first[a] + b - a - 1);
+}
+
+// Create and Destroy Chunk Meshes.
+ChunkMesh* chunkmesh_create ();
+void chunkmesh_destroy (ChunkMesh* mesh);
+
+// Copy the snapshot for chunk 'pos' (CHUNKMESH_VOLUME block ids and light bytes) out of the world.
+void chunkmesh_gather (World* world, Vec3i pos, uint16_t* blocks, uint8_t* light);
+
+// Mesh a snapshot, replacing the mesh's contents.
+void chunkmesh_build (ChunkMesh* mesh, const uint16_t* blocks, const uint8_t* light);
+
+// Export to a packed Shape, or update one in place (shape_resize).
+Shape* chunkmesh_export (ChunkMesh* mesh, uint32_t usage);
+void chunkmesh_update (ChunkMesh* mesh, Shape* shape);
@@ -0,0 +1,352 @@
+#include "chunkrender.h"
+
+#include "array.h"
+#include "jobs.h"
+#include "render.h"
+#include "world.h"
+#include "chunkmesh.h"
+
+
+struct mesh_job {
+    ChunkRenderer* renderer;
+    ChunkDraw* draw;
+
+    // Snapshot, and the chunk version it was taken at.
+    uint16_t blocks[CHUNKMESH_VOLUME];
+    uint8_t light[CHUNKMESH_VOLUME];
+    uint32_t version;
+
+    // Result.
+    ChunkMesh* mesh;
+};
+
+// Visibility search step: chunk, side it was entered through, and directions taken so far.
+struct search_entry {
+    ChunkDraw* draw;
+    uint8_t from;
+    uint8_t directions;
+};
+
+// Neighbour offsets (enum chunk_face order).
+static const int32_t offsets[6][3] = {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1},
+};
+
+// Chunk waiting for a job.
+struct queue_entry {
+    ChunkDraw* draw;
+    float key;
+};
+
+static void mesh_main (void* arg) {
+    struct mesh_job* job = arg;
+    ChunkRenderer* renderer = job->renderer;
+
+    chunkmesh_build(job->mesh, job->blocks, job->light);
+
+    pthread_mutex_lock(&renderer->lock);
+    array_add(renderer->finished, job);
+    pthread_mutex_unlock(&renderer->lock);
+}
+
+static void draw_release (ChunkRenderer* renderer, ChunkDraw* draw) {
+    if (draw->shape != NULL) shape_destroy(draw->shape);
+    array_remove_item(renderer->draws, draw);
+    free(draw);
+}
+
+static void on_chunk_remove (Chunk* chunk, void* user) {
+    ChunkRenderer* renderer = user;
+    ChunkDraw* draw = chunk->draw;
+    if (draw == NULL) return;
+
+    draw->chunk = NULL;
+    if (draw->busy) {
+        // Released once its job comes back.
+        if (draw->shape != NULL) shape_destroy(draw->shape);
+        draw->shape = NULL;
+    } else {
+        draw_release(renderer, draw);
+    }
+}
+
+static int compare_entries (const void* a, const void* b) {
+    float ka = ((const struct queue_entry*) a)->key;
+    float kb = ((const struct queue_entry*) b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+static Vec3f chunk_min (Vec3i pos) {
+    return cons3f(pos.i * CHUNK_SIZE, pos.j * CHUNK_SIZE, pos.k * CHUNK_SIZE);
+}
+
+static Vec3f chunk_max (Vec3i pos) {
+    return cons3f((pos.i + 1) * CHUNK_SIZE, (pos.j + 1) * CHUNK_SIZE, (pos.k + 1) * CHUNK_SIZE);
+}
+
+ChunkRenderer* chunkrender_create (World* world, JobPool* jobs, GLuint budget) {
+    // Allocate and Initialize.
+    ChunkRenderer* renderer = malloc(sizeof(ChunkRenderer));
+    renderer->world = world;
+    renderer->jobs = jobs;
+    renderer->draws = array_create();
+    renderer->finished = array_create();
+    renderer->ready = array_create();
+    renderer->spare = array_create();
+    renderer->pending = calloc(1, sizeof(JobCounter));
+    renderer->in_flight = 0;
+    renderer->max_jobs = jobs->thread_count * 2;
+    renderer->budget = budget;
+    renderer->queued = 0;
+    renderer->uploaded = 0;
+    renderer->discarded = 0;
+    renderer->drawn = 0;
+    renderer->reached = 0;
+    renderer->culled = 0;
+    renderer->visible = array_create();
+    renderer->search = 0;
+    renderer->culling = true;
+    pthread_mutex_init(&renderer->lock, NULL);
+
+    world->on_remove = on_chunk_remove;
+    world->user = renderer;
+
+    return renderer;
+}
+
+static void job_destroy (void* arg) {
+    struct mesh_job* job = arg;
+    chunkmesh_destroy(job->mesh);
+    free(job);
+}
+
+void chunkrender_destroy (ChunkRenderer* renderer) {
+    jobs_wait(renderer->jobs, renderer->pending);
+
+    for (int i = 0; i < renderer->draws->size; i++) {
+        ChunkDraw* draw = renderer->draws->data[i];
+        if (draw->chunk != NULL) draw->chunk->draw = NULL;
+        if (draw->shape != NULL) shape_destroy(draw->shape);
+        free(draw);
+    }
+
+    renderer->world->on_remove = NULL;
+    renderer->world->user = NULL;
+
+    array_destroy(renderer->draws);
+    array_destroy(renderer->visible);
+    array_destroy_callback(renderer->finished, job_destroy);
+    array_destroy_callback(renderer->ready, job_destroy);
+    array_destroy_callback(renderer->spare, job_destroy);
+    pthread_mutex_destroy(&renderer->lock);
+
+    free(renderer->pending);
+    free(renderer);
+}
+
+// Breadth first search for potentially visible chunks, from the camera's chunk.
+static void find_visible (ChunkRenderer* renderer, Vec3f eye, const Frustum* frustum) {
+    World* world = renderer->world;
+    Array* visible = renderer->visible;
+    array_clear(visible);
+    renderer->search++;
+
+    Vec3i start = chunk_coords((int32_t) floorf(eye.x), (int32_t) floorf(eye.y), (int32_t) floorf(eye.z));
+    Chunk* chunk = world_get_chunk(world, start);
+
+    // Outside the world: frustum culling only.
+    if (!renderer->culling || chunk == NULL || chunk->draw == NULL) {
+        for (int i = 0; i < renderer->draws->size; i++) {
+            ChunkDraw* draw = renderer->draws->data[i];
+            if (draw->chunk == NULL) continue;
+            if (frustum_test_aabb(frustum, chunk_min(draw->pos), chunk_max(draw->pos))) array_add(visible, draw);
+        }
+        renderer->reached = visible->size;
+        renderer->culled = 0;
+        return;
+    }
+
+    // Every chunk is queued at most once.
+    struct search_entry* queue = malloc(renderer->draws->size * sizeof(struct search_entry));
+    uint32_t head = 0, tail = 0;
+
+    chunk->draw->visited = renderer->search;
+    queue[tail++] = (struct search_entry) {chunk->draw, 6, 0};
+
+    while (head < tail) {
+        struct search_entry entry = queue[head++];
+        ChunkDraw* draw = entry.draw;
+        array_add(visible, draw);
+
+        for (uint32_t dir = 0; dir < 6; dir++) {
+            // Never back against the way taken.
+            if (entry.directions & (1u << (dir ^ 1))) continue;
+            if (entry.from < 6 && !(draw->connections & chunkmesh_connection(entry.from, dir))) continue;
+
+            Vec3i pos = {draw->pos.i + offsets[dir][0], draw->pos.j + offsets[dir][1], draw->pos.k + offsets[dir][2]};
+            Chunk* next = world_get_chunk(world, pos);
+            if (next == NULL || next->draw == NULL || next->draw->visited == renderer->search) continue;
+            if (!frustum_test_aabb(frustum, chunk_min(pos), chunk_max(pos))) continue;
+
+            next->draw->visited = renderer->search;
+            queue[tail++] = (struct search_entry) {next->draw, dir ^ 1, entry.directions | (1u << dir)};
+        }
+    }
+
+    free(queue);
+
+    // Meshes in the frustum the search didn't reach.
+    renderer->reached = visible->size;
+    renderer->culled = 0;
+    for (int i = 0; i < renderer->draws->size; i++) {
+        ChunkDraw* draw = renderer->draws->data[i];
+        if (draw->shape == NULL || draw->visited == renderer->search) continue;
+        if (frustum_test_aabb(frustum, chunk_min(draw->pos), chunk_max(draw->pos))) renderer->culled++;
+    }
+}
+
+void chunkrender_update (ChunkRenderer* renderer, Vec3f eye, const Mat4f* PV) {
+    World* world = renderer->world;
+    renderer->uploaded = 0;
+    renderer->discarded = 0;
+
+    // Collect finished meshes.
+    pthread_mutex_lock(&renderer->lock);
+    for (int i = 0; i < renderer->finished->size; i++) {
+        struct mesh_job* job = renderer->finished->data[i];
+        renderer->in_flight--;
+
+        if (job->draw->chunk != NULL) {
+            array_add(renderer->ready, job);
+        } else {
+            // Removed while meshing.
+            draw_release(renderer, job->draw);
+            array_push(renderer->spare, job);
+            renderer->discarded++;
+        }
+    }
+    array_clear(renderer->finished);
+    pthread_mutex_unlock(&renderer->lock);
+
+    // Upload within budget.
+    GLuint used = 0;
+    while (renderer->ready->size > 0 && (used < renderer->budget || renderer->uploaded == 0)) {
+        struct mesh_job* job = array_remove(renderer->ready, 0);
+        ChunkDraw* draw = job->draw;
+        ChunkMesh* mesh = job->mesh;
+        draw->busy = false;
+
+        if (draw->chunk == NULL) {
+            draw_release(renderer, draw);
+        } else {
+            if (mesh->size == 0) {
+                if (draw->shape != NULL) shape_destroy(draw->shape);
+                draw->shape = NULL;
+            } else if (draw->shape != NULL) {
+                chunkmesh_update(mesh, draw->shape);
+            } else {
+                draw->shape = chunkmesh_export(mesh, GL_DYNAMIC_DRAW);
+            }
+            draw->version = job->version;
+            draw->meshed = true;
+            draw->connections = job->mesh->connections;
+
+            used += mesh->size * 2 * sizeof(uint32_t);
+            renderer->uploaded++;
+        }
+
+        array_push(renderer->spare, job);
+    }
+
+    // Queue out of date chunks.
+    Frustum frustum = frustum_from_matrix(PV);
+    struct queue_entry* queue = malloc(world->chunk_count * sizeof(struct queue_entry));
+    uint32_t queued = 0;
+
+    for (uint32_t i = 0; i < world->table_size; i++) {
+        Chunk* chunk = world->table[i];
+        if (chunk == NULL) continue;
+
+        ChunkDraw* draw = chunk->draw;
+        if (draw == NULL) {
+            draw = calloc(1, sizeof(ChunkDraw));
+            draw->chunk = chunk;
+            draw->pos = chunk->pos;
+            draw->connections = CHUNKMESH_CONNECT_ALL;
+            chunk->draw = draw;
+            array_add(renderer->draws, draw);
+        }
+
+        if (draw->busy || (draw->meshed && draw->version == chunk->version)) continue;
+
+        // Wait for its light.
+        if (chunk->light_queued) continue;
+
+        // Air meshes are empty.
+        if (chunk_is_uniform(chunk) && chunk_get(chunk, 0) == BLOCK_AIR) {
+            if (draw->shape != NULL) shape_destroy(draw->shape);
+            draw->shape = NULL;
+            draw->version = chunk->version;
+            draw->meshed = true;
+            draw->connections = CHUNKMESH_CONNECT_ALL;
+            continue;
+        }
+
+        Vec3f min = chunk_min(chunk->pos);
+        Vec3f center = add3f(min, cons3f(CHUNK_SIZE / 2, CHUNK_SIZE / 2, CHUNK_SIZE / 2));
+        Vec3f d = sub3f(center, eye);
+        float key = dot3f(d, d);
+        if (!frustum_test_aabb(&frustum, min, chunk_max(chunk->pos))) key += 1e12f;
+
+        queue[queued++] = (struct queue_entry) {draw, key};
+    }
+
+    // Dispatch the most urgent.
+    uint32_t slots = renderer->max_jobs - renderer->in_flight;
+    if (queued > slots) {
+        qsort(queue, queued, sizeof(struct queue_entry), compare_entries);
+    } else {
+        slots = queued;
+    }
+
+    for (uint32_t i = 0; i < slots; i++) {
+        ChunkDraw* draw = queue[i].draw;
+
+        struct mesh_job* job = array_pop(renderer->spare);
+        if (job == NULL) {
+            job = malloc(sizeof(struct mesh_job));
+            job->renderer = renderer;
+            job->mesh = chunkmesh_create();
+        }
+
+        job->draw = draw;
+        job->version = draw->chunk->version;
+        chunkmesh_gather(world, draw->pos, job->blocks, job->light);
+
+        draw->busy = true;
+        renderer->in_flight++;
+        jobs_submit(renderer->jobs, mesh_main, job, JOB_LOW, renderer->pending);
+    }
+
+    renderer->queued = queued - slots;
+    free(queue);
+
+    find_visible(renderer, eye, &frustum);
+}
+
+void chunkrender_draw (ChunkRenderer* renderer, Shader* shader) {
+    renderer->drawn = 0;
+
+    DrawInfo info;
+    for (int i = 0; i < renderer->visible->size; i++) {
+        ChunkDraw* draw = renderer->visible->data[i];
+        if (draw->shape == NULL) continue;
+
+        drawinfo_init(&info);
+        info.shape = draw->shape;
+        info.model = mat4f_translate(chunk_min(draw->pos));
+        shader_draw(shader, &info);
+
+        renderer->drawn++;
+    }
+}
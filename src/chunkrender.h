@@ -0,0 +1,107 @@
+#pragma once
+
+#include "main.h"
+
+#include <glad/glad.h>
+#include <pthread.h>
+
+// CHUNK RENDERER
+//
+// - Keeps a packed Shape (see chunkmesh.h) for every chunk of a World, and rebuilds
+//   it whenever the chunk's version moves on.
+// - chunkrender_update (GL thread, once per frame):
+//    1. Collects meshes finished by the workers. A mesh that is already out of date is
+//       still newer than the one shown, so it is uploaded, and the chunk queued again.
+//    2. Uploads finished meshes until 'budget' bytes were sent this frame (at least one).
+//    3. Queues out of date chunks, chunks in the view frustum first, then nearest to the
+//       camera first, and snapshots (chunkmesh_gather) as many as there are free job
+//       slots. Meshing runs on the job pool at JOB_LOW priority.
+// - Each chunk has at most one mesh job in flight, so any number of edits made while
+//   it runs coalesce into the one rebuild that follows.
+// - Air chunks never need a job, their mesh is always empty.
+// - Chunks with queued light changes (see light.h) wait until their light is done.
+// - Cave Culling: chunkrender_update also finds the chunks that may be visible, by a
+//   breadth first search from the camera's chunk. It steps from a chunk to a neighbour
+//   only if:
+//     - the side it entered through and the side it leaves through are joined by open
+//       cells (draw->connections, see chunkmesh.h),
+//     - it never steps back against a direction taken earlier on the way (so it only
+//       moves away from the camera),
+//     - the neighbour is in the view frustum.
+//   Chunks not meshed yet count as fully open. chunkrender_draw draws only what the
+//   search reached. Solid rock around the camera stops the search, so underground only
+//   the surrounding caves are drawn. With the camera outside the world (its chunk
+//   missing), every chunk in the frustum counts as visible.
+// - Chunks removed from the world (world->on_remove) release their shape right away.
+//   The renderer must be destroyed before its world.
+
+struct chunk_draw {
+    // World Chunk (NULL once removed).
+    Chunk* chunk;
+    Vec3i pos;
+
+    // Uploaded Mesh (NULL while empty).
+    Shape* shape;
+
+    // Chunk version the shape shows.
+    uint32_t version;
+    bool meshed;
+
+    // Sides joined through open cells (chunkmesh_connection bits).
+    uint16_t connections;
+
+    // Last visibility search that reached it.
+    uint32_t visited;
+
+    // A job is running, or its mesh waits for upload.
+    bool busy;
+};
+
+struct chunk_renderer {
+    World* world;
+    JobPool* jobs;
+
+    // Every ChunkDraw (GL thread).
+    Array* draws;
+
+    // Meshes finished by workers (protected by lock).
+    Array* finished;
+    pthread_mutex_t lock;
+
+    // Meshes waiting for upload, and spare jobs (GL thread).
+    Array* ready;
+    Array* spare;
+
+    // Job Slots.
+    JobCounter* pending;
+    uint32_t in_flight;
+    uint32_t max_jobs;
+
+    // Upload Budget (bytes per frame).
+    GLuint budget;
+
+    // Potentially visible chunks (cave culling), and the search counter.
+    Array* visible;
+    uint32_t search;
+    bool culling;
+
+    // Statistics (last frame).
+    uint32_t queued;            // Out of date chunks still waiting for a job.
+    uint32_t uploaded;          // Meshes uploaded.
+    uint32_t discarded;         // Finished meshes dropped (chunk removed meanwhile).
+    uint32_t drawn;             // Chunks drawn.
+    uint32_t reached;           // Chunks reached by the visibility search.
+    uint32_t culled;            // Chunks with a mesh in the frustum, but not reached.
+};
+
+// Create and Destroy Chunk Renderers.
+//  - chunkrender_destroy waits for running jobs and releases every shape.
+ChunkRenderer* chunkrender_create (World* world, JobPool* jobs, GLuint budget);
+void chunkrender_destroy (ChunkRenderer* renderer);
+
+// Collect, upload and dispatch meshes, and find the visible chunks (GL thread, once per frame).
+//  - 'eye' is the camera position, 'PV' the projection * view matrix.
+void chunkrender_update (ChunkRenderer* renderer, Vec3f eye, const Mat4f* PV);
+
+// Draw the chunks found visible by the last chunkrender_update with the chunk shader.
+void chunkrender_draw (ChunkRenderer* renderer, Shader* shader);
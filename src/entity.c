@@ -26,7 +26,17 @@ Entity* entity_create (Environment* env, uint32_t id, uint32_t type_id, Vec3f po
     entity->flags = 0;
     entity->motion = cons3f(0,0,0);
     entity->friction = 0;
+    entity->mass = 1;
+    entity->body = 0;
     entity->awareness = 0;
+    entity->rot = cons4f(0,0,0,1);
+    entity->scale = cons3f(1,1,1);
+    entity->parent = NULL;
+    entity->world = mat4f_translate(pos);
+    entity->last_pos = pos;
+    entity->depth = 0;
+    entity->dirty = true;
+    entity->moved = false;
     entity->data = NULL;
 
     // Type-Specific Initializer.
@@ -56,14 +66,68 @@ void entity_unref (Entity* entity) {
             entity->type->on_destroy(entity);
         }
 
+        // Release Parent.
+        entity_unref(entity->parent);
+
         // Free.
         free(entity);
     }
 }
 
-void entity_load (Entity* entity) {
+void entity_set_rotation (Entity* entity, Vec4f rot) {
+    entity->rot = rot;
+    entity->dirty = true;
+}
+
+void entity_set_scale (Entity* entity, Vec3f scale) {
+    entity->scale = scale;
+    entity->dirty = true;
+}
+
+void entity_set_parent (Entity* entity, Entity* parent) {
+    if (entity->parent == parent) return;
+
+    // Refuse cycles.
+    for (Entity* p = parent; p != NULL; p = p->parent) {
+        if (p == entity) return;
+    }
+
+    if (parent != NULL) entity_ref(parent);
+    entity_unref(entity->parent);
+
+    entity->parent = parent;
+    entity->dirty = true;
+    entity->env->hierarchy_dirty = true;
+}
+
+bool entity_update_transform (Entity* entity) {
+    Entity* parent = entity->parent;
+
+    // Static entities (and children of static parents) skip the matrix work.
+    entity->moved = entity->dirty
+        || (parent != NULL && parent->moved)
+        || entity->pos.x != entity->last_pos.x
+        || entity->pos.y != entity->last_pos.y
+        || entity->pos.z != entity->last_pos.z;
+
+    if (!entity->moved) return false;
+
+    Mat4f local = mat4f_trs(entity->pos, entity->rot, entity->scale);
+    if (parent != NULL) {
+        mat4f_mul(&entity->world, &parent->world, &local);
+    } else {
+        entity->world = local;
+    }
+
+    entity->last_pos = entity->pos;
+    entity->dirty = false;
+
+    return true;
+}
+
+void entity_load (Entity* entity, const uint8_t* data, uint32_t size) {
     if (entity->type->on_load != NULL) {
-        entity->type->on_load(entity);
+        entity->type->on_load(entity, data, size);
     }
 }
 
@@ -73,10 +137,11 @@ void entity_update (Entity* entity) {
     }
 }
 
-void entity_save (Entity* entity) {
-    if (entity->type->on_save != NULL) {
-        entity->type->on_save(entity);
-    }
+uint32_t entity_save (Entity* entity, uint8_t* data) {
+    if (entity->type->on_save == NULL) return 0;
+
+    uint32_t size = entity->type->on_save(entity, data);
+    return size <= ENTITY_SAVE_MAX ? size : 0;
 }
 
 void entity_unload (Entity* entity) {
@@ -97,9 +162,9 @@ void entity_send (Entity* entity, Entity* sender, Message* message) {
     }
 }
 
-void entity_collide (Entity* entity, Entity* other) {
+void entity_collide (Entity* entity, Entity* other, float time) {
     if (entity->type->on_collide != NULL) {
-        entity->type->on_collide(entity, other);
+        entity->type->on_collide(entity, other, time);
     }
 }
 
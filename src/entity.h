@@ -3,9 +3,12 @@
 #include "main.h"
 
 
+// Entity Types (index into entity_type_list, and the type id saved with entities).
 enum entity_list {
     ENTITY_PLAYER = 0,
     ENTITY_ORB,
+
+    ENTITY_COUNT,
 };
 
 enum entity_state {
@@ -16,6 +19,9 @@ enum entity_state {
 enum entity_flags {
     // Set By Entity.
     FLAG_STATIC = 0x0001,
+    FLAG_CCD = 0x0002,          // Swept collision test, for fast movers (see physics.h).
+    FLAG_GRAVITY = 0x0004,
+    FLAG_FLOCK = 0x0008,        // Steered by the flocking pass, within 'awareness' (see flock.h).
 
     // Set By Physics Engine.
     FLAG_GROUNDED = 0x0100,
@@ -31,6 +37,8 @@ struct entity {
     uint32_t refs;
 
     // Size (Spheroid)
+    //  - Collides as an upright capsule, 'radius' wide and 'height' tall in total
+    //    (a sphere when height <= 2*radius). Entities with radius 0 don't collide.
     float radius;
     float height;
 
@@ -43,6 +51,23 @@ struct entity {
     Vec3f motion;
     float friction;
 
+    // Mass (0 is immovable), and index in the current physics step.
+    float mass;
+    uint32_t body;
+
+    // Transform (relative to the parent, if any).
+    //  - 'pos' may be written directly, rotation, scale and parent go through the setters.
+    Vec4f rot;
+    Vec3f scale;
+    Entity* parent;
+
+    // Cached World Transform (updated by the environment once per tick).
+    Mat4f world;
+    Vec3f last_pos;
+    uint32_t depth;
+    bool dirty;
+    bool moved;
+
     // Entity Awareness.
     float awareness;
 
@@ -51,21 +76,43 @@ struct entity {
 };
 
 
+// Half length of the capsule's vertical segment (0 for spheres).
+static inline
+float entity_half_segment (const Entity* entity) {
+    float h = entity->height/2 - entity->radius;
+    return h > 0 ? h : 0;
+}
+
+// Half size of the entity's bounding box.
+static inline
+Vec3f entity_extent (const Entity* entity) {
+    float r = entity->radius;
+    return cons3f(r, r + entity_half_segment(entity), r);
+}
+
+
 //
 // Entity Event Functions.
+//  - on_save writes the type-specific state that should survive the entity being saved
+//    (at most ENTITY_SAVE_MAX bytes of 'data') and returns its size. Only the transform,
+//    velocity and flags are saved otherwise, 'entity->data' is not.
+//  - on_load gets those bytes back when the entity is restored from a save, and
+//    (NULL, 0) when it is new or was kept in memory.
 //
+#define ENTITY_SAVE_MAX 256
+
 typedef void (*entity_init_fn) (Entity* entity);
 typedef void (*entity_destroy_fn) (Entity* entity);
 
-typedef void (*entity_load_fn) (Entity* entity);
+typedef void (*entity_load_fn) (Entity* entity, const uint8_t* data, uint32_t size);
 typedef void (*entity_update_fn) (Entity* entity);
-typedef void (*entity_save_fn) (Entity* entity);
+typedef uint32_t (*entity_save_fn) (Entity* entity, uint8_t* data);
 typedef void (*entity_unload_fn) (Entity* entity);
 
 typedef void (*entity_draw_fn) (Entity* entity, Shader* shader, DrawInfo* drawinfo);
 
 typedef void (*entity_receive_fn) (Entity* entity, Entity* sender, Message* Message);
-typedef void (*entity_collide_fn) (Entity* entity, Entity* other);
+typedef void (*entity_collide_fn) (Entity* entity, Entity* other, float time);
 typedef void (*entity_react_fn) (Entity* entity, Entity* other, float dist);
 
 struct entity_type {
@@ -101,11 +148,27 @@ void entity_ref (Entity* Entity);
 void entity_unref (Entity* Entity);
 
 
-void entity_load (Entity* entity);
+// Transform Setters (mark the world transform dirty).
+//  - entity_set_parent keeps the local transform, so the entity moves with the parent
+//    from then on. NULL detaches. A parent that would form a cycle is ignored.
+//  - The parent must be in the same environment.
+void entity_set_rotation (Entity* entity, Vec4f rot);
+
+void entity_set_scale (Entity* entity, Vec3f scale);
+
+void entity_set_parent (Entity* entity, Entity* parent);
+
+// Recompute the world transform if the entity or its parent changed.
+//  - The parent must already be up to date (see env_update).
+//  - Returns true (and sets entity->moved) if the world transform changed.
+bool entity_update_transform (Entity* entity);
+
+
+void entity_load (Entity* entity, const uint8_t* data, uint32_t size);
 
 void entity_update (Entity* entity);
 
-void entity_save (Entity* entity);
+uint32_t entity_save (Entity* entity, uint8_t* data);
 
 void entity_unload (Entity* entity);
 
@@ -115,6 +178,7 @@ void entity_draw (Entity* entity, Shader* shader, DrawInfo* drawinfo);
 
 void entity_send (Entity* entity, Entity* sender, Message* message);
 
-void entity_collide (Entity* entity, Entity* other);
+// 'time' is the fraction of the tick at which the contact happened (0 for resting contacts).
+void entity_collide (Entity* entity, Entity* other, float time);
 
 void entity_react (Entity* entity, Entity* other, float dist);
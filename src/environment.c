@@ -5,6 +5,17 @@
 #include "render.h"
 #include "entity.h"
 #include "player.h"
+#include "jobs.h"
+#include "imageloader.h"
+#include "mesh.h"
+#include "physics.h"
+#include "flock.h"
+#include "world.h"
+#include "chunkrender.h"
+#include "streamer.h"
+#include "region.h"
+#include "terrain.h"
+#include "light.h"
 
 
 static void on_key (Window* window, uint32_t key, uint32_t state);
@@ -17,6 +28,19 @@ static void on_resize (Window* window, int width, int height);
 
 static void get_projection (int width, int height, Mat4f* P);
 
+static void update_transforms (Environment* env);
+
+// Batched Raycast Arguments.
+struct raycast_batch {
+    Bvh* bvh;
+    const Vec3f* origins;
+    const Vec3f* dirs;
+    float maxdist;
+    entity_filter_fn filter;
+    void* user;
+    RayHit* hits;
+};
+
 enum {
     ENV_INIT,
     ENV_PRELOAD,
@@ -30,10 +54,35 @@ Environment* env_create (Window* window) {
     Environment* env = malloc(sizeof(Environment));
     env->window = window;
     env->shader = shader_create("res/shader/default");
+    env->chunk_shader = shader_create("res/shader/chunk");
+    if (env->shader == NULL || env->chunk_shader == NULL) {
+        printf("Cannot create environment: shader failed to load\n");
+        if (env->shader != NULL) shader_destroy(env->shader);
+        if (env->chunk_shader != NULL) shader_destroy(env->chunk_shader);
+        free(env);
+        return NULL;
+    }
+    env->jobs = jobs_create(0);
+    env->images = imageloader_create(env->jobs, IMAGE_UPLOAD_BUDGET);
+    env->meshes = meshcache_create();
     env->input = calloc(1, sizeof(InputState));
     env->player = player_create(env);
     env->entities = array_create();
     env->new_entities = array_create();
+    env->entities_changed = true;
+    env->transforms = array_create();
+    env->hierarchy_dirty = true;
+    env->bvh = bvh_create();
+    env->physics = physics_create(env->jobs);
+    env->flock = flock_create(env->jobs);
+    env->world = world_create();
+    env->light = light_create(env->world, env->jobs);
+    env->chunks = chunkrender_create(env->world, env->jobs, CHUNK_UPLOAD_BUDGET);
+    env->streamer = streamer_create(env->world, env->jobs);
+    env->regions = regionstore_create(REGION_DIR);
+    streamer_set_regions(env->streamer, env->regions);
+    env->terrain = terrain_create(WORLD_SEED);
+    streamer_set_source(env->streamer, terrain_source, env->terrain);
 
     window->events.on_key_event = on_key;
     window->events.on_mouse_hover_event = on_mouse_hover;
@@ -49,15 +98,20 @@ Environment* env_create (Window* window) {
     int width, height;
     window_get_size(window, &width, &height);
 
-    Mat4f P;
-    get_projection(width, height, &P);
+    get_projection(width, height, &env->projection);
 
-    shader_set_projection(env->shader, &P);
+    shader_set_projection(env->shader, &env->projection);
+    shader_set_projection(env->chunk_shader, &env->projection);
 
     return env;
 }
 
 void env_destroy (Environment* env) {
+    light_wait(env->light);
+
+    // Save the world (and everything in it but the player).
+    streamer_reset(env->streamer, env);
+
     for (int i = 0; i < env->entities->size; ++i) {
         entity_unload(env->entities->data[i]);
         entity_unref(env->entities->data[i]);
@@ -67,15 +121,33 @@ void env_destroy (Environment* env) {
         entity_unref(env->new_entities->data[i]);
     }
 
+    streamer_destroy(env->streamer);
+    regionstore_destroy(env->regions);
+    terrain_destroy(env->terrain);
+
     array_destroy(env->entities);
     array_destroy(env->new_entities);
+    array_destroy(env->transforms);
+    bvh_destroy(env->bvh);
+    physics_destroy(env->physics);
+    flock_destroy(env->flock);
+    light_destroy(env->light);
+    chunkrender_destroy(env->chunks);
+    world_destroy(env->world);
     player_destroy(env->player);
+    meshcache_destroy(env->meshes);
+    imageloader_destroy(env->images);
+    jobs_destroy(env->jobs);
     shader_destroy(env->shader);
+    shader_destroy(env->chunk_shader);
     free(env->input);
     free(env);
 }
 
 void env_update (Environment* env) {
+    // Lighting ran during the last frame's draw.
+    light_wait(env->light);
+
     if (env->state == ENV_INIT) {
 
         env->state = ENV_PRELOAD;
@@ -90,12 +162,17 @@ void env_update (Environment* env) {
 
         entity_ref(env->player->entity);
         array_add(env->entities, env->player->entity);
-        array_add(env->entities, entity_create(env, 0, ENTITY_ORB, cons3f(0, 0, -3)));
+
+        // Starting entities of a new world (saved worlds bring their own back with their chunks).
+        if (regionstore_is_empty(env->regions)) {
+            array_add(env->entities, entity_create(env, 0, ENTITY_ORB, cons3f(0, 0, -3)));
+        }
 
         for (int i = 0; i < env->entities->size; ++i) {
-            entity_load(env->entities->data[i]);
+            entity_load(env->entities->data[i], NULL, 0);
         }
 
+        env->entities_changed = true;
         env->state = ENV_RUN;
     }
 
@@ -106,15 +183,16 @@ void env_update (Environment* env) {
         }
 
         // Entity Awareness.
-        // ...
+        flock_step(env->flock, env);
 
         // Entity Physics.
-        // ...
+        physics_step(env->physics, env);
 
         // Add New Entities.
         for (int i = 0; i < env->new_entities->size; ++i) {
-            entity_load(env->new_entities->data[i]);
+            entity_load(env->new_entities->data[i], NULL, 0);
             array_add(env->entities, env->new_entities->data[i]);
+            env->entities_changed = true;
         }
         array_clear(env->new_entities);
 
@@ -125,16 +203,28 @@ void env_update (Environment* env) {
                 array_remove(env->entities, i);
                 entity_unload(e);
                 entity_unref(e);
+                env->entities_changed = true;
             } else {
                 i++;
             }
         }
 
+        // Stream Chunks (and their entities) around the player.
+        streamer_update(env->streamer, env, env->player->entity->pos);
+
+        // Update World Transforms.
+        update_transforms(env);
+
+        // Update Broadphase.
+        bvh_update(env->bvh, (Entity**) env->entities->data, env->entities->size, env->entities_changed);
+        env->entities_changed = false;
     }
 
     if (env->state == ENV_UNLOAD) {
+        // Saves everything but the player, which isn't persisted.
+        streamer_reset(env->streamer, env);
+
         for (int i = 0; i < env->entities->size; ++i) {
-            entity_save(env->entities->data[i]);
             entity_unload(env->entities->data[i]);
             entity_unref(env->entities->data[i]);
         }
@@ -145,6 +235,9 @@ void env_update (Environment* env) {
 
         array_clear(env->entities);
         array_clear(env->new_entities);
+        array_clear(env->transforms);
+        bvh_build(env->bvh, NULL, 0);
+        env->entities_changed = true;
 
         env->state = ENV_INIT;
     }
@@ -153,10 +246,27 @@ void env_update (Environment* env) {
 }
 
 void env_draw (Environment* env) {
+    imageloader_update(env->images);
+
     if (env->state == ENV_RUN) {
         Mat4f V;
         player_get_view(env->player, &V);
         shader_set_view(env->shader, &V);
+        shader_set_view(env->chunk_shader, &V);
+
+        // Camera Position + Frustum.
+        Mat4f PV, inverse = mat4f_identity();
+        mat4f_mul(&PV, &env->projection, &V);
+        mat4f_inverse_affine(&inverse, &V);
+        Vec3f eye = cons3f(inverse.dx, inverse.dy, inverse.dz);
+
+        // Voxel Chunks.
+        chunkrender_update(env->chunks, eye, &PV);
+
+        // Light the world while the frame is drawn (chunks are snapshot by now).
+        light_dispatch(env->light);
+
+        chunkrender_draw(env->chunks, env->chunk_shader);
 
         DrawInfo info;
         for (int i = 0; i < env->entities->size; i++) {
@@ -173,6 +283,80 @@ void env_add_entity (Environment* env, Entity* entity) {
     array_add(env->new_entities, entity);
 }
 
+bool env_raycast (Environment* env, Vec3f origin, Vec3f dir, float maxdist,
+                  entity_filter_fn filter, void* user, RayHit* hit) {
+    return bvh_raycast(env->bvh, origin, normalize3f(dir), maxdist, filter, user, hit);
+}
+
+static
+void raycast_batch_main (void* arg, uint32_t i) {
+    struct raycast_batch* batch = arg;
+    bvh_raycast(batch->bvh, batch->origins[i], normalize3f(batch->dirs[i]), batch->maxdist,
+        batch->filter, batch->user, &batch->hits[i]);
+}
+
+void env_raycast_batch (Environment* env, const Vec3f* origins, const Vec3f* dirs, uint32_t count,
+                        float maxdist, entity_filter_fn filter, void* user, RayHit* hits) {
+    struct raycast_batch batch = {
+        .bvh = env->bvh,
+        .origins = origins,
+        .dirs = dirs,
+        .maxdist = maxdist,
+        .filter = filter,
+        .user = user,
+        .hits = hits,
+    };
+
+    // Small batches aren't worth waking the workers.
+    if (count < 64) {
+        for (uint32_t i = 0; i < count; i++) raycast_batch_main(&batch, i);
+    } else {
+        jobs_parallel_for(env->jobs, count, raycast_batch_main, &batch);
+    }
+}
+
+
+static
+int compare_depth (const void* a, const void* b) {
+    const Entity* ea = *(Entity* const*) a;
+    const Entity* eb = *(Entity* const*) b;
+    return (ea->depth > eb->depth) - (ea->depth < eb->depth);
+}
+
+static
+void update_transforms (Environment* env) {
+    // Rebuild the pass order when entities or parents changed.
+    if (env->hierarchy_dirty || env->entities_changed) {
+        array_clear(env->transforms);
+
+        for (int i = 0; i < env->entities->size; i++) {
+            Entity* e = env->entities->data[i];
+
+            // Detach from removed parents, keeping the world position.
+            if (e->parent != NULL && e->parent->state == STATE_DESTROY) {
+                e->pos = cons3f(e->world.dx, e->world.dy, e->world.dz);
+                entity_set_parent(e, NULL);
+            }
+
+            array_add(env->transforms, e);
+        }
+
+        for (int i = 0; i < env->transforms->size; i++) {
+            Entity* e = env->transforms->data[i];
+            e->depth = 0;
+            for (Entity* p = e->parent; p != NULL; p = p->parent) e->depth++;
+        }
+
+        qsort(env->transforms->data, env->transforms->size, sizeof(void*), compare_depth);
+        env->hierarchy_dirty = false;
+    }
+
+    // Linear Pass (parents before children).
+    for (int i = 0; i < env->transforms->size; i++) {
+        entity_update_transform(env->transforms->data[i]);
+    }
+}
+
 
 static
 void on_key (Window* window, uint32_t key, uint32_t state) {
@@ -235,20 +419,14 @@ static
 void on_resize (Window* window, int width, int height) {
     Environment* env = window->user;
 
-    Mat4f P;
-    get_projection(width, height, &P);
-    shader_set_projection(env->shader, &P);
+    get_projection(width, height, &env->projection);
+    shader_set_projection(env->shader, &env->projection);
+    shader_set_projection(env->chunk_shader, &env->projection);
 }
 
 static
 void get_projection (int width, int height, Mat4f* P) {
     float a = (float) width / (float) height;
-    float f = 1.0/(float)tan(FOV/2);
-    float d = FAR - NEAR;
 
-    *P = (Mat4f) { f/a,      0,  0,             0,
-                   0,        f,  0,             0,
-                   0,        0, -(FAR+NEAR)/d, -2*FAR*NEAR/d,
-                   0,        0, -1,             0
-    };
+    *P = mat4f_perspective(FOV, a, NEAR, FAR);
 }
@@ -2,10 +2,20 @@
 
 #include "main.h"
 
+#include "bvh.h"
+
 
 struct environment {
     Window* window;
     Shader* shader;
+    Shader* chunk_shader;
+
+    // Projection (kept for culling).
+    Mat4f projection;
+
+    JobPool* jobs;
+    ImageLoader* images;
+    MeshCache* meshes;
 
     InputState* input;
 
@@ -15,6 +25,27 @@ struct environment {
 
     Array* entities;
     Array* new_entities;
+
+    // Set when entities were added or removed this tick.
+    bool entities_changed;
+
+    // Transform Pass (entities sorted by hierarchy depth, parents first).
+    Array* transforms;
+    bool hierarchy_dirty;
+
+    // Broadphase (rebuilt or refitted at the end of every tick).
+    Bvh* bvh;
+
+    Physics* physics;
+    Flock* flock;
+
+    // Voxel Blocks.
+    World* world;
+    Lighting* light;
+    ChunkRenderer* chunks;
+    Streamer* streamer;
+    RegionStore* regions;
+    Terrain* terrain;
 };
 
 struct input_state {
@@ -30,6 +61,7 @@ struct input_state {
     bool shift;
 };
 
+// Returns NULL if a shader fails to load (the error is printed).
 Environment* env_create (Window* window);
 
 void env_destroy (Environment* env);
@@ -39,3 +71,14 @@ void env_update (Environment* env);
 void env_draw (Environment* env);
 
 void env_add_entity (Environment* env, Entity* entity);
+
+// Closest entity along a ray (see bvh.h).
+//  - 'dir' doesn't need to be normalized. 'filter' may be NULL.
+//  - Returns false (and hit->entity NULL) if nothing was hit within 'maxdist'.
+bool env_raycast (Environment* env, Vec3f origin, Vec3f dir, float maxdist,
+                  entity_filter_fn filter, void* user, RayHit* hit);
+
+// Cast 'count' rays at once, spread over the job pool.
+//  - 'filter' must be safe to call from worker threads.
+void env_raycast_batch (Environment* env, const Vec3f* origins, const Vec3f* dirs, uint32_t count,
+                        float maxdist, entity_filter_fn filter, void* user, RayHit* hits);
@@ -0,0 +1,294 @@
+#include "flock.h"
+
+#include "array.h"
+#include "entity.h"
+#include "environment.h"
+#include "jobs.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// Sum of the four lanes.
+static inline float hsum (__m128 v) {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+#endif
+
+
+Flock* flock_create (JobPool* jobs) {
+    // Allocate and Initialize.
+    Flock* flock = calloc(1, sizeof(Flock));
+    flock->jobs = jobs;
+    flock->target = cons3f(0,0,0);
+    flock->seek = 0;
+
+    return flock;
+}
+
+void flock_destroy (Flock* flock) {
+    free(flock->agents);
+    free(flock->gathered);
+    free(flock->hash);
+    free(flock->cell_start);
+    free(flock->px); free(flock->py); free(flock->pz);
+    free(flock->vx); free(flock->vy); free(flock->vz);
+    free(flock->radius);
+    free(flock->out_vx); free(flock->out_vy); free(flock->out_vz);
+    free(flock);
+}
+
+void flock_set_target (Flock* flock, Vec3f target, float weight) {
+    flock->target = target;
+    flock->seek = weight;
+}
+
+static void flock_reserve (Flock* flock, uint32_t count) {
+    if (count <= flock->capacity) return;
+
+    uint32_t capacity = flock->capacity > 0 ? flock->capacity : 64;
+    while (capacity < count) capacity *= 2;
+
+    flock->agents = realloc(flock->agents, capacity * sizeof(Entity*));
+    flock->gathered = realloc(flock->gathered, capacity * sizeof(Entity*));
+    flock->hash = realloc(flock->hash, capacity * sizeof(uint32_t));
+
+    float** arrays[] = {
+        &flock->px, &flock->py, &flock->pz, &flock->vx, &flock->vy, &flock->vz,
+        &flock->radius, &flock->out_vx, &flock->out_vy, &flock->out_vz,
+    };
+    for (int i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        *arrays[i] = realloc(*arrays[i], capacity * sizeof(float));
+    }
+
+    // Twice as many buckets as agents keeps collisions rare.
+    flock->table_size = capacity * 2;
+    flock->cell_start = realloc(flock->cell_start, (flock->table_size + 1) * sizeof(uint32_t));
+
+    flock->capacity = capacity;
+}
+
+static inline uint32_t cell_hash (int32_t x, int32_t y, int32_t z, uint32_t mask) {
+    return ((uint32_t) x * 73856093u ^ (uint32_t) y * 19349663u ^ (uint32_t) z * 83492791u) & mask;
+}
+
+static inline int32_t cell_coord (float p, float inv) {
+    return (int32_t) floorf(p * inv);
+}
+
+// Sums over neighbours: separation, alignment, cohesion (xyz each) and count.
+//  - SSE2 keeps four partial sums per value until every bucket has been visited.
+struct neighbours {
+#if defined(__SSE2__)
+    __m128 lanes[10];
+#endif
+    float sums[10];
+};
+
+// Add the agents [first, last) within sqrt(r2) of (x, y, z) to the neighbour sums.
+//  - Most of the run is outside the radius (27 cells of an awareness-sized grid hold
+//    ~6x the sphere's volume), so every agent is weighted by 0 or 1 instead of branching.
+//  - SSE2 does four agents at a time, the scalar loop finishes the run.
+static inline void sum_run (const Flock* flock, float x, float y, float z, float r2, uint32_t first, uint32_t last, struct neighbours* nb) {
+    const float* px = flock->px; const float* py = flock->py; const float* pz = flock->pz;
+    const float* vx = flock->vx; const float* vy = flock->vy; const float* vz = flock->vz;
+    uint32_t j = first;
+
+#if defined(__SSE2__)
+    __m128 x4 = _mm_set1_ps(x), y4 = _mm_set1_ps(y), z4 = _mm_set1_ps(z);
+    __m128 r24 = _mm_set1_ps(r2), zero = _mm_setzero_ps(), one = _mm_set1_ps(1), eps = _mm_set1_ps(1e-6f);
+
+    __m128 sx = nb->lanes[0], sy = nb->lanes[1], sz = nb->lanes[2];
+    __m128 ax = nb->lanes[3], ay = nb->lanes[4], az = nb->lanes[5];
+    __m128 cx = nb->lanes[6], cy = nb->lanes[7], cz = nb->lanes[8];
+    __m128 n = nb->lanes[9];
+
+    for (; j + 4 <= last; j += 4) {
+        __m128 qx = _mm_loadu_ps(px + j), qy = _mm_loadu_ps(py + j), qz = _mm_loadu_ps(pz + j);
+        __m128 ox = _mm_sub_ps(x4, qx), oy = _mm_sub_ps(y4, qy), oz = _mm_sub_ps(z4, qz);
+        __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz));
+        __m128 w = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(d2, r24), _mm_cmpgt_ps(d2, zero)), one);
+        __m128 ws = _mm_div_ps(w, _mm_add_ps(d2, eps));
+
+        sx = _mm_add_ps(sx, _mm_mul_ps(ox, ws));
+        sy = _mm_add_ps(sy, _mm_mul_ps(oy, ws));
+        sz = _mm_add_ps(sz, _mm_mul_ps(oz, ws));
+        ax = _mm_add_ps(ax, _mm_mul_ps(_mm_loadu_ps(vx + j), w));
+        ay = _mm_add_ps(ay, _mm_mul_ps(_mm_loadu_ps(vy + j), w));
+        az = _mm_add_ps(az, _mm_mul_ps(_mm_loadu_ps(vz + j), w));
+        cx = _mm_add_ps(cx, _mm_mul_ps(qx, w));
+        cy = _mm_add_ps(cy, _mm_mul_ps(qy, w));
+        cz = _mm_add_ps(cz, _mm_mul_ps(qz, w));
+        n = _mm_add_ps(n, w);
+    }
+
+    nb->lanes[0] = sx; nb->lanes[1] = sy; nb->lanes[2] = sz;
+    nb->lanes[3] = ax; nb->lanes[4] = ay; nb->lanes[5] = az;
+    nb->lanes[6] = cx; nb->lanes[7] = cy; nb->lanes[8] = cz;
+    nb->lanes[9] = n;
+#endif
+
+    float* sums = nb->sums;
+    for (; j < last; j++) {
+        float ox = x - px[j], oy = y - py[j], oz = z - pz[j];
+        float d2 = ox*ox + oy*oy + oz*oz;
+        float w = (d2 < r2 && d2 > 0) ? 1.0f : 0.0f;
+        float ws = w / (d2 + 1e-6f);
+
+        sums[0] += ox * ws; sums[1] += oy * ws; sums[2] += oz * ws;
+        sums[3] += vx[j] * w; sums[4] += vy[j] * w; sums[5] += vz[j] * w;
+        sums[6] += px[j] * w; sums[7] += py[j] * w; sums[8] += pz[j] * w;
+        sums[9] += w;
+    }
+}
+
+// Steer one block of agents.
+static void steer_block (void* arg, uint32_t block) {
+    Flock* flock = arg;
+    uint32_t mask = flock->table_size - 1;
+    float inv = 1 / flock->cell_size;
+
+    uint32_t begin = block * FLOCK_BLOCK;
+    uint32_t end = begin + FLOCK_BLOCK;
+    if (end > flock->count) end = flock->count;
+
+    const float* px = flock->px; const float* py = flock->py; const float* pz = flock->pz;
+    const float* vx = flock->vx; const float* vy = flock->vy; const float* vz = flock->vz;
+
+    for (uint32_t i = begin; i < end; i++) {
+        float x = px[i], y = py[i], z = pz[i];
+        float r2 = flock->radius[i] * flock->radius[i];
+
+        struct neighbours nb = {0};
+
+        int32_t gx = cell_coord(x, inv), gy = cell_coord(y, inv), gz = cell_coord(z, inv);
+
+        // Visit each of the 27 surrounding buckets once (cells can share a bucket).
+        uint32_t visited[27];
+        uint32_t visited_count = 0;
+
+        for (int32_t dz = -1; dz <= 1; dz++)
+        for (int32_t dy = -1; dy <= 1; dy++)
+        for (int32_t dx = -1; dx <= 1; dx++) {
+            uint32_t h = cell_hash(gx + dx, gy + dy, gz + dz, mask);
+
+            bool seen = false;
+            for (uint32_t k = 0; k < visited_count; k++) seen |= visited[k] == h;
+            if (seen) continue;
+            visited[visited_count++] = h;
+
+            sum_run(flock, x, y, z, r2, flock->cell_start[h], flock->cell_start[h + 1], &nb);
+        }
+
+        const float* sums = nb.sums;
+#if defined(__SSE2__)
+        for (int k = 0; k < 10; k++) {
+            nb.sums[k] += hsum(nb.lanes[k]);
+        }
+#endif
+        float sx = sums[0], sy = sums[1], sz = sums[2];
+        float ax = sums[3], ay = sums[4], az = sums[5];
+        float cx = sums[6], cy = sums[7], cz = sums[8];
+        float n = sums[9];
+
+        // Desired velocity from each behaviour, steering towards it.
+        Vec3f v = cons3f(vx[i], vy[i], vz[i]);
+        Vec3f steer = cons3f(0,0,0);
+
+        if (n > 0) {
+            Vec3f sep = cons3f(sx, sy, sz);
+            Vec3f ali = scale3f(1/n, cons3f(ax, ay, az));
+            Vec3f coh = sub3f(scale3f(1/n, cons3f(cx, cy, cz)), cons3f(x, y, z));
+
+            if (lengthSquared3f(sep) > 0)
+                steer = add3f(steer, scale3f(FLOCK_SEPARATION, sub3f(scale3f(FLOCK_MAX_SPEED, normalize3f(sep)), v)));
+            if (lengthSquared3f(ali) > 0)
+                steer = add3f(steer, scale3f(FLOCK_ALIGNMENT, sub3f(scale3f(FLOCK_MAX_SPEED, normalize3f(ali)), v)));
+            if (lengthSquared3f(coh) > 0)
+                steer = add3f(steer, scale3f(FLOCK_COHESION, sub3f(scale3f(FLOCK_MAX_SPEED, normalize3f(coh)), v)));
+        }
+
+        if (flock->seek > 0) {
+            Vec3f to = sub3f(flock->target, cons3f(x, y, z));
+            if (lengthSquared3f(to) > 0)
+                steer = add3f(steer, scale3f(flock->seek, sub3f(scale3f(FLOCK_MAX_SPEED, normalize3f(to)), v)));
+        }
+
+        // Limit force and speed.
+        float f = length3f(steer);
+        if (f > FLOCK_MAX_FORCE) steer = scale3f(FLOCK_MAX_FORCE / f, steer);
+
+        v = add3f(v, steer);
+        float s = length3f(v);
+        if (s > FLOCK_MAX_SPEED) v = scale3f(FLOCK_MAX_SPEED / s, v);
+
+        flock->out_vx[i] = v.x;
+        flock->out_vy[i] = v.y;
+        flock->out_vz[i] = v.z;
+    }
+}
+
+void flock_step (Flock* flock, Environment* env) {
+    Array* entities = env->entities;
+
+    // Gather Agents.
+    uint32_t count = 0;
+    float cell_size = 0;
+    for (int i = 0; i < entities->size; i++) {
+        Entity* e = entities->data[i];
+        if (!(e->flags & FLAG_FLOCK) || e->state == STATE_DESTROY) continue;
+
+        flock_reserve(flock, count + 1);
+        flock->gathered[count++] = e;
+        if (e->awareness > cell_size) cell_size = e->awareness;
+    }
+
+    flock->count = count;
+    if (count == 0 || cell_size <= 0) return;
+    flock->cell_size = cell_size;
+
+    // Bucket Agents (counting sort by cell hash).
+    uint32_t mask = flock->table_size - 1;
+    float inv = 1 / cell_size;
+    memset(flock->cell_start, 0, (flock->table_size + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < count; i++) {
+        Vec3f p = flock->gathered[i]->pos;
+        uint32_t h = cell_hash(cell_coord(p.x, inv), cell_coord(p.y, inv), cell_coord(p.z, inv), mask);
+        flock->hash[i] = h;
+        flock->cell_start[h + 1]++;
+    }
+    for (uint32_t h = 0; h < flock->table_size; h++) {
+        flock->cell_start[h + 1] += flock->cell_start[h];
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        flock->agents[flock->cell_start[flock->hash[i]]++] = flock->gathered[i];
+    }
+    // Scattering advanced every start to the next bucket's, shift them back.
+    for (uint32_t h = flock->table_size; h > 0; h--) {
+        flock->cell_start[h] = flock->cell_start[h - 1];
+    }
+    flock->cell_start[0] = 0;
+
+    // Pack State.
+    for (uint32_t i = 0; i < count; i++) {
+        Entity* e = flock->agents[i];
+        flock->px[i] = e->pos.x; flock->py[i] = e->pos.y; flock->pz[i] = e->pos.z;
+        flock->vx[i] = e->vel.x; flock->vy[i] = e->vel.y; flock->vz[i] = e->vel.z;
+        flock->radius[i] = e->awareness;
+    }
+
+    // Steer.
+    uint32_t blocks = (count + FLOCK_BLOCK - 1) / FLOCK_BLOCK;
+    if (blocks == 1) {
+        steer_block(flock, 0);
+    } else {
+        jobs_parallel_for(flock->jobs, blocks, steer_block, flock);
+    }
+
+    // Write Back.
+    for (uint32_t i = 0; i < count; i++) {
+        flock->agents[i]->vel = cons3f(flock->out_vx[i], flock->out_vy[i], flock->out_vz[i]);
+    }
+}
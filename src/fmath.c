@@ -0,0 +1,92 @@
+#include "fmath.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// Sine and cosine of 4 values (precise or fast polynomials).
+static inline
+void sincos4 (__m128 x, __m128* s, __m128* c, int fast) {
+    // Argument Reduction (_mm_cvtps_epi32 rounds to nearest).
+    __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(FMATH_2_PI)));
+    __m128 nf = _mm_cvtepi32_ps(q);
+
+    __m128 r = x;
+    r = _mm_sub_ps(r, _mm_mul_ps(nf, _mm_set1_ps(FMATH_PI_2_A)));
+    r = _mm_sub_ps(r, _mm_mul_ps(nf, _mm_set1_ps(FMATH_PI_2_B)));
+    r = _mm_sub_ps(r, _mm_mul_ps(nf, _mm_set1_ps(FMATH_PI_2_C)));
+    __m128 z = _mm_mul_ps(r, r);
+
+    // Polynomials (same as fmath.h).
+    __m128 sp, cp;
+    if (fast) {
+        sp = _mm_add_ps(_mm_set1_ps(-1.6666666667e-1f), _mm_mul_ps(z, _mm_set1_ps(8.3333333333e-3f)));
+        sp = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), sp));
+
+        cp = _mm_add_ps(_mm_set1_ps(4.1666666667e-2f), _mm_mul_ps(z, _mm_set1_ps(-1.3888888889e-3f)));
+        cp = _mm_add_ps(_mm_set1_ps(-0.5f), _mm_mul_ps(z, cp));
+        cp = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(z, cp));
+    } else {
+        sp = _mm_add_ps(_mm_set1_ps(8.3321608736e-3f), _mm_mul_ps(z, _mm_set1_ps(-1.9515295891e-4f)));
+        sp = _mm_add_ps(_mm_set1_ps(-1.6666654611e-1f), _mm_mul_ps(z, sp));
+        sp = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, z), sp));
+
+        cp = _mm_add_ps(_mm_set1_ps(-1.388731625493765e-3f), _mm_mul_ps(z, _mm_set1_ps(2.443315711809948e-5f)));
+        cp = _mm_add_ps(_mm_set1_ps(4.166664568298827e-2f), _mm_mul_ps(z, cp));
+        cp = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_mul_ps(_mm_mul_ps(z, z), cp));
+    }
+
+    // Quadrant: odd quadrants swap sin and cos, the signs follow bit 1 of q (sin) and q+1 (cos).
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sin_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    __m128 cos_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+    __m128 sv = _mm_or_ps(_mm_and_ps(swap, cp), _mm_andnot_ps(swap, sp));
+    __m128 cv = _mm_or_ps(_mm_and_ps(swap, sp), _mm_andnot_ps(swap, cp));
+
+    *s = _mm_xor_ps(sv, sin_sign);
+    *c = _mm_xor_ps(cv, cos_sign);
+}
+
+void fsincos_array (const float* x, float* s, float* c, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 sv, cv;
+        sincos4(_mm_loadu_ps(x + i), &sv, &cv, 0);
+        _mm_storeu_ps(s + i, sv);
+        _mm_storeu_ps(c + i, cv);
+    }
+    for (; i < count; i++) {
+        fsincos(x[i], &s[i], &c[i]);
+    }
+}
+
+void fsincos_array_fast (const float* x, float* s, float* c, uint32_t count) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 sv, cv;
+        sincos4(_mm_loadu_ps(x + i), &sv, &cv, 1);
+        _mm_storeu_ps(s + i, sv);
+        _mm_storeu_ps(c + i, cv);
+    }
+    for (; i < count; i++) {
+        fsincos_fast(x[i], &s[i], &c[i]);
+    }
+}
+
+#else
+
+void fsincos_array (const float* x, float* s, float* c, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        float xi = x[i];
+        fsincos(xi, &s[i], &c[i]);
+    }
+}
+
+void fsincos_array_fast (const float* x, float* s, float* c, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        float xi = x[i];
+        fsincos_fast(xi, &s[i], &c[i]);
+    }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+
+/***
+ ***    Float Trig mini-Library.
+ ***        - Single precision sin/cos with a fused sincos, so hot paths don't
+ ***          round-trip through the double libm functions.
+ ***        - Two accuracy levels:
+ ***            fsincos, fsin, fcos:    max error ~1e-7 (about 1 ulp in [-1,1]).
+ ***            *_fast:                 max error ~4e-5, a few multiplies shorter.
+ ***        - Array versions (fmath.c) compute 4 values at a time with SSE2.
+ ***        - Arguments are reduced to [-pi/4, pi/4] in float, accuracy drops off
+ ***          for |x| beyond ~1e4. NaN and infinity are not handled.
+ ***/
+
+// pi/2 split into three parts for the argument reduction (Cody-Waite).
+#define FMATH_2_PI      0.63661977236758134f
+#define FMATH_PI_2_A    1.5703125f
+#define FMATH_PI_2_B    4.837512969970703125e-4f
+#define FMATH_PI_2_C    7.54978995489188216e-8f
+
+
+/*  Argument Reduction.
+ *      - Returns r in [-pi/4, pi/4] with x = r + q*pi/2.
+ */
+static inline
+float fmath_reduce (float x, int32_t* q) {
+    float k = x * FMATH_2_PI;
+    int32_t n = (int32_t) (k + (k >= 0 ? 0.5f : -0.5f));
+    float nf = (float) n;
+
+    *q = n;
+    return ((x - nf*FMATH_PI_2_A) - nf*FMATH_PI_2_B) - nf*FMATH_PI_2_C;
+}
+
+/*  Quadrant Selection.
+ *      - Maps sin(r), cos(r) to sin(x), cos(x) for x = r + q*pi/2.
+ */
+static inline
+void fmath_quadrant (int32_t q, float sr, float cr, float* s, float* c) {
+    switch (q & 3) {
+        case 0: *s =  sr; *c =  cr; break;
+        case 1: *s =  cr; *c = -sr; break;
+        case 2: *s = -sr; *c = -cr; break;
+        case 3: *s = -cr; *c =  sr; break;
+    }
+}
+
+
+/*  Sine and Cosine.
+ */
+static inline
+void fsincos (float x, float* s, float* c) {
+    int32_t q;
+    float r = fmath_reduce(x, &q);
+    float z = r*r;
+
+    // Minimax polynomials on [-pi/4, pi/4] (Cephes).
+    float sr = r + r*z*(-1.6666654611e-1f + z*(8.3321608736e-3f + z*-1.9515295891e-4f));
+    float cr = 1.0f - 0.5f*z + z*z*(4.166664568298827e-2f + z*(-1.388731625493765e-3f + z*2.443315711809948e-5f));
+
+    fmath_quadrant(q, sr, cr, s, c);
+}
+
+static inline
+float fsin (float x) { float s, c; fsincos(x, &s, &c); return s; }
+static inline
+float fcos (float x) { float s, c; fsincos(x, &s, &c); return c; }
+
+
+/*  Sine and Cosine, Low Accuracy.
+ */
+static inline
+void fsincos_fast (float x, float* s, float* c) {
+    int32_t q;
+    float r = fmath_reduce(x, &q);
+    float z = r*r;
+
+    // Taylor polynomials, one term shorter each.
+    float sr = r + r*z*(-1.6666666667e-1f + z*8.3333333333e-3f);
+    float cr = 1.0f + z*(-0.5f + z*(4.1666666667e-2f + z*-1.3888888889e-3f));
+
+    fmath_quadrant(q, sr, cr, s, c);
+}
+
+static inline
+float fsin_fast (float x) { float s, c; fsincos_fast(x, &s, &c); return s; }
+static inline
+float fcos_fast (float x) { float s, c; fsincos_fast(x, &s, &c); return c; }
+
+
+/*  Array Versions (fmath.c).
+ *      - s[i] = sin(x[i]), c[i] = cos(x[i]) for 'count' values.
+ *      - Either 's' or 'c' may be the same array as 'x'.
+ */
+void fsincos_array (const float* x, float* s, float* c, uint32_t count);
+void fsincos_array_fast (const float* x, float* s, float* c, uint32_t count);
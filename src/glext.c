@@ -0,0 +1,45 @@
+#include "glext.h"
+
+
+struct glext GLEXT = {0};
+
+static bool has_version (int major, int minor) {
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+bool glext_supported (const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+    for (int i = 0; i < count; i++) {
+        const char* ext = (const char*) glGetStringi(GL_EXTENSIONS, i);
+        if (ext != NULL && strcmp(ext, name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+void glext_init (GLADloadproc load) {
+    GLEXT = (struct glext) {0};
+
+    // ARB_buffer_storage.
+    if (has_version(4, 4) || glext_supported("GL_ARB_buffer_storage")) {
+        GLEXT.BufferStorage = (PFNGLBUFFERSTORAGEPROC) load("glBufferStorage");
+        GLEXT.buffer_storage = GLEXT.BufferStorage != NULL;
+    }
+
+    // ARB_get_program_binary (only useful if the driver has any binary formats).
+    if (has_version(4, 1) || glext_supported("GL_ARB_get_program_binary")) {
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+        GLEXT.GetProgramBinary = (PFNGLGETPROGRAMBINARYPROC) load("glGetProgramBinary");
+        GLEXT.ProgramBinary = (PFNGLPROGRAMBINARYPROC) load("glProgramBinary");
+        GLEXT.ProgramParameteri = (PFNGLPROGRAMPARAMETERIPROC) load("glProgramParameteri");
+        GLEXT.program_binary = formats > 0
+            && GLEXT.GetProgramBinary != NULL
+            && GLEXT.ProgramBinary != NULL
+            && GLEXT.ProgramParameteri != NULL;
+    }
+}
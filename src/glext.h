@@ -0,0 +1,58 @@
+#pragma once
+
+#include "main.h"
+
+#include <glad/glad.h>
+
+// OPTIONAL EXTENSIONS
+//
+// - glad is generated for the 3.3 core profile without any extensions.
+// - Entry points newer than 3.3 are loaded here at runtime instead.
+// - An entry point is only valid to call when its matching flag is set.
+
+
+// ARB_buffer_storage (Core in 4.4).
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#endif
+
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC) (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+
+// ARB_get_program_binary (Core in 4.1).
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#define GL_PROGRAM_BINARY_FORMATS 0x87FF
+#endif
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC) (GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC) (GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC) (GLuint program, GLenum pname, GLint value);
+
+
+// Loaded Extensions.
+struct glext {
+    // ARB_buffer_storage.
+    bool buffer_storage;
+    PFNGLBUFFERSTORAGEPROC BufferStorage;
+
+    // ARB_get_program_binary.
+    bool program_binary;
+    PFNGLGETPROGRAMBINARYPROC GetProgramBinary;
+    PFNGLPROGRAMBINARYPROC ProgramBinary;
+    PFNGLPROGRAMPARAMETERIPROC ProgramParameteri;
+};
+
+extern struct glext GLEXT;
+
+// Load optional entry points.
+//  - Must be called with a current context, after gladLoadGL.
+void glext_init (GLADloadproc load);
+
+// Check the extension string list for 'name'.
+bool glext_supported (const char* name);
@@ -0,0 +1,262 @@
+#include "imageloader.h"
+
+#include "array.h"
+#include "jobs.h"
+#include "render.h"
+#include "lodepng.h"
+
+
+struct image_request {
+    ImageLoader* loader;
+    Image* image;
+
+    // Source File + Completion Callback.
+    char* file;
+    image_loaded_fn callback;
+    void* user;
+
+    // Decoded Data (set by the decode job).
+    uint8_t* data;
+    uint32_t width, height;
+    uint32_t result;
+
+    // Upload Progress (GL thread).
+    GLuint texture;
+    uint32_t rows;
+};
+
+// Pending upload of a row range through the PBO.
+struct row_upload {
+    struct image_request* request;
+    uint32_t first_row;
+    uint32_t rows;
+    GLintptr offset;
+};
+
+static void request_destroy (struct image_request* request) {
+    free(request->file);
+    free(request->data);
+    free(request);
+}
+
+static void decode_job (void* arg) {
+    struct image_request* request = arg;
+    ImageLoader* loader = request->loader;
+
+    // Decode (on a worker).
+    request->result = lodepng_decode32_file(&request->data, &request->width, &request->height, request->file);
+    if (request->result == 0 && (request->width == 0 || request->height == 0)) {
+        request->result = 1;
+    }
+
+    // Hand over to the GL thread.
+    pthread_mutex_lock(&loader->lock);
+    array_add(loader->decoded, request);
+    pthread_mutex_unlock(&loader->lock);
+}
+
+// Finish a request, successful or not (GL thread).
+static void request_finish (struct image_request* request) {
+    Image* image = request->image;
+
+    if (image->state == IMAGE_CANCELLED) {
+        if (request->texture != 0) glDeleteTextures(1, &request->texture);
+        free(image);
+    } else if (request->result != 0) {
+        printf("Texture Load Error %d: %s\n", request->result, request->file);
+        if (request->texture != 0) glDeleteTextures(1, &request->texture);
+        image->state = IMAGE_FAILED;
+        if (request->callback != NULL) request->callback(image, request->user);
+    } else {
+        image->image_id = request->texture;
+        image->width = request->width;
+        image->height = request->height;
+        image->state = IMAGE_READY;
+        if (request->callback != NULL) request->callback(image, request->user);
+    }
+
+    request_destroy(request);
+}
+
+ImageLoader* imageloader_create (JobPool* jobs, GLuint budget) {
+    // Placeholder Texture (1x1 White).
+    GLuint placeholder;
+    uint8_t white[4] = {255, 255, 255, 255};
+    glGenTextures(1, &placeholder);
+    glBindTexture(GL_TEXTURE_2D, placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Pixel Unpack Buffer.
+    GLuint pbo_id;
+    glGenBuffers(1, &pbo_id);
+
+    // Allocate and Initialize.
+    ImageLoader* loader = malloc(sizeof(ImageLoader));
+    loader->jobs = jobs;
+    loader->placeholder = placeholder;
+    loader->pbo_id = pbo_id;
+    loader->pbo_size = 0;
+    loader->budget = budget;
+    loader->decoded = array_create();
+    loader->uploading = array_create();
+    loader->pending = calloc(1, sizeof(JobCounter));
+    pthread_mutex_init(&loader->lock, NULL);
+
+    return loader;
+}
+
+void imageloader_destroy (ImageLoader* loader) {
+    // Let outstanding decodes finish.
+    jobs_wait(loader->jobs, loader->pending);
+
+    // Drop everything that didn't make it.
+    for (int i = 0; i < loader->decoded->size; i++) {
+        array_add(loader->uploading, loader->decoded->data[i]);
+    }
+    for (int i = 0; i < loader->uploading->size; i++) {
+        struct image_request* request = loader->uploading->data[i];
+        if (request->image->state == IMAGE_CANCELLED) {
+            free(request->image);
+        } else {
+            request->image->state = IMAGE_FAILED;
+            request->image->image_id = 0;
+        }
+        if (request->texture != 0) glDeleteTextures(1, &request->texture);
+        request_destroy(request);
+    }
+
+    array_destroy(loader->decoded);
+    array_destroy(loader->uploading);
+    pthread_mutex_destroy(&loader->lock);
+
+    glDeleteBuffers(1, &loader->pbo_id);
+    glDeleteTextures(1, &loader->placeholder);
+
+    free(loader->pending);
+    free(loader);
+}
+
+Image* imageloader_load (ImageLoader* loader, const char* file, image_loaded_fn callback, void* user) {
+    // Allocate and Initialize (drawn with the placeholder until ready).
+    Image* image = malloc(sizeof(Image));
+    image->image_id = loader->placeholder;
+    image->state = IMAGE_LOADING;
+    image->target = GL_TEXTURE_2D;
+    image->width = 1;
+    image->height = 1;
+    image->layers = 1;
+
+    struct image_request* request = calloc(1, sizeof(struct image_request));
+    request->loader = loader;
+    request->image = image;
+    request->file = strdup(file);
+    request->callback = callback;
+    request->user = user;
+
+    // Decode in the background.
+    jobs_submit(loader->jobs, decode_job, request, JOB_LOW, loader->pending);
+
+    return image;
+}
+
+void imageloader_update (ImageLoader* loader) {
+    // Collect decoded requests.
+    pthread_mutex_lock(&loader->lock);
+    for (int i = 0; i < loader->decoded->size; i++) {
+        array_add(loader->uploading, loader->decoded->data[i]);
+    }
+    array_clear(loader->decoded);
+    pthread_mutex_unlock(&loader->lock);
+
+    // Finish failed and cancelled requests right away.
+    for (int i = 0; i < loader->uploading->size;) {
+        struct image_request* request = loader->uploading->data[i];
+        if (request->result != 0 || request->image->state == IMAGE_CANCELLED) {
+            array_remove(loader->uploading, i);
+            request_finish(request);
+        } else {
+            i++;
+        }
+    }
+
+    if (loader->uploading->size == 0) return;
+
+    // Orphan the PBO (at least one row of the next image must fit).
+    struct image_request* first = loader->uploading->data[0];
+    GLuint size = loader->budget;
+    if (size < first->width * 4) size = first->width * 4;
+    if (size > loader->pbo_size) loader->pbo_size = size;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, loader->pbo_id);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, loader->pbo_size, NULL, GL_STREAM_DRAW);
+    uint8_t* mapping = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, loader->pbo_size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapping == NULL) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return;
+    }
+
+    // Copy rows into the PBO, within budget.
+    struct row_upload uploads[loader->uploading->size];
+    uint32_t upload_count = 0;
+    GLuint used = 0;
+
+    for (int i = 0; i < loader->uploading->size; i++) {
+        struct image_request* request = loader->uploading->data[i];
+        uint32_t row_size = request->width * 4;
+
+        uint32_t rows = (size - used) / row_size;
+        if (rows > request->height - request->rows) rows = request->height - request->rows;
+        if (rows == 0) break;
+
+        memcpy(mapping + used, request->data + request->rows * row_size, rows * row_size);
+
+        uploads[upload_count++] = (struct row_upload) {
+            .request = request,
+            .first_row = request->rows,
+            .rows = rows,
+            .offset = used,
+        };
+
+        request->rows += rows;
+        used += rows * row_size;
+    }
+
+    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+    // Upload from the PBO.
+    for (uint32_t i = 0; i < upload_count; i++) {
+        struct image_request* request = uploads[i].request;
+
+        // Allocate the texture on the first upload.
+        if (request->texture == 0) {
+            glGenTextures(1, &request->texture);
+            glBindTexture(GL_TEXTURE_2D, request->texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, request->width, request->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        } else {
+            glBindTexture(GL_TEXTURE_2D, request->texture);
+        }
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, uploads[i].first_row, request->width, uploads[i].rows,
+            GL_RGBA, GL_UNSIGNED_BYTE, (void*) uploads[i].offset);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Swap in completed images.
+    for (int i = 0; i < loader->uploading->size;) {
+        struct image_request* request = loader->uploading->data[i];
+        if (request->rows == request->height) {
+            array_remove(loader->uploading, i);
+            request_finish(request);
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "main.h"
+
+#include <glad/glad.h>
+#include <pthread.h>
+
+// ASYNCHRONOUS IMAGE LOADER
+//
+// - imageloader_load returns an Image immediately. Until it is ready, the image
+//   uses a shared 1x1 white placeholder texture, so it can be drawn right away.
+// - PNG decoding runs as a background job on the job pool.
+// - Decoded images are uploaded on the GL thread from imageloader_update (once per frame),
+//   row by row through a pixel unpack buffer, with at most 'budget' bytes per frame.
+//   Large images are spread over several frames, and only swap from the placeholder
+//   to their own texture once complete.
+// - Completion can be polled (image->state) or reported through a callback,
+//   which is called from imageloader_update.
+// - Destroying an image that is still loading is fine, it is released once the
+//   decode job is done.
+
+typedef void (*image_loaded_fn) (Image* image, void* user);
+
+struct imageloader {
+    JobPool* jobs;
+
+    // Shared Placeholder Texture.
+    GLuint placeholder;
+
+    // Pixel Unpack Buffer (orphaned every frame).
+    GLuint pbo_id;
+    GLuint pbo_size;
+
+    // Upload Budget (bytes per frame).
+    GLuint budget;
+
+    // Decoded requests, waiting for upload (protected by lock).
+    Array* decoded;
+    pthread_mutex_t lock;
+
+    // Requests being uploaded (GL thread only).
+    Array* uploading;
+
+    // Requests still decoding.
+    JobCounter* pending;
+};
+
+// Create and Destroy Image Loaders.
+//  - imageloader_destroy waits for outstanding decodes and drops unfinished uploads.
+ImageLoader* imageloader_create (JobPool* jobs, GLuint budget);
+void imageloader_destroy (ImageLoader* loader);
+
+// Start loading an image (never blocks).
+//  - 'callback' may be NULL.
+Image* imageloader_load (ImageLoader* loader, const char* file, image_loaded_fn callback, void* user);
+
+// Upload decoded images within the per-frame budget (GL thread, once per frame).
+void imageloader_update (ImageLoader* loader);
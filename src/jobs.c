@@ -0,0 +1,187 @@
+#include "jobs.h"
+
+#include <unistd.h>
+
+
+struct job {
+    job_fn fn;
+    void* arg;
+    JobCounter* counter;
+
+    struct job* next;
+};
+
+// Parallel-For Argument.
+struct range_job {
+    job_range_fn fn;
+    void* arg;
+
+    uint32_t begin;
+    uint32_t end;
+};
+
+// Pop the next job (lock must be held).
+static struct job* pop_job (JobPool* pool, uint32_t max_priority) {
+    for (uint32_t p = JOB_HIGH; p <= max_priority; p++) {
+        struct job* job = pool->head[p];
+        if (job != NULL) {
+            pool->head[p] = job->next;
+            if (pool->head[p] == NULL) pool->tail[p] = NULL;
+            return job;
+        }
+    }
+    return NULL;
+}
+
+// Run a job and release the lock meanwhile (lock must be held).
+static void run_job (JobPool* pool, struct job* job) {
+    pthread_mutex_unlock(&pool->lock);
+    job->fn(job->arg);
+    pthread_mutex_lock(&pool->lock);
+
+    if (job->counter != NULL) {
+        job->counter->pending--;
+        if (job->counter->pending == 0)
+            pthread_cond_broadcast(&pool->done);
+    }
+
+    free(job);
+}
+
+static void* worker_main (void* arg) {
+    JobPool* pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        struct job* job = pop_job(pool, JOB_LOW);
+
+        if (job != NULL) {
+            run_job(pool, job);
+        } else if (pool->quit) {
+            break;
+        } else {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+static void range_main (void* arg) {
+    struct range_job* range = arg;
+    for (uint32_t i = range->begin; i < range->end; i++) {
+        range->fn(range->arg, i);
+    }
+}
+
+JobPool* jobs_create (uint32_t threads) {
+    if (threads == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cores > 1 ? cores - 1 : 1;
+    }
+
+    // Allocate and Initialize.
+    JobPool* pool = malloc(sizeof(JobPool));
+    pool->threads = calloc(threads, sizeof(pthread_t));
+    pool->thread_count = threads;
+    pool->head[JOB_HIGH] = pool->tail[JOB_HIGH] = NULL;
+    pool->head[JOB_LOW] = pool->tail[JOB_LOW] = NULL;
+    pool->quit = false;
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    // Start Workers.
+    for (uint32_t i = 0; i < threads; i++) {
+        pthread_create(&pool->threads[i], NULL, worker_main, pool);
+    }
+
+    return pool;
+}
+
+void jobs_destroy (JobPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (uint32_t i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->wake);
+    pthread_cond_destroy(&pool->done);
+
+    free(pool->threads);
+    free(pool);
+}
+
+void jobs_submit (JobPool* pool, job_fn fn, void* arg, uint32_t priority, JobCounter* counter) {
+    struct job* job = malloc(sizeof(struct job));
+    job->fn = fn;
+    job->arg = arg;
+    job->counter = counter;
+    job->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+
+    if (counter != NULL) counter->pending++;
+
+    if (pool->tail[priority] != NULL) {
+        pool->tail[priority]->next = job;
+    } else {
+        pool->head[priority] = job;
+    }
+    pool->tail[priority] = job;
+
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void jobs_wait (JobPool* pool, JobCounter* counter) {
+    pthread_mutex_lock(&pool->lock);
+    while (counter->pending > 0) {
+        // Help with frame-critical work instead of sleeping.
+        struct job* job = pop_job(pool, JOB_HIGH);
+        if (job != NULL) {
+            run_job(pool, job);
+        } else {
+            pthread_cond_wait(&pool->done, &pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+bool jobs_done (JobPool* pool, JobCounter* counter) {
+    pthread_mutex_lock(&pool->lock);
+    bool done = counter->pending == 0;
+    pthread_mutex_unlock(&pool->lock);
+
+    return done;
+}
+
+void jobs_parallel_for (JobPool* pool, uint32_t count, job_range_fn fn, void* arg) {
+    if (count == 0) return;
+
+    // A few batches per thread (workers + this one) to even out the load.
+    uint32_t batches = (pool->thread_count + 1) * 4;
+    if (batches > count) batches = count;
+
+    struct range_job ranges[batches];
+    JobCounter counter = {0};
+
+    for (uint32_t i = 0; i < batches; i++) {
+        ranges[i] = (struct range_job) {
+            .fn = fn,
+            .arg = arg,
+            .begin = (uint64_t) count * i / batches,
+            .end = (uint64_t) count * (i + 1) / batches,
+        };
+        jobs_submit(pool, range_main, &ranges[i], JOB_HIGH, &counter);
+    }
+
+    jobs_wait(pool, &counter);
+}
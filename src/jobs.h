@@ -0,0 +1,65 @@
+#pragma once
+
+#include "main.h"
+
+#include <pthread.h>
+
+// JOB POOL
+//
+// - A fixed set of worker threads running jobs from a shared queue.
+// - Jobs are either JOB_HIGH (short, frame-critical work that someone is waiting on)
+//   or JOB_LOW (background work such as decoding or generation). Workers always
+//   take high priority jobs first.
+// - A JobCounter tracks a set of submitted jobs so they can be waited on.
+//   While waiting, the calling thread helps by running high priority jobs itself,
+//   so a wait never stalls behind background work.
+
+
+typedef void (*job_fn) (void* arg);
+typedef void (*job_range_fn) (void* arg, uint32_t index);
+
+enum job_priority {
+    JOB_HIGH,
+    JOB_LOW,
+};
+
+struct job;
+
+struct job_counter {
+    uint32_t pending;
+};
+
+struct job_pool {
+    // Worker Threads.
+    pthread_t* threads;
+    uint32_t thread_count;
+
+    // Queues (one per priority), protected by lock.
+    struct job* head[2];
+    struct job* tail[2];
+
+    pthread_mutex_t lock;
+    pthread_cond_t wake;    // Signalled when a job is queued.
+    pthread_cond_t done;    // Signalled when a counter reaches zero.
+
+    bool quit;
+};
+
+// Create and Destroy Job Pools.
+//  - 'threads' is the number of workers, 0 picks one less than the number of cores.
+//  - jobs_destroy finishes all queued jobs first.
+JobPool* jobs_create (uint32_t threads);
+void jobs_destroy (JobPool* pool);
+
+// Submit a job.
+//  - 'counter' may be NULL for fire-and-forget jobs.
+void jobs_submit (JobPool* pool, job_fn fn, void* arg, uint32_t priority, JobCounter* counter);
+
+// Wait until every job submitted with 'counter' has finished.
+void jobs_wait (JobPool* pool, JobCounter* counter);
+
+// Check if every job submitted with 'counter' has finished (never blocks).
+bool jobs_done (JobPool* pool, JobCounter* counter);
+
+// Run fn(arg, i) for i in [0,count) across the workers and the calling thread, and wait.
+void jobs_parallel_for (JobPool* pool, uint32_t count, job_range_fn fn, void* arg);
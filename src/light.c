@@ -0,0 +1,459 @@
+#include "light.h"
+
+#include "jobs.h"
+#include "world.h"
+
+
+// Neighbour directions, in enum chunk_face order (-x, +x, -y, +y, -z, +z).
+static const int32_t offsets[6][3] = {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1},
+};
+
+enum {
+    DIR_DOWN = 2,
+    DIR_UP = 3,
+};
+
+Lighting* light_create (World* world, JobPool* jobs) {
+    // Allocate and Initialize.
+    Lighting* light = calloc(1, sizeof(Lighting));
+    light->world = world;
+    light->jobs = jobs;
+    light->pending = calloc(1, sizeof(JobCounter));
+    light->running = false;
+
+    world->light = light;
+
+    return light;
+}
+
+void light_destroy (Lighting* light) {
+    light_wait(light);
+    light->world->light = NULL;
+
+    free(light->edits);
+    free(light->loads);
+    free(light->job_edits);
+    free(light->job_loads);
+    free(light->add.nodes);
+    free(light->remove.nodes);
+    free(light->touched);
+    free(light->pending);
+    free(light);
+}
+
+
+//
+// Queues.
+//
+
+static void queue_push (struct light_queue* queue, Chunk* chunk, uint32_t index, uint32_t channel, uint32_t level) {
+    if (queue->size == queue->capacity) {
+        if (queue->head > 0) {
+            // Reuse the consumed front.
+            memmove(queue->nodes, queue->nodes + queue->head, (queue->size - queue->head) * sizeof(struct light_node));
+            queue->size -= queue->head;
+            queue->head = 0;
+        } else {
+            queue->capacity = queue->capacity > 0 ? queue->capacity * 2 : 1024;
+            queue->nodes = realloc(queue->nodes, queue->capacity * sizeof(struct light_node));
+        }
+    }
+
+    queue->nodes[queue->size++] = (struct light_node) {chunk, index, channel, level};
+}
+
+static bool queue_pop (struct light_queue* queue, struct light_node* node) {
+    if (queue->head == queue->size) {
+        queue->head = queue->size = 0;
+        return false;
+    }
+
+    *node = queue->nodes[queue->head++];
+    return true;
+}
+
+static void push_pos (Vec3i** list, uint32_t* count, uint32_t* capacity, Vec3i pos) {
+    if (*count == *capacity) {
+        *capacity = *capacity > 0 ? *capacity * 2 : 64;
+        *list = realloc(*list, *capacity * sizeof(Vec3i));
+    }
+    (*list)[(*count)++] = pos;
+}
+
+void light_queue_block (Lighting* light, Chunk* chunk, int32_t x, int32_t y, int32_t z) {
+    push_pos(&light->edits, &light->edit_count, &light->edit_capacity, (Vec3i) {x, y, z});
+    chunk->light_queued = true;
+}
+
+void light_queue_chunk (Lighting* light, Chunk* chunk) {
+    push_pos(&light->loads, &light->load_count, &light->load_capacity, chunk->pos);
+    chunk->light_queued = true;
+}
+
+
+//
+// Cells.
+//
+
+static inline uint32_t get_level (const Chunk* chunk, uint32_t index, uint32_t channel) {
+    return (chunk_get_light(chunk, index) >> (channel * 4)) & LIGHT_MAX;
+}
+
+static void touch (Lighting* light, Chunk* chunk) {
+    if (chunk->light_dirty) return;
+    chunk->light_dirty = true;
+
+    if (light->touched_count == light->touched_capacity) {
+        light->touched_capacity = light->touched_capacity > 0 ? light->touched_capacity * 2 : 64;
+        light->touched = realloc(light->touched, light->touched_capacity * sizeof(Chunk*));
+    }
+    light->touched[light->touched_count++] = chunk;
+}
+
+static void touch_side (Lighting* light, Chunk* chunk, uint32_t dir) {
+    Vec3i pos = {chunk->pos.i + offsets[dir][0], chunk->pos.j + offsets[dir][1], chunk->pos.k + offsets[dir][2]};
+    Chunk* other = world_get_chunk(light->world, pos);
+    if (other != NULL && other->lit) touch(light, other);
+}
+
+static void set_level (Lighting* light, Chunk* chunk, uint32_t index, uint32_t channel, uint32_t level) {
+    if (chunk->light == NULL) {
+        chunk->light = malloc(CHUNK_VOLUME);
+        memset(chunk->light, chunk->light_fill, CHUNK_VOLUME);
+    }
+
+    uint32_t shift = channel * 4;
+    chunk->light[index] = (chunk->light[index] & ~(LIGHT_MAX << shift)) | level << shift;
+    light->cells++;
+
+    // Neighbours mesh their faces against border cells.
+    touch(light, chunk);
+    uint32_t x = index & CHUNK_MASK;
+    uint32_t z = (index >> CHUNK_BITS) & CHUNK_MASK;
+    uint32_t y = index >> (2 * CHUNK_BITS);
+    if (x == 0) touch_side(light, chunk, 0);
+    if (x == CHUNK_MASK) touch_side(light, chunk, 1);
+    if (y == 0) touch_side(light, chunk, 2);
+    if (y == CHUNK_MASK) touch_side(light, chunk, 3);
+    if (z == 0) touch_side(light, chunk, 4);
+    if (z == CHUNK_MASK) touch_side(light, chunk, 5);
+}
+
+// Cell next to 'index' in direction 'dir', NULL if its chunk is missing or not lit yet.
+static Chunk* neighbour (World* world, Chunk* chunk, uint32_t index, uint32_t dir, uint32_t* out) {
+    int32_t x = (index & CHUNK_MASK) + offsets[dir][0];
+    int32_t z = ((index >> CHUNK_BITS) & CHUNK_MASK) + offsets[dir][2];
+    int32_t y = (index >> (2 * CHUNK_BITS)) + offsets[dir][1];
+    *out = chunk_index(x, y, z);
+
+    if (((x | y | z) & ~CHUNK_MASK) == 0) return chunk;
+
+    Vec3i pos = {chunk->pos.i + offsets[dir][0], chunk->pos.j + offsets[dir][1], chunk->pos.k + offsets[dir][2]};
+    Chunk* other = world_get_chunk(world, pos);
+    return other != NULL && other->lit ? other : NULL;
+}
+
+static bool sky_above (World* world, Chunk* chunk) {
+    return world_get_chunk(world, (Vec3i) {chunk->pos.i, chunk->pos.j + 1, chunk->pos.k}) == NULL;
+}
+
+
+//
+// Flood Fills.
+//
+
+static void propagate_removal (Lighting* light) {
+    World* world = light->world;
+    struct light_node node;
+
+    while (queue_pop(&light->remove, &node)) {
+        for (uint32_t dir = 0; dir < 6; dir++) {
+            uint32_t index;
+            Chunk* chunk = neighbour(world, node.chunk, node.index, dir, &index);
+            if (chunk == NULL) continue;
+
+            uint32_t level = get_level(chunk, index, node.channel);
+            if (level == 0) continue;
+
+            // Full sky light below full sky light came from it.
+            bool column = node.channel == LIGHT_SKY && dir == DIR_DOWN && node.level == LIGHT_MAX;
+
+            if (level < node.level || (column && level == LIGHT_MAX)) {
+                set_level(light, chunk, index, node.channel, 0);
+                queue_push(&light->remove, chunk, index, node.channel, level);
+
+                // Light sources stay lit.
+                uint32_t emission = block_emission(chunk_get(chunk, index));
+                if (node.channel == LIGHT_BLOCK && emission > 0) {
+                    set_level(light, chunk, index, LIGHT_BLOCK, emission);
+                    queue_push(&light->add, chunk, index, LIGHT_BLOCK, emission);
+                }
+            } else {
+                // Lit from elsewhere, spread it back in.
+                queue_push(&light->add, chunk, index, node.channel, level);
+            }
+        }
+    }
+}
+
+static void propagate_add (Lighting* light) {
+    World* world = light->world;
+    struct light_node node;
+
+    while (queue_pop(&light->add, &node)) {
+        uint32_t level = get_level(node.chunk, node.index, node.channel);
+        if (level <= 1) continue;
+
+        for (uint32_t dir = 0; dir < 6; dir++) {
+            uint32_t index;
+            Chunk* chunk = neighbour(world, node.chunk, node.index, dir, &index);
+            if (chunk == NULL) continue;
+            if (block_is_opaque(chunk_get(chunk, index))) continue;
+
+            bool column = node.channel == LIGHT_SKY && dir == DIR_DOWN && level == LIGHT_MAX;
+            uint32_t next = column ? LIGHT_MAX : level - 1;
+
+            if (get_level(chunk, index, node.channel) < next) {
+                set_level(light, chunk, index, node.channel, next);
+                queue_push(&light->add, chunk, index, node.channel, next);
+            }
+        }
+    }
+}
+
+
+//
+// Changes.
+//
+
+// Light a new chunk: sky columns, light sources, and light flowing in from its neighbours.
+static void seed_chunk (Lighting* light, Chunk* chunk) {
+    World* world = light->world;
+    chunk->lit = true;
+
+    Chunk* above = world_get_chunk(world, (Vec3i) {chunk->pos.i, chunk->pos.j + 1, chunk->pos.k});
+    if (above != NULL && !above->lit) above = NULL;
+    bool open = sky_above(world, chunk);
+
+    free(chunk->light);
+    chunk->light = NULL;
+    chunk->light_fill = 0;
+
+    bool solid = chunk_is_uniform(chunk) && block_is_opaque(chunk_get(chunk, 0));
+    if (!solid) {
+        uint8_t* cells = malloc(CHUNK_VOLUME);
+
+        // Sky Columns (no light sources in them).
+        for (int32_t z = 0; z < CHUNK_SIZE; z++) {
+            for (int32_t x = 0; x < CHUNK_SIZE; x++) {
+                uint32_t sky = open ? LIGHT_MAX : 0;
+                if (above != NULL) sky = get_level(above, chunk_index(x, 0, z), LIGHT_SKY);
+                if (sky < LIGHT_MAX) sky = 0;
+
+                for (int32_t y = CHUNK_MASK; y >= 0; y--) {
+                    uint32_t index = chunk_index(x, y, z);
+                    if (sky > 0 && block_is_opaque(chunk_get(chunk, index))) sky = 0;
+                    cells[index] = sky << 4;
+                }
+            }
+        }
+
+        // Uniform light needs no cells.
+        bool uniform = chunk_is_uniform(chunk);
+        for (uint32_t i = 1; i < CHUNK_VOLUME && uniform; i++) uniform = cells[i] == cells[0];
+
+        if (uniform && block_emission(chunk_get(chunk, 0)) == 0) {
+            chunk->light_fill = cells[0];
+            free(cells);
+        } else {
+            chunk->light = cells;
+        }
+
+        // Light Sources.
+        if (!chunk_is_uniform(chunk) || block_emission(chunk_get(chunk, 0)) > 0) {
+            for (uint32_t i = 0; i < CHUNK_VOLUME; i++) {
+                uint32_t emission = block_emission(chunk_get(chunk, i));
+                if (emission > 0) chunk->light[i] = (chunk->light[i] & 0xF0) | emission;
+            }
+        }
+
+        // Spread from every lit cell (only the borders of uniform light, the inside is settled).
+        for (uint32_t i = 0; i < CHUNK_VOLUME; i++) {
+            uint8_t cell = chunk_get_light(chunk, i);
+            if (cell == 0) continue;
+
+            if (chunk->light == NULL) {
+                uint32_t x = i & CHUNK_MASK, z = (i >> CHUNK_BITS) & CHUNK_MASK, y = i >> (2 * CHUNK_BITS);
+                bool border = x == 0 || x == CHUNK_MASK || y == 0 || y == CHUNK_MASK || z == 0 || z == CHUNK_MASK;
+                if (!border) continue;
+            }
+
+            if (cell >> 4) queue_push(&light->add, chunk, i, LIGHT_SKY, cell >> 4);
+            if (cell & LIGHT_MAX) queue_push(&light->add, chunk, i, LIGHT_BLOCK, cell & LIGHT_MAX);
+        }
+    }
+
+    light->cells += CHUNK_VOLUME;
+    touch(light, chunk);
+
+    // Neighbours: their light flows in, and the chunk below loses the open sky it had.
+    for (uint32_t dir = 0; dir < 6; dir++) {
+        Vec3i pos = {chunk->pos.i + offsets[dir][0], chunk->pos.j + offsets[dir][1], chunk->pos.k + offsets[dir][2]};
+        Chunk* other = world_get_chunk(world, pos);
+        if (other == NULL || !other->lit) continue;
+        touch(light, other);
+
+        uint32_t d = dir >> 1;
+        uint32_t u = (d + 1) % 3;
+        uint32_t v = (d + 2) % 3;
+
+        for (int32_t j = 0; j < CHUNK_SIZE; j++) {
+            for (int32_t i = 0; i < CHUNK_SIZE; i++) {
+                // Facing cells: 'inner' in this chunk, 'outer' in the neighbour.
+                int32_t c[3];
+                c[d] = (dir & 1) ? CHUNK_MASK : 0;
+                c[u] = i;
+                c[v] = j;
+                uint32_t inner = chunk_index(c[0], c[1], c[2]);
+                c[d] = CHUNK_MASK - c[d];
+                uint32_t outer = chunk_index(c[0], c[1], c[2]);
+
+                if (dir == DIR_DOWN && get_level(other, outer, LIGHT_SKY) == LIGHT_MAX &&
+                    get_level(chunk, inner, LIGHT_SKY) < LIGHT_MAX) {
+                    set_level(light, other, outer, LIGHT_SKY, 0);
+                    queue_push(&light->remove, other, outer, LIGHT_SKY, LIGHT_MAX);
+                }
+
+                uint8_t cell = chunk_get_light(other, outer);
+                if (cell >> 4) queue_push(&light->add, other, outer, LIGHT_SKY, cell >> 4);
+                if (cell & LIGHT_MAX) queue_push(&light->add, other, outer, LIGHT_BLOCK, cell & LIGHT_MAX);
+            }
+        }
+    }
+}
+
+// Relight around a changed block.
+static void edit_block (Lighting* light, Vec3i p) {
+    World* world = light->world;
+    Chunk* chunk = world_get_chunk(world, chunk_coords(p.i, p.j, p.k));
+    if (chunk == NULL || !chunk->lit) return;
+
+    uint32_t index = chunk_index(p.i, p.j, p.k);
+    uint16_t block = chunk_get(chunk, index);
+
+    // Darken the cell (and whatever it lit).
+    for (uint32_t channel = 0; channel < 2; channel++) {
+        uint32_t level = get_level(chunk, index, channel);
+        if (level == 0) continue;
+        set_level(light, chunk, index, channel, 0);
+        queue_push(&light->remove, chunk, index, channel, level);
+    }
+
+    uint32_t emission = block_emission(block);
+    if (emission > 0) {
+        set_level(light, chunk, index, LIGHT_BLOCK, emission);
+        queue_push(&light->add, chunk, index, LIGHT_BLOCK, emission);
+    }
+
+    if (block_is_opaque(block)) return;
+
+    // Let the neighbours' light back in.
+    for (uint32_t dir = 0; dir < 6; dir++) {
+        uint32_t next;
+        Chunk* other = neighbour(world, chunk, index, dir, &next);
+        if (other == NULL) {
+            if (dir == DIR_UP && (index >> (2 * CHUNK_BITS)) == CHUNK_MASK && sky_above(world, chunk)) {
+                set_level(light, chunk, index, LIGHT_SKY, LIGHT_MAX);
+                queue_push(&light->add, chunk, index, LIGHT_SKY, LIGHT_MAX);
+            }
+            continue;
+        }
+
+        uint8_t cell = chunk_get_light(other, next);
+        if (cell >> 4) queue_push(&light->add, other, next, LIGHT_SKY, cell >> 4);
+        if (cell & LIGHT_MAX) queue_push(&light->add, other, next, LIGHT_BLOCK, cell & LIGHT_MAX);
+    }
+}
+
+// Highest chunks first, so every chunk sees the sky light of the one above.
+static int compare_height (const void* a, const void* b) {
+    int32_t ja = ((const Vec3i*) a)->j;
+    int32_t jb = ((const Vec3i*) b)->j;
+    return (jb > ja) - (jb < ja);
+}
+
+static void light_main (void* arg) {
+    Lighting* light = arg;
+    World* world = light->world;
+    light->cells = 0;
+
+    qsort(light->job_loads, light->job_load_count, sizeof(Vec3i), compare_height);
+    for (uint32_t i = 0; i < light->job_load_count; i++) {
+        Chunk* chunk = world_get_chunk(world, light->job_loads[i]);
+        if (chunk != NULL && !chunk->lit) seed_chunk(light, chunk);
+    }
+
+    for (uint32_t i = 0; i < light->job_edit_count; i++) {
+        edit_block(light, light->job_edits[i]);
+    }
+
+    propagate_removal(light);
+    propagate_add(light);
+}
+
+void light_dispatch (Lighting* light) {
+    if (light->running) return;
+    if (light->edit_count == 0 && light->load_count == 0) return;
+
+    // Hand the queued changes to the job.
+    Vec3i* edits = light->job_edits;
+    uint32_t edit_capacity = light->job_edit_capacity;
+    light->job_edits = light->edits;
+    light->job_edit_count = light->edit_count;
+    light->job_edit_capacity = light->edit_capacity;
+    light->edits = edits;
+    light->edit_count = 0;
+    light->edit_capacity = edit_capacity;
+
+    Vec3i* loads = light->job_loads;
+    uint32_t load_capacity = light->job_load_capacity;
+    light->job_loads = light->loads;
+    light->job_load_count = light->load_count;
+    light->job_load_capacity = light->load_capacity;
+    light->loads = loads;
+    light->load_count = 0;
+    light->load_capacity = load_capacity;
+
+    light->running = true;
+    jobs_submit(light->jobs, light_main, light, JOB_HIGH, light->pending);
+}
+
+void light_wait (Lighting* light) {
+    if (!light->running) return;
+
+    jobs_wait(light->jobs, light->pending);
+    light->running = false;
+
+    // Remesh what changed.
+    for (uint32_t i = 0; i < light->touched_count; i++) {
+        Chunk* chunk = light->touched[i];
+        chunk->version++;
+        chunk->light_dirty = false;
+    }
+    light->chunks = light->touched_count;
+    light->touched_count = 0;
+
+    // Done chunks can be meshed again.
+    for (uint32_t i = 0; i < light->job_load_count; i++) {
+        Chunk* chunk = world_get_chunk(light->world, light->job_loads[i]);
+        if (chunk != NULL) chunk->light_queued = false;
+    }
+    for (uint32_t i = 0; i < light->job_edit_count; i++) {
+        Vec3i p = light->job_edits[i];
+        Chunk* chunk = world_get_chunk(light->world, chunk_coords(p.i, p.j, p.k));
+        if (chunk != NULL) chunk->light_queued = false;
+    }
+    light->job_load_count = 0;
+    light->job_edit_count = 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "main.h"
+
+// VOXEL LIGHTING
+//
+// - Every cell has two light levels (0..15), kept in one byte per cell (chunk->light):
+//     - Block light (low nibble), emitted by blocks like torches, one level less per step.
+//     - Sky light (high nibble), falling straight down at full strength through
+//       transparent blocks, one level less per step in any other direction.
+// - Changes are incremental flood fills (breadth first), touching only cells whose light
+//   actually changes:
+//     - Removal: cells lit by a changed cell are darkened, spreading while levels keep
+//       falling. Brighter cells on the edge are lit from elsewhere and go to the add queue.
+//     - Add: light spreads from queued cells to every neighbour more than one level darker.
+//   Both cross chunk borders. Missing (or not yet lit) chunks stop light, except that a
+//   missing chunk above counts as open sky. Removing a chunk doesn't relight its
+//   neighbours, they keep the light they had.
+// - world_set_block and new chunks queue their changes here (see world.h). One job works
+//   through them, between light_dispatch and light_wait. While it runs nothing may edit the
+//   world or read light: the environment runs it during env_draw, after chunkrender_update
+//   has taken its snapshots, and waits at the start of the next env_update.
+// - light_wait bumps the version of every chunk whose light changed (and of neighbours
+//   sharing a changed border cell), so meshes pick up the new light.
+// - Chunks with queued changes aren't meshed until their light is done (chunk->light_queued),
+//   so an edit or a new chunk is meshed once, not once before and once after lighting.
+
+#define LIGHT_MAX 15
+
+enum light_channel {
+    LIGHT_BLOCK = 0,
+    LIGHT_SKY = 1,
+};
+
+// Queued cell (add queue), or cell with the level it had (removal queue).
+struct light_node {
+    Chunk* chunk;
+    uint16_t index;
+    uint8_t channel;
+    uint8_t level;
+};
+
+struct light_queue {
+    struct light_node* nodes;
+    uint32_t head;
+    uint32_t size;
+    uint32_t capacity;
+};
+
+struct lighting {
+    World* world;
+    JobPool* jobs;
+
+    // Queued Changes (main thread), and the ones the running job works on.
+    Vec3i* edits;               // Blocks.
+    Vec3i* loads;               // Chunks.
+    uint32_t edit_count, edit_capacity;
+    uint32_t load_count, load_capacity;
+
+    Vec3i* job_edits;
+    Vec3i* job_loads;
+    uint32_t job_edit_count, job_edit_capacity;
+    uint32_t job_load_count, job_load_capacity;
+
+    // Flood Fill Queues (job only).
+    struct light_queue add;
+    struct light_queue remove;
+
+    // Chunks whose light changed (job only, until light_wait).
+    Chunk** touched;
+    uint32_t touched_count;
+    uint32_t touched_capacity;
+
+    JobCounter* pending;
+    bool running;
+
+    // Statistics (last job).
+    uint32_t cells;             // Cell levels changed.
+    uint32_t chunks;            // Chunks touched.
+};
+
+// Create and Destroy Lighting (attaches to the world, world->light).
+//  - light_destroy waits for a running job, and must come before the world's destruction.
+Lighting* light_create (World* world, JobPool* jobs);
+void light_destroy (Lighting* light);
+
+// Queue Changes (called by world.c).
+void light_queue_block (Lighting* light, Chunk* chunk, int32_t x, int32_t y, int32_t z);
+void light_queue_chunk (Lighting* light, Chunk* chunk);
+
+// Start a job for the queued changes (nothing if none), and wait for it.
+void light_dispatch (Lighting* light);
+void light_wait (Lighting* light);
@@ -9,6 +9,11 @@ int main (int argc, char** argv) {
     window_grab_mouse(window, true);
 
     Environment* env = env_create(window);
+    if (env == NULL) {
+        window_destroy(window);
+        window_terminate_backend();
+        return 1;
+    }
 
     while (window_get_state(window)) {
         window_run_events(window);
@@ -12,26 +12,54 @@
 
 #include "vector.h"
 #include "matrix.h"
+#include "fmath.h"
 
 //
 // Type Listing.
 //
 typedef struct array Array;
+typedef struct job_pool JobPool;
+typedef struct job_counter JobCounter;
 
 typedef struct window Window;
 typedef struct shader Shader;
 typedef struct shape Shape;
 typedef struct image Image;
+typedef struct atlas Atlas;
+typedef struct imageloader ImageLoader;
 typedef struct drawinfo DrawInfo;
 typedef struct vertexbuffer VertexBuffer;
+typedef struct streambuffer StreamBuffer;
+typedef struct stream_range StreamRange;
+typedef struct mesh Mesh;
+typedef struct mesh_cache MeshCache;
 
 typedef struct environment Environment;
 typedef struct input_state InputState;
 
 typedef struct entity Entity;
 typedef struct entity_type EntityType;
+typedef struct bvh Bvh;
+typedef struct ray_hit RayHit;
+typedef struct physics Physics;
+typedef struct flock Flock;
 typedef struct message Message;
 
+typedef struct world World;
+typedef struct chunk Chunk;
+typedef struct world_stats WorldStats;
+typedef struct chunk_mesh ChunkMesh;
+typedef struct chunk_draw ChunkDraw;
+typedef struct chunk_renderer ChunkRenderer;
+typedef struct streamer Streamer;
+typedef struct region Region;
+typedef struct region_store RegionStore;
+typedef struct saved_entity SavedEntity;
+typedef struct saved_entities SavedEntities;
+typedef struct terrain Terrain;
+typedef struct block_hit BlockHit;
+typedef struct lighting Lighting;
+
 typedef struct player Player;
 typedef struct orb Orb;
 
@@ -49,6 +77,11 @@ typedef struct orb Orb;
 #define IN_SHIFT 340
 #define IN_ESC 256
 
+#define IMAGE_UPLOAD_BUDGET (1024*1024)
+#define CHUNK_UPLOAD_BUDGET (512*1024)
+
+#define WORLD_SEED 1337
+
 #define SPEED 0.03
 #define SENSITIVITY 0.0003
 
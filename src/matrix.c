@@ -0,0 +1,516 @@
+#include "main.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// All kernels work on the raw storage, as four "lanes" of four floats
+// (rows when row-major, columns when column-major).
+//
+//  - mul_raw computes out.lane[i] = sum_k x.lane[i][k] * y.lane[k], which is
+//    x*y for row-major storage. Column-major storage is the transpose, so the
+//    same kernel computes a*b there with the arguments swapped.
+//  - Transpose and inverse commute with transposition, so they don't care.
+
+#ifdef MATRIX_ROW_MAJOR
+#define MUL_ARGS(a, b) (a), (b)
+#else
+#define MUL_ARGS(a, b) (b), (a)
+#endif
+
+
+//
+// Scalar Reference.
+//
+
+static void mul_raw_scalar (float* out, const float* x, const float* y) {
+    float r[16];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            r[4*i+j] = x[4*i+0] * y[0+j]
+                     + x[4*i+1] * y[4+j]
+                     + x[4*i+2] * y[8+j]
+                     + x[4*i+3] * y[12+j];
+        }
+    }
+    memcpy(out, r, sizeof(r));
+}
+
+void mat4f_mul_scalar (Mat4f* out, const Mat4f* a, const Mat4f* b) {
+    mul_raw_scalar((float*) out, MUL_ARGS((const float*) a, (const float*) b));
+}
+
+void mat4f_transpose_scalar (Mat4f* out, const Mat4f* m) {
+    const float* s = (const float*) m;
+    float r[16];
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            r[4*j+i] = s[4*i+j];
+        }
+    }
+    memcpy(out, r, sizeof(r));
+}
+
+bool mat4f_inverse_scalar (Mat4f* out, const Mat4f* mat) {
+    const float* m = (const float*) mat;
+    float inv[16];
+
+    inv[0]  =  m[5]*m[10]*m[15] - m[5]*m[11]*m[14] - m[9]*m[6]*m[15] + m[9]*m[7]*m[14] + m[13]*m[6]*m[11] - m[13]*m[7]*m[10];
+    inv[4]  = -m[4]*m[10]*m[15] + m[4]*m[11]*m[14] + m[8]*m[6]*m[15] - m[8]*m[7]*m[14] - m[12]*m[6]*m[11] + m[12]*m[7]*m[10];
+    inv[8]  =  m[4]*m[9]*m[15]  - m[4]*m[11]*m[13] - m[8]*m[5]*m[15] + m[8]*m[7]*m[13] + m[12]*m[5]*m[11] - m[12]*m[7]*m[9];
+    inv[12] = -m[4]*m[9]*m[14]  + m[4]*m[10]*m[13] + m[8]*m[5]*m[14] - m[8]*m[6]*m[13] - m[12]*m[5]*m[10] + m[12]*m[6]*m[9];
+    inv[1]  = -m[1]*m[10]*m[15] + m[1]*m[11]*m[14] + m[9]*m[2]*m[15] - m[9]*m[3]*m[14] - m[13]*m[2]*m[11] + m[13]*m[3]*m[10];
+    inv[5]  =  m[0]*m[10]*m[15] - m[0]*m[11]*m[14] - m[8]*m[2]*m[15] + m[8]*m[3]*m[14] + m[12]*m[2]*m[11] - m[12]*m[3]*m[10];
+    inv[9]  = -m[0]*m[9]*m[15]  + m[0]*m[11]*m[13] + m[8]*m[1]*m[15] - m[8]*m[3]*m[13] - m[12]*m[1]*m[11] + m[12]*m[3]*m[9];
+    inv[13] =  m[0]*m[9]*m[14]  - m[0]*m[10]*m[13] - m[8]*m[1]*m[14] + m[8]*m[2]*m[13] + m[12]*m[1]*m[10] - m[12]*m[2]*m[9];
+    inv[2]  =  m[1]*m[6]*m[15]  - m[1]*m[7]*m[14]  - m[5]*m[2]*m[15] + m[5]*m[3]*m[14] + m[13]*m[2]*m[7]  - m[13]*m[3]*m[6];
+    inv[6]  = -m[0]*m[6]*m[15]  + m[0]*m[7]*m[14]  + m[4]*m[2]*m[15] - m[4]*m[3]*m[14] - m[12]*m[2]*m[7]  + m[12]*m[3]*m[6];
+    inv[10] =  m[0]*m[5]*m[15]  - m[0]*m[7]*m[13]  - m[4]*m[1]*m[15] + m[4]*m[3]*m[13] + m[12]*m[1]*m[7]  - m[12]*m[3]*m[5];
+    inv[14] = -m[0]*m[5]*m[14]  + m[0]*m[6]*m[13]  + m[4]*m[1]*m[14] - m[4]*m[2]*m[13] - m[12]*m[1]*m[6]  + m[12]*m[2]*m[5];
+    inv[3]  = -m[1]*m[6]*m[11]  + m[1]*m[7]*m[10]  + m[5]*m[2]*m[11] - m[5]*m[3]*m[10] - m[9]*m[2]*m[7]   + m[9]*m[3]*m[6];
+    inv[7]  =  m[0]*m[6]*m[11]  - m[0]*m[7]*m[10]  - m[4]*m[2]*m[11] + m[4]*m[3]*m[10] + m[8]*m[2]*m[7]   - m[8]*m[3]*m[6];
+    inv[11] = -m[0]*m[5]*m[11]  + m[0]*m[7]*m[9]   + m[4]*m[1]*m[11] - m[4]*m[3]*m[9]  - m[8]*m[1]*m[7]   + m[8]*m[3]*m[5];
+    inv[15] =  m[0]*m[5]*m[10]  - m[0]*m[6]*m[9]   - m[4]*m[1]*m[10] + m[4]*m[2]*m[9]  + m[8]*m[1]*m[6]   - m[8]*m[2]*m[5];
+
+    float det = m[0]*inv[0] + m[1]*inv[4] + m[2]*inv[8] + m[3]*inv[12];
+    if (det == 0) return false;
+
+    float r = 1.0f / det;
+    for (int i = 0; i < 16; i++) {
+        inv[i] *= r;
+    }
+    memcpy(out, inv, sizeof(inv));
+
+    return true;
+}
+
+
+//
+// SSE/AVX Kernels.
+//
+
+#if defined(__SSE2__)
+
+#define SHUFFLE_MASK(x,y,z,w)   ((x) | ((y)<<2) | ((z)<<4) | ((w)<<6))
+#define SWIZZLE(v, x,y,z,w)     _mm_castsi128_ps(_mm_shuffle_epi32(_mm_castps_si128(v), SHUFFLE_MASK(x,y,z,w)))
+#define SWIZZLE1(v, x)          SWIZZLE(v, x,x,x,x)
+#define SHUFFLE(a, b, x,y,z,w)  _mm_shuffle_ps(a, b, SHUFFLE_MASK(x,y,z,w))
+
+// 2x2 row-major blocks packed as (x00, x01, x10, x11).
+
+// A*B
+static inline __m128 mat2_mul (__m128 a, __m128 b) {
+    return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0,3,0,3)),
+                      _mm_mul_ps(SWIZZLE(a, 1,0,3,2), SWIZZLE(b, 2,1,2,1)));
+}
+
+// adj(A)*B
+static inline __m128 mat2_adj_mul (__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3,3,0,0), b),
+                      _mm_mul_ps(SWIZZLE(a, 1,1,2,2), SWIZZLE(b, 2,3,0,1)));
+}
+
+// A*adj(B)
+static inline __m128 mat2_mul_adj (__m128 a, __m128 b) {
+    return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3,0,3,0)),
+                      _mm_mul_ps(SWIZZLE(a, 1,0,3,2), SWIZZLE(b, 2,1,2,1)));
+}
+
+static void mul_raw (float* out, const float* x, const float* y) {
+    __m128 y0 = _mm_load_ps(y);
+    __m128 y1 = _mm_load_ps(y + 4);
+    __m128 y2 = _mm_load_ps(y + 8);
+    __m128 y3 = _mm_load_ps(y + 12);
+
+#if defined(__AVX__)
+    // Two lanes per iteration (Mat4f is only 16-byte aligned, so unaligned 256-bit access).
+    __m256 yy0 = _mm256_set_m128(y0, y0);
+    __m256 yy1 = _mm256_set_m128(y1, y1);
+    __m256 yy2 = _mm256_set_m128(y2, y2);
+    __m256 yy3 = _mm256_set_m128(y3, y3);
+
+    for (int i = 0; i < 16; i += 8) {
+        __m256 xx = _mm256_loadu_ps(x + i);
+        __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(xx, xx, 0x00), yy0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(xx, xx, 0x55), yy1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(xx, xx, 0xAA), yy2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(xx, xx, 0xFF), yy3));
+        _mm256_storeu_ps(out + i, r);
+    }
+#else
+    for (int i = 0; i < 16; i += 4) {
+        __m128 xi = _mm_load_ps(x + i);
+        __m128 r = _mm_mul_ps(SWIZZLE1(xi, 0), y0);
+        r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE1(xi, 1), y1));
+        r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE1(xi, 2), y2));
+        r = _mm_add_ps(r, _mm_mul_ps(SWIZZLE1(xi, 3), y3));
+        _mm_store_ps(out + i, r);
+    }
+#endif
+}
+
+void mat4f_mul (Mat4f* out, const Mat4f* a, const Mat4f* b) {
+    mul_raw((float*) out, MUL_ARGS((const float*) a, (const float*) b));
+}
+
+void mat4f_transpose (Mat4f* out, const Mat4f* m) {
+    const float* s = (const float*) m;
+    __m128 r0 = _mm_load_ps(s);
+    __m128 r1 = _mm_load_ps(s + 4);
+    __m128 r2 = _mm_load_ps(s + 8);
+    __m128 r3 = _mm_load_ps(s + 12);
+
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+    float* d = (float*) out;
+    _mm_store_ps(d, r0);
+    _mm_store_ps(d + 4, r1);
+    _mm_store_ps(d + 8, r2);
+    _mm_store_ps(d + 12, r3);
+}
+
+// Block-wise inverse using 2x2 sub-matrices:
+//
+//    M = | A B |   inv(M) = 1/|M| * | X Y |
+//        | C D |                    | Z W |
+bool mat4f_inverse (Mat4f* out, const Mat4f* mat) {
+    const float* m = (const float*) mat;
+    __m128 m0 = _mm_load_ps(m);
+    __m128 m1 = _mm_load_ps(m + 4);
+    __m128 m2 = _mm_load_ps(m + 8);
+    __m128 m3 = _mm_load_ps(m + 12);
+
+    // Sub-Matrices.
+    __m128 A = _mm_movelh_ps(m0, m1);
+    __m128 B = _mm_movehl_ps(m1, m0);
+    __m128 C = _mm_movelh_ps(m2, m3);
+    __m128 D = _mm_movehl_ps(m3, m2);
+
+    // Sub-Determinants (|A|, |B|, |C|, |D|).
+    __m128 det_sub = _mm_sub_ps(
+        _mm_mul_ps(SHUFFLE(m0, m2, 0,2,0,2), SHUFFLE(m1, m3, 1,3,1,3)),
+        _mm_mul_ps(SHUFFLE(m0, m2, 1,3,1,3), SHUFFLE(m1, m3, 0,2,0,2))
+    );
+    __m128 det_a = SWIZZLE1(det_sub, 0);
+    __m128 det_b = SWIZZLE1(det_sub, 1);
+    __m128 det_c = SWIZZLE1(det_sub, 2);
+    __m128 det_d = SWIZZLE1(det_sub, 3);
+
+    __m128 d_c = mat2_adj_mul(D, C);
+    __m128 a_b = mat2_adj_mul(A, B);
+
+    __m128 X = _mm_sub_ps(_mm_mul_ps(det_d, A), mat2_mul(B, d_c));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(det_a, D), mat2_mul(C, a_b));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(det_b, C), mat2_mul_adj(D, a_b));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(det_c, B), mat2_mul_adj(A, d_c));
+
+    // |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+    __m128 det = _mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c));
+    __m128 tr = _mm_mul_ps(a_b, SWIZZLE(d_c, 0,2,1,3));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 2,3,0,1));
+    tr = _mm_add_ps(tr, SWIZZLE(tr, 1,0,3,2));
+    det = _mm_sub_ps(det, tr);
+
+    if (_mm_cvtss_f32(det) == 0) return false;
+
+    __m128 r_det = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+    X = _mm_mul_ps(X, r_det);
+    Y = _mm_mul_ps(Y, r_det);
+    Z = _mm_mul_ps(Z, r_det);
+    W = _mm_mul_ps(W, r_det);
+
+    // Adjugate + store.
+    float* d = (float*) out;
+    _mm_store_ps(d,      SHUFFLE(X, Y, 3,1,3,1));
+    _mm_store_ps(d + 4,  SHUFFLE(X, Y, 2,0,2,0));
+    _mm_store_ps(d + 8,  SHUFFLE(Z, W, 3,1,3,1));
+    _mm_store_ps(d + 12, SHUFFLE(Z, W, 2,0,2,0));
+
+    return true;
+}
+
+#else
+
+void mat4f_mul (Mat4f* out, const Mat4f* a, const Mat4f* b) {
+    mat4f_mul_scalar(out, a, b);
+}
+
+void mat4f_transpose (Mat4f* out, const Mat4f* m) {
+    mat4f_transpose_scalar(out, m);
+}
+
+bool mat4f_inverse (Mat4f* out, const Mat4f* m) {
+    return mat4f_inverse_scalar(out, m);
+}
+
+#endif
+
+
+//
+// Affine Inverse.
+//  - Only a 3x3 inverse and one product, SIMD doesn't pay off here.
+//
+
+bool mat4f_inverse_affine (Mat4f* out, const Mat4f* m) {
+    float c0 = m->by*m->cz - m->cy*m->bz;
+    float c1 = m->cy*m->az - m->ay*m->cz;
+    float c2 = m->ay*m->bz - m->by*m->az;
+
+    float det = m->ax*c0 + m->bx*c1 + m->cx*c2;
+    if (det == 0) return false;
+    float r = 1.0f / det;
+
+    float ax = c0 * r;
+    float bx = (m->cx*m->bz - m->bx*m->cz) * r;
+    float cx = (m->bx*m->cy - m->cx*m->by) * r;
+    float ay = c1 * r;
+    float by = (m->ax*m->cz - m->cx*m->az) * r;
+    float cy = (m->cx*m->ay - m->ax*m->cy) * r;
+    float az = c2 * r;
+    float bz = (m->bx*m->az - m->ax*m->bz) * r;
+    float cz = (m->ax*m->by - m->bx*m->ay) * r;
+
+    float tx = m->dx, ty = m->dy, tz = m->dz;
+
+    *out = mat4f_rows(
+        ax, bx, cx, -(ax*tx + bx*ty + cx*tz),
+        ay, by, cy, -(ay*tx + by*ty + cy*tz),
+        az, bz, cz, -(az*tx + bz*ty + cz*tz),
+        0,  0,  0,  1
+    );
+
+    return true;
+}
+
+
+//
+// Batch Transforms.
+//  - SSE works on 4 points at a time, AVX on 8, scalar for the tail.
+//  - AoS input is de-interleaved into x/y/z registers (4 Vec3f = 3 loads).
+//
+
+#if defined(__SSE2__)
+
+// Matrix elements, broadcast.
+struct bcast4 {
+    __m128 ax, bx, cx, dx;
+    __m128 ay, by, cy, dy;
+    __m128 az, bz, cz, dz;
+    __m128 aw, bw, cw, dw;
+};
+
+static inline void bcast4_init (struct bcast4* b, const Mat4f* m) {
+    b->ax = _mm_set1_ps(m->ax); b->bx = _mm_set1_ps(m->bx); b->cx = _mm_set1_ps(m->cx); b->dx = _mm_set1_ps(m->dx);
+    b->ay = _mm_set1_ps(m->ay); b->by = _mm_set1_ps(m->by); b->cy = _mm_set1_ps(m->cy); b->dy = _mm_set1_ps(m->dy);
+    b->az = _mm_set1_ps(m->az); b->bz = _mm_set1_ps(m->bz); b->cz = _mm_set1_ps(m->cz); b->dz = _mm_set1_ps(m->dz);
+    b->aw = _mm_set1_ps(m->aw); b->bw = _mm_set1_ps(m->bw); b->cw = _mm_set1_ps(m->cw); b->dw = _mm_set1_ps(m->dw);
+}
+
+// r = a*x + b*y + c*z (+ d).
+static inline __m128 row4 (__m128 a, __m128 b, __m128 c, __m128 x, __m128 y, __m128 z) {
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, x), _mm_mul_ps(b, y)), _mm_mul_ps(c, z));
+}
+
+// Load 4 Vec3f as x, y, z registers.
+static inline void load_aos4 (const Vec3f* in, __m128* x, __m128* y, __m128* z) {
+    const float* f = (const float*) in;
+    __m128 a = _mm_loadu_ps(f);        // x0 y0 z0 x1
+    __m128 b = _mm_loadu_ps(f + 4);    // y1 z1 x2 y2
+    __m128 c = _mm_loadu_ps(f + 8);    // z2 x3 y3 z3
+
+    *x = SHUFFLE(a, SHUFFLE(b, c, 2,2,1,1), 0,3,0,2);
+    *y = SHUFFLE(SHUFFLE(a, b, 1,1,0,0), SHUFFLE(b, c, 3,3,2,2), 0,2,0,2);
+    *z = SHUFFLE(SHUFFLE(a, b, 2,2,1,1), SHUFFLE(c, c, 0,0,3,3), 0,2,0,2);
+}
+
+// Store x, y, z registers as 4 Vec3f.
+static inline void store_aos4 (Vec3f* out, __m128 x, __m128 y, __m128 z) {
+    float* f = (float*) out;
+    _mm_storeu_ps(f,     SHUFFLE(SHUFFLE(x, y, 0,0,0,0), SHUFFLE(z, x, 0,0,1,1), 0,2,0,2));
+    _mm_storeu_ps(f + 4, SHUFFLE(SHUFFLE(y, z, 1,1,1,1), SHUFFLE(x, y, 2,2,2,2), 0,2,0,2));
+    _mm_storeu_ps(f + 8, SHUFFLE(SHUFFLE(z, x, 2,2,3,3), SHUFFLE(y, z, 3,3,3,3), 0,2,0,2));
+}
+
+static inline void transform4 (const struct bcast4* b, bool point, __m128* x, __m128* y, __m128* z) {
+    __m128 rx = row4(b->ax, b->bx, b->cx, *x, *y, *z);
+    __m128 ry = row4(b->ay, b->by, b->cy, *x, *y, *z);
+    __m128 rz = row4(b->az, b->bz, b->cz, *x, *y, *z);
+    if (point) {
+        rx = _mm_add_ps(rx, b->dx);
+        ry = _mm_add_ps(ry, b->dy);
+        rz = _mm_add_ps(rz, b->dz);
+    }
+    *x = rx; *y = ry; *z = rz;
+}
+
+#endif
+
+#if defined(__AVX__)
+
+struct bcast8 {
+    __m256 ax, bx, cx, dx;
+    __m256 ay, by, cy, dy;
+    __m256 az, bz, cz, dz;
+};
+
+static inline void bcast8_init (struct bcast8* b, const Mat4f* m) {
+    b->ax = _mm256_set1_ps(m->ax); b->bx = _mm256_set1_ps(m->bx); b->cx = _mm256_set1_ps(m->cx); b->dx = _mm256_set1_ps(m->dx);
+    b->ay = _mm256_set1_ps(m->ay); b->by = _mm256_set1_ps(m->by); b->cy = _mm256_set1_ps(m->cy); b->dy = _mm256_set1_ps(m->dy);
+    b->az = _mm256_set1_ps(m->az); b->bz = _mm256_set1_ps(m->bz); b->cz = _mm256_set1_ps(m->cz); b->dz = _mm256_set1_ps(m->dz);
+}
+
+#if defined(__FMA__)
+#define MADD8(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define MADD8(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+
+static inline void transform8 (const struct bcast8* b, bool point, __m256* x, __m256* y, __m256* z) {
+    __m256 zero = _mm256_setzero_ps();
+    __m256 rx = MADD8(b->cx, *z, MADD8(b->bx, *y, MADD8(b->ax, *x, point ? b->dx : zero)));
+    __m256 ry = MADD8(b->cy, *z, MADD8(b->by, *y, MADD8(b->ay, *x, point ? b->dy : zero)));
+    __m256 rz = MADD8(b->cz, *z, MADD8(b->bz, *y, MADD8(b->az, *x, point ? b->dz : zero)));
+    *x = rx; *y = ry; *z = rz;
+}
+
+#endif
+
+static void transform_aos (const Mat4f* m, const Vec3f* in, Vec3f* out, uint32_t count, bool point) {
+    uint32_t i = 0;
+
+#if defined(__AVX__)
+    struct bcast8 b8;
+    bcast8_init(&b8, m);
+    for (; i + 8 <= count; i += 8) {
+        __m128 x0, y0, z0, x1, y1, z1;
+        load_aos4(in + i, &x0, &y0, &z0);
+        load_aos4(in + i + 4, &x1, &y1, &z1);
+
+        __m256 x = _mm256_set_m128(x1, x0);
+        __m256 y = _mm256_set_m128(y1, y0);
+        __m256 z = _mm256_set_m128(z1, z0);
+        transform8(&b8, point, &x, &y, &z);
+
+        store_aos4(out + i, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+        store_aos4(out + i + 4, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+    }
+#endif
+
+#if defined(__SSE2__)
+    struct bcast4 b4;
+    bcast4_init(&b4, m);
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        load_aos4(in + i, &x, &y, &z);
+        transform4(&b4, point, &x, &y, &z);
+        store_aos4(out + i, x, y, z);
+    }
+#endif
+
+    // Tail.
+    for (; i < count; i++) {
+        out[i] = point ? mat4f_transform_point(m, in[i]) : mat4f_transform_dir(m, in[i]);
+    }
+}
+
+static void transform_soa (const Mat4f* m,
+                           const float* x, const float* y, const float* z,
+                           float* ox, float* oy, float* oz, uint32_t count, bool point) {
+    uint32_t i = 0;
+
+#if defined(__AVX__)
+    struct bcast8 b8;
+    bcast8_init(&b8, m);
+    for (; i + 8 <= count; i += 8) {
+        __m256 vx = _mm256_loadu_ps(x + i);
+        __m256 vy = _mm256_loadu_ps(y + i);
+        __m256 vz = _mm256_loadu_ps(z + i);
+        transform8(&b8, point, &vx, &vy, &vz);
+        _mm256_storeu_ps(ox + i, vx);
+        _mm256_storeu_ps(oy + i, vy);
+        _mm256_storeu_ps(oz + i, vz);
+    }
+#endif
+
+#if defined(__SSE2__)
+    struct bcast4 b4;
+    bcast4_init(&b4, m);
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        transform4(&b4, point, &vx, &vy, &vz);
+        _mm_storeu_ps(ox + i, vx);
+        _mm_storeu_ps(oy + i, vy);
+        _mm_storeu_ps(oz + i, vz);
+    }
+#endif
+
+    // Tail.
+    for (; i < count; i++) {
+        Vec3f v = cons3f(x[i], y[i], z[i]);
+        v = point ? mat4f_transform_point(m, v) : mat4f_transform_dir(m, v);
+        ox[i] = v.x;
+        oy[i] = v.y;
+        oz[i] = v.z;
+    }
+}
+
+void transform_points3f (const Mat4f* m, const Vec3f* in, Vec3f* out, uint32_t count) {
+    transform_aos(m, in, out, count, true);
+}
+
+void transform_dirs3f (const Mat4f* m, const Vec3f* in, Vec3f* out, uint32_t count) {
+    transform_aos(m, in, out, count, false);
+}
+
+void transform_points3f_soa (const Mat4f* m,
+                             const float* x, const float* y, const float* z,
+                             float* out_x, float* out_y, float* out_z, uint32_t count) {
+    transform_soa(m, x, y, z, out_x, out_y, out_z, count, true);
+}
+
+void transform_dirs3f_soa (const Mat4f* m,
+                           const float* x, const float* y, const float* z,
+                           float* out_x, float* out_y, float* out_z, uint32_t count) {
+    transform_soa(m, x, y, z, out_x, out_y, out_z, count, false);
+}
+
+void project_points (const Mat4f* m, const Vec3f* in, Vec4f* out, uint32_t count) {
+    uint32_t i = 0;
+
+#if defined(__SSE2__)
+    struct bcast4 b;
+    bcast4_init(&b, m);
+    for (; i + 4 <= count; i += 4) {
+        __m128 x, y, z;
+        load_aos4(in + i, &x, &y, &z);
+
+        __m128 cx = _mm_add_ps(row4(b.ax, b.bx, b.cx, x, y, z), b.dx);
+        __m128 cy = _mm_add_ps(row4(b.ay, b.by, b.cy, x, y, z), b.dy);
+        __m128 cz = _mm_add_ps(row4(b.az, b.bz, b.cz, x, y, z), b.dz);
+        __m128 cw = _mm_add_ps(row4(b.aw, b.bw, b.cw, x, y, z), b.dw);
+
+        __m128 r = _mm_div_ps(_mm_set1_ps(1.0f), cw);
+        cx = _mm_mul_ps(cx, r);
+        cy = _mm_mul_ps(cy, r);
+        cz = _mm_mul_ps(cz, r);
+
+        _MM_TRANSPOSE4_PS(cx, cy, cz, cw);
+        _mm_storeu_ps((float*) (out + i), cx);
+        _mm_storeu_ps((float*) (out + i + 1), cy);
+        _mm_storeu_ps((float*) (out + i + 2), cz);
+        _mm_storeu_ps((float*) (out + i + 3), cw);
+    }
+#endif
+
+    // Tail.
+    for (; i < count; i++) {
+        Vec4f c = mat4f_transform(m, cons4f(in[i].x, in[i].y, in[i].z, 1));
+        float r = 1.0f / c.w;
+        out[i] = cons4f(c.x * r, c.y * r, c.z * r, c.w);
+    }
+}
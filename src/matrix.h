@@ -1,5 +1,25 @@
 #pragma once
 
+#include <stdbool.h>
+
+#include "vector.h"
+
+/***
+ ***    Matrix-Math mini-Library.
+ ***        - Definitions for 2x2, 3x3 and 4x4 float matrices.
+ ***        - Mat4f operations, with SSE/AVX kernels (matrix.c) and scalar reference versions.
+ ***        - View frustum planes and box tests.
+ ***
+ ***    Fields are named by column (a,b,c,d) and row (x,y,z,w), so 'dx' is the
+ ***    x-component of the translation. Code should only use the field names or
+ ***    the constructors below, never positional initializers, because the storage
+ ***    order depends on MATRIX_ROW_MAJOR:
+ ***        - Default: column-major, uploads to GL need no transpose.
+ ***        - MATRIX_ROW_MAJOR: row-major, uploaded with transpose.
+ ***    MATRIX_UPLOAD_TRANSPOSE is the matching 'transpose' flag for glUniformMatrix4fv.
+ ***    Mat4f is 16-byte aligned, so every row (or column) is one SSE register.
+ ***/
+
 /*  Matrix-2x2 Definition.
  */
 typedef struct mat2f {
@@ -19,9 +39,221 @@ typedef struct mat3f {
 
 /*  Matrix-4x4f Definition.
  */
+#ifdef MATRIX_ROW_MAJOR
+#define MATRIX_UPLOAD_TRANSPOSE 1
 typedef struct mat4f {
+    _Alignas(16)
     float ax; float bx; float cx; float dx;
     float ay; float by; float cy; float dy;
     float az; float bz; float cz; float dz;
     float aw; float bw; float cw; float dw;
 } Mat4f;
+#else
+#define MATRIX_UPLOAD_TRANSPOSE 0
+typedef struct mat4f {
+    _Alignas(16)
+    float ax; float ay; float az; float aw;
+    float bx; float by; float bz; float bw;
+    float cx; float cy; float cz; float cw;
+    float dx; float dy; float dz; float dw;
+} Mat4f;
+#endif
+
+
+/*  Matrix Constructors.
+ *      - Arguments are given row by row, as the matrix reads on paper.
+ */
+static inline
+Mat4f mat4f_rows (float ax, float bx, float cx, float dx,
+                  float ay, float by, float cy, float dy,
+                  float az, float bz, float cz, float dz,
+                  float aw, float bw, float cw, float dw) {
+    Mat4f m;
+    m.ax = ax; m.bx = bx; m.cx = cx; m.dx = dx;
+    m.ay = ay; m.by = by; m.cy = cy; m.dy = dy;
+    m.az = az; m.bz = bz; m.cz = cz; m.dz = dz;
+    m.aw = aw; m.bw = bw; m.cw = cw; m.dw = dw;
+    return m;
+}
+
+static inline
+Mat4f mat4f_identity () {
+    return mat4f_rows(1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1);
+}
+
+static inline
+Mat4f mat4f_translate (Vec3f t) {
+    return mat4f_rows(1,0,0,t.x, 0,1,0,t.y, 0,0,1,t.z, 0,0,0,1);
+}
+
+static inline
+Mat4f mat4f_scale (Vec3f s) {
+    return mat4f_rows(s.x,0,0,0, 0,s.y,0,0, 0,0,s.z,0, 0,0,0,1);
+}
+
+/*  Rotation from a unit quaternion (x,y,z,w).
+ */
+static inline
+Mat4f mat4f_rotate (Vec4f q) {
+    float xx = q.x*q.x, yy = q.y*q.y, zz = q.z*q.z;
+    float xy = q.x*q.y, xz = q.x*q.z, yz = q.y*q.z;
+    float wx = q.w*q.x, wy = q.w*q.y, wz = q.w*q.z;
+
+    return mat4f_rows(
+        1 - 2*(yy+zz),  2*(xy-wz),      2*(xz+wy),      0,
+        2*(xy+wz),      1 - 2*(xx+zz),  2*(yz-wx),      0,
+        2*(xz-wy),      2*(yz+wx),      1 - 2*(xx+yy),  0,
+        0,              0,              0,              1
+    );
+}
+
+/*  Translation * Rotation * Scale, composed directly.
+ */
+static inline
+Mat4f mat4f_trs (Vec3f t, Vec4f q, Vec3f s) {
+    Mat4f m = mat4f_rotate(q);
+    m.ax *= s.x; m.ay *= s.x; m.az *= s.x;
+    m.bx *= s.y; m.by *= s.y; m.bz *= s.y;
+    m.cx *= s.z; m.cy *= s.z; m.cz *= s.z;
+    m.dx = t.x; m.dy = t.y; m.dz = t.z;
+    return m;
+}
+
+/*  View matrix looking from 'eye' towards 'center'.
+ */
+static inline
+Mat4f mat4f_lookat (Vec3f eye, Vec3f center, Vec3f up) {
+    Vec3f vz = normalize3f(sub3f(eye, center));
+    Vec3f vx = normalize3f(cross3f(up, vz));
+    Vec3f vy = normalize3f(cross3f(vz, vx));
+
+    return mat4f_rows(
+        vx.x,  vx.y, vx.z, -dot3f(vx, eye),
+        vy.x,  vy.y, vy.z, -dot3f(vy, eye),
+        vz.x,  vz.y, vz.z, -dot3f(vz, eye),
+        0,     0,    0,     1
+    );
+}
+
+/*  Perspective projection ('fovy' in radians).
+ */
+static inline
+Mat4f mat4f_perspective (float fovy, float aspect, float near, float far) {
+    float f = 1.0f / tanf(fovy / 2);
+    float d = far - near;
+
+    return mat4f_rows(
+        f/aspect,  0,  0,                 0,
+        0,         f,  0,                 0,
+        0,         0, -(far + near) / d, -2 * far * near / d,
+        0,         0, -1,                 0
+    );
+}
+
+
+/*  Matrix-Vector Products.
+ */
+static inline
+Vec4f mat4f_transform (const Mat4f* m, Vec4f v) {
+    return (Vec4f) {
+        m->ax*v.x + m->bx*v.y + m->cx*v.z + m->dx*v.w,
+        m->ay*v.x + m->by*v.y + m->cy*v.z + m->dy*v.w,
+        m->az*v.x + m->bz*v.y + m->cz*v.z + m->dz*v.w,
+        m->aw*v.x + m->bw*v.y + m->cw*v.z + m->dw*v.w,
+    };
+}
+
+static inline
+Vec3f mat4f_transform_point (const Mat4f* m, Vec3f p) {
+    return (Vec3f) {
+        m->ax*p.x + m->bx*p.y + m->cx*p.z + m->dx,
+        m->ay*p.x + m->by*p.y + m->cy*p.z + m->dy,
+        m->az*p.x + m->bz*p.y + m->cz*p.z + m->dz,
+    };
+}
+
+static inline
+Vec3f mat4f_transform_dir (const Mat4f* m, Vec3f d) {
+    return (Vec3f) {
+        m->ax*d.x + m->bx*d.y + m->cx*d.z,
+        m->ay*d.x + m->by*d.y + m->cy*d.z,
+        m->az*d.x + m->bz*d.y + m->cz*d.z,
+    };
+}
+
+
+/*  View Frustum.
+ *      - Six planes (a,b,c,d) taken from a projection * view matrix, facing inwards,
+ *        so a point p is inside a plane when a*p.x + b*p.y + c*p.z + d >= 0.
+ */
+typedef struct frustum {
+    Vec4f planes[6];
+} Frustum;
+
+static inline
+Frustum frustum_from_matrix (const Mat4f* m) {
+    Frustum f;
+    Vec4f x = {m->ax, m->bx, m->cx, m->dx};
+    Vec4f y = {m->ay, m->by, m->cy, m->dy};
+    Vec4f z = {m->az, m->bz, m->cz, m->dz};
+    Vec4f w = {m->aw, m->bw, m->cw, m->dw};
+
+    f.planes[0] = add4f(w, x);
+    f.planes[1] = sub4f(w, x);
+    f.planes[2] = add4f(w, y);
+    f.planes[3] = sub4f(w, y);
+    f.planes[4] = add4f(w, z);
+    f.planes[5] = sub4f(w, z);
+    return f;
+}
+
+/*  Conservative box test: false only if the box is fully outside one plane.
+ */
+static inline
+bool frustum_test_aabb (const Frustum* f, Vec3f min, Vec3f max) {
+    for (int i = 0; i < 6; i++) {
+        Vec4f p = f->planes[i];
+        float d = p.x * (p.x > 0 ? max.x : min.x)
+                + p.y * (p.y > 0 ? max.y : min.y)
+                + p.z * (p.z > 0 ? max.z : min.z) + p.w;
+        if (d < 0) return false;
+    }
+    return true;
+}
+
+
+/*  Matrix Kernels (matrix.c).
+ *      - 'out' may alias any input.
+ *      - The default versions use SSE (or AVX for mul) when compiled in.
+ */
+void mat4f_mul (Mat4f* out, const Mat4f* a, const Mat4f* b);
+void mat4f_transpose (Mat4f* out, const Mat4f* m);
+
+// General inverse, returns false (and leaves 'out' alone) if singular.
+bool mat4f_inverse (Mat4f* out, const Mat4f* m);
+
+// Inverse of an affine transform (last row 0,0,0,1), returns false if singular.
+bool mat4f_inverse_affine (Mat4f* out, const Mat4f* m);
+
+// Scalar Reference Versions.
+void mat4f_mul_scalar (Mat4f* out, const Mat4f* a, const Mat4f* b);
+void mat4f_transpose_scalar (Mat4f* out, const Mat4f* m);
+bool mat4f_inverse_scalar (Mat4f* out, const Mat4f* m);
+
+
+/*  Batch Transforms (matrix.c).
+ *      - Transform 'count' points or directions by one matrix.
+ *      - Arrays of Vec3f (AoS) or separate x/y/z streams (SoA), SoA is faster.
+ *      - 'out' may be the same array as 'in' (but not partially overlap).
+ *      - project_points writes (ndc.x, ndc.y, ndc.z, w): w <= 0 is behind the camera.
+ */
+void transform_points3f (const Mat4f* m, const Vec3f* in, Vec3f* out, uint32_t count);
+void transform_dirs3f (const Mat4f* m, const Vec3f* in, Vec3f* out, uint32_t count);
+void project_points (const Mat4f* m, const Vec3f* in, Vec4f* out, uint32_t count);
+
+void transform_points3f_soa (const Mat4f* m,
+                             const float* x, const float* y, const float* z,
+                             float* out_x, float* out_y, float* out_z, uint32_t count);
+void transform_dirs3f_soa (const Mat4f* m,
+                           const float* x, const float* y, const float* z,
+                           float* out_x, float* out_y, float* out_z, uint32_t count);
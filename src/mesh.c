@@ -0,0 +1,416 @@
+#include "mesh.h"
+
+#include "array.h"
+#include "render.h"
+
+
+struct mesh_entry {
+    uint32_t kind;
+    uint32_t a, b;
+    float f;
+
+    Shape* shape;
+};
+
+
+//
+// Mesh Building.
+//
+
+Mesh* mesh_create () {
+    // Allocate and Initialize.
+    Mesh* mesh = malloc(sizeof(Mesh));
+    mesh->capacity = 64;
+    mesh->vertices = malloc(mesh->capacity * 13 * sizeof(float));
+    mesh->size = 0;
+    mesh->index_capacity = 192;
+    mesh->indices = malloc(mesh->index_capacity * sizeof(uint32_t));
+    mesh->index_count = 0;
+    mesh->color = cons4f(1,1,1,1);
+
+    return mesh;
+}
+
+void mesh_destroy (Mesh* mesh) {
+    free(mesh->vertices);
+    free(mesh->indices);
+    free(mesh);
+}
+
+void mesh_clear (Mesh* mesh) {
+    mesh->size = 0;
+    mesh->index_count = 0;
+}
+
+// Make room for 'vertices' more vertices and 'indices' more indices.
+static void mesh_reserve (Mesh* mesh, uint32_t vertices, uint32_t indices) {
+    if (mesh->size + vertices > mesh->capacity) {
+        while (mesh->size + vertices > mesh->capacity) mesh->capacity *= 2;
+        mesh->vertices = realloc(mesh->vertices, mesh->capacity * 13 * sizeof(float));
+    }
+    if (mesh->index_count + indices > mesh->index_capacity) {
+        while (mesh->index_count + indices > mesh->index_capacity) mesh->index_capacity *= 2;
+        mesh->indices = realloc(mesh->indices, mesh->index_capacity * sizeof(uint32_t));
+    }
+}
+
+void mesh_color (Mesh* mesh, Vec4f color) {
+    mesh->color = color;
+}
+
+uint32_t mesh_vertex (Mesh* mesh, Vec3f pos, Vec2f texcoord, Vec3f normal) {
+    mesh_reserve(mesh, 1, 0);
+
+    float* v = mesh->vertices + mesh->size * 13;
+    v[0] = pos.x; v[1] = pos.y; v[2] = pos.z; v[3] = 1;
+    v[4] = texcoord.x; v[5] = texcoord.y;
+    v[6] = mesh->color.x; v[7] = mesh->color.y; v[8] = mesh->color.z; v[9] = mesh->color.w;
+    v[10] = normal.x; v[11] = normal.y; v[12] = normal.z;
+
+    return mesh->size++;
+}
+
+void mesh_triangle (Mesh* mesh, uint32_t a, uint32_t b, uint32_t c) {
+    mesh_reserve(mesh, 0, 3);
+
+    uint32_t* i = mesh->indices + mesh->index_count;
+    i[0] = a; i[1] = b; i[2] = c;
+    mesh->index_count += 3;
+}
+
+// Two triangles for the quad a-b-c-d (counter-clockwise).
+static void mesh_quad (Mesh* mesh, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    mesh_triangle(mesh, a, b, c);
+    mesh_triangle(mesh, a, c, d);
+}
+
+Shape* mesh_export (Mesh* mesh) {
+    return shape_create_indexed(mesh->vertices, mesh->size, mesh->indices, mesh->index_count, GL_TRIANGLES);
+}
+
+
+//
+// Generators.
+//
+
+static Vec2f sphere_texcoord (Vec3f n) {
+    return cons2f(0.5f + atan2f(n.x, n.z) / (float) TWO_PI, 0.5f + asinf(n.y) / (float) PI);
+}
+
+// Midpoint of edge (a,b) on the unit sphere, shared between both triangles of the edge.
+//  - 'edges' is an open-addressing table of (key, index) pairs, 'mask' + 1 entries.
+static uint32_t ico_midpoint (Mesh* mesh, uint64_t* edges, uint32_t mask, uint32_t base, uint32_t a, uint32_t b) {
+    uint32_t lo = a < b ? a : b;
+    uint32_t hi = a < b ? b : a;
+    uint64_t key = ((uint64_t) lo << 32 | hi) + 1;
+
+    uint32_t slot = (uint32_t) ((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (edges[slot*2] != 0) {
+        if (edges[slot*2] == key) return edges[slot*2 + 1];
+        slot = (slot + 1) & mask;
+    }
+
+    const float* va = mesh->vertices + (base + a) * 13;
+    const float* vb = mesh->vertices + (base + b) * 13;
+    Vec3f n = normalize3f(cons3f(va[0] + vb[0], va[1] + vb[1], va[2] + vb[2]));
+    uint32_t index = mesh_vertex(mesh, n, sphere_texcoord(n), n) - base;
+
+    edges[slot*2] = key;
+    edges[slot*2 + 1] = index;
+    return index;
+}
+
+static void gen_icosphere (Mesh* mesh, uint32_t level) {
+    // Icosahedron.
+    const float t = 1.6180339887f;
+    const float ico_vertices[12][3] = {
+        {-1, t, 0}, { 1, t, 0}, {-1,-t, 0}, { 1,-t, 0},
+        { 0,-1, t}, { 0, 1, t}, { 0,-1,-t}, { 0, 1,-t},
+        { t, 0,-1}, { t, 0, 1}, {-t, 0,-1}, {-t, 0, 1},
+    };
+    const uint32_t ico_faces[20][3] = {
+        {0,11,5}, {0,5,1}, {0,1,7}, {0,7,10}, {0,10,11},
+        {1,5,9}, {5,11,4}, {11,10,2}, {10,7,6}, {7,1,8},
+        {3,9,4}, {3,4,2}, {3,2,6}, {3,6,8}, {3,8,9},
+        {4,9,5}, {2,4,11}, {6,2,10}, {8,6,7}, {9,8,1},
+    };
+
+    // Final counts: F = 20*4^level, V = 10*4^level + 2.
+    uint32_t faces = 20u << (2*level);
+    uint32_t base = mesh->size;
+    mesh_reserve(mesh, faces/2 + 2, 0);
+
+    for (int i = 0; i < 12; i++) {
+        Vec3f n = normalize3f(cons3f(ico_vertices[i][0], ico_vertices[i][1], ico_vertices[i][2]));
+        mesh_vertex(mesh, n, sphere_texcoord(n), n);
+    }
+
+    // Subdivide (indices relative to 'base').
+    uint32_t count = 20;
+    uint32_t* tris = malloc(faces * 3 * sizeof(uint32_t));
+    uint32_t* next = malloc(faces * 3 * sizeof(uint32_t));
+    memcpy(tris, ico_faces, sizeof(ico_faces));
+
+    for (uint32_t l = 0; l < level; l++) {
+        // Table for the E = 3F/2 edges, at most half full.
+        uint32_t slots = 1;
+        while (slots < count * 3) slots *= 2;
+        uint64_t* edges = calloc(slots * 2, sizeof(uint64_t));
+
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t a = tris[i*3], b = tris[i*3 + 1], c = tris[i*3 + 2];
+            uint32_t ab = ico_midpoint(mesh, edges, slots - 1, base, a, b);
+            uint32_t bc = ico_midpoint(mesh, edges, slots - 1, base, b, c);
+            uint32_t ca = ico_midpoint(mesh, edges, slots - 1, base, c, a);
+
+            uint32_t* o = next + i*12;
+            o[0] = a;  o[1] = ab;  o[2] = ca;
+            o[3] = b;  o[4] = bc;  o[5] = ab;
+            o[6] = c;  o[7] = ca;  o[8] = bc;
+            o[9] = ab; o[10] = bc; o[11] = ca;
+        }
+
+        free(edges);
+
+        uint32_t* swap = tris;
+        tris = next;
+        next = swap;
+        count *= 4;
+    }
+
+    mesh_reserve(mesh, 0, count * 3);
+    for (uint32_t i = 0; i < count * 3; i++) {
+        mesh->indices[mesh->index_count++] = base + tris[i];
+    }
+
+    free(tris);
+    free(next);
+}
+
+// Sine/cosine table for 'segments' + 1 angles around the y-axis (seam duplicated).
+static void ring_table (uint32_t segments, float* s, float* c) {
+    for (uint32_t j = 0; j <= segments; j++) {
+        s[j] = j * (float) TWO_PI / segments;
+    }
+    fsincos_array(s, s, c, segments + 1);
+}
+
+// Rings of a sphere between pitch p0 and p1 (from -pi/2 to pi/2), offset along y.
+//  - Emits 'rings' + 1 rows of 'segments' + 1 vertices, and returns the first index.
+static uint32_t sphere_band (Mesh* mesh, uint32_t segments, uint32_t rings, float p0, float p1, float offset,
+                             const float* sy, const float* cy, float v0, float v1) {
+    uint32_t first = mesh->size;
+    mesh_reserve(mesh, (rings + 1) * (segments + 1), rings * segments * 6);
+
+    for (uint32_t i = 0; i <= rings; i++) {
+        float sp, cp;
+        fsincos(p0 + (p1 - p0) * i / rings, &sp, &cp);
+        float v = v0 + (v1 - v0) * i / rings;
+
+        for (uint32_t j = 0; j <= segments; j++) {
+            Vec3f n = cons3f(cp*sy[j], sp, cp*cy[j]);
+            mesh_vertex(mesh, cons3f(n.x, n.y + offset, n.z), cons2f((float) j / segments, v), n);
+        }
+    }
+
+    // Quads between rows, single triangles at the poles.
+    bool south = p0 <= -HALF_PI;
+    bool north = p1 >= HALF_PI;
+
+    for (uint32_t i = 0; i < rings; i++) {
+        uint32_t row0 = first + i * (segments + 1);
+        uint32_t row1 = row0 + segments + 1;
+        for (uint32_t j = 0; j < segments; j++) {
+            if (i == 0 && south) {
+                mesh_triangle(mesh, row0 + j, row1 + j + 1, row1 + j);
+            } else if (i == rings - 1 && north) {
+                mesh_triangle(mesh, row0 + j, row0 + j + 1, row1 + j + 1);
+            } else {
+                mesh_quad(mesh, row0 + j, row0 + j + 1, row1 + j + 1, row1 + j);
+            }
+        }
+    }
+
+    return first;
+}
+
+static void gen_uvsphere (Mesh* mesh, uint32_t segments, uint32_t rings) {
+    if (segments < 3) segments = 3;
+    if (rings < 2) rings = 2;
+
+    float sy[segments + 1], cy[segments + 1];
+    ring_table(segments, sy, cy);
+
+    sphere_band(mesh, segments, rings, -HALF_PI, HALF_PI, 0, sy, cy, 0, 1);
+}
+
+static void gen_capsule (Mesh* mesh, uint32_t segments, uint32_t rings, float half_height) {
+    if (segments < 3) segments = 3;
+    if (rings < 1) rings = 1;
+
+    float sy[segments + 1], cy[segments + 1];
+    ring_table(segments, sy, cy);
+
+    // Texture v runs over the whole length.
+    float length = 2 * half_height + (float) PI;
+    float v_bottom = (float) HALF_PI / length;
+    float v_top = 1 - v_bottom;
+
+    uint32_t bottom = sphere_band(mesh, segments, rings, -HALF_PI, 0, -half_height, sy, cy, 0, v_bottom);
+    uint32_t top = sphere_band(mesh, segments, rings, 0, HALF_PI, half_height, sy, cy, v_top, 1);
+
+    // Straight part between the two equators.
+    uint32_t row0 = bottom + rings * (segments + 1);
+    uint32_t row1 = top;
+    for (uint32_t j = 0; j < segments; j++) {
+        mesh_quad(mesh, row0 + j, row0 + j + 1, row1 + j + 1, row1 + j);
+    }
+}
+
+static void gen_cylinder (Mesh* mesh, uint32_t segments) {
+    if (segments < 3) segments = 3;
+
+    float sy[segments + 1], cy[segments + 1];
+    ring_table(segments, sy, cy);
+
+    // Side.
+    uint32_t side = mesh->size;
+    for (uint32_t j = 0; j <= segments; j++) {
+        Vec3f n = cons3f(sy[j], 0, cy[j]);
+        float u = (float) j / segments;
+        mesh_vertex(mesh, cons3f(n.x, -1, n.z), cons2f(u, 0), n);
+        mesh_vertex(mesh, cons3f(n.x, 1, n.z), cons2f(u, 1), n);
+    }
+    for (uint32_t j = 0; j < segments; j++) {
+        uint32_t i = side + j*2;
+        mesh_quad(mesh, i, i + 2, i + 3, i + 1);
+    }
+
+    // Caps.
+    for (int cap = -1; cap <= 1; cap += 2) {
+        Vec3f n = cons3f(0, cap, 0);
+        uint32_t center = mesh_vertex(mesh, n, cons2f(0.5f, 0.5f), n);
+        for (uint32_t j = 0; j < segments; j++) {
+            mesh_vertex(mesh, cons3f(sy[j], cap, cy[j]), cons2f(0.5f + 0.5f*sy[j], 0.5f + 0.5f*cy[j]), n);
+        }
+        for (uint32_t j = 0; j < segments; j++) {
+            uint32_t a = center + 1 + j;
+            uint32_t b = center + 1 + (j + 1) % segments;
+            if (cap > 0) mesh_triangle(mesh, center, a, b);
+            else mesh_triangle(mesh, center, b, a);
+        }
+    }
+}
+
+static void gen_box (Mesh* mesh) {
+    // Per face: normal, then the u and v axes (u x v = normal).
+    const float faces[6][9] = {
+        { 1, 0, 0,   0, 0,-1,   0, 1, 0},
+        {-1, 0, 0,   0, 0, 1,   0, 1, 0},
+        { 0, 1, 0,   1, 0, 0,   0, 0,-1},
+        { 0,-1, 0,   1, 0, 0,   0, 0, 1},
+        { 0, 0, 1,   1, 0, 0,   0, 1, 0},
+        { 0, 0,-1,  -1, 0, 0,   0, 1, 0},
+    };
+
+    for (int f = 0; f < 6; f++) {
+        Vec3f n = cons3f(faces[f][0], faces[f][1], faces[f][2]);
+        Vec3f u = cons3f(faces[f][3], faces[f][4], faces[f][5]);
+        Vec3f v = cons3f(faces[f][6], faces[f][7], faces[f][8]);
+
+        uint32_t first = mesh->size;
+        for (int k = 0; k < 4; k++) {
+            float du = (k == 1 || k == 2) ? 1 : -1;
+            float dv = (k >= 2) ? 1 : -1;
+            Vec3f p = add3f(n, add3f(scale3f(du, u), scale3f(dv, v)));
+            mesh_vertex(mesh, p, cons2f(0.5f + 0.5f*du, 0.5f + 0.5f*dv), n);
+        }
+        mesh_quad(mesh, first, first + 1, first + 2, first + 3);
+    }
+}
+
+static void gen_plane (Mesh* mesh, uint32_t nx, uint32_t nz) {
+    if (nx < 1) nx = 1;
+    if (nz < 1) nz = 1;
+
+    Vec3f n = cons3f(0, 1, 0);
+    uint32_t first = mesh->size;
+    mesh_reserve(mesh, (nx + 1) * (nz + 1), nx * nz * 6);
+
+    for (uint32_t i = 0; i <= nz; i++) {
+        for (uint32_t j = 0; j <= nx; j++) {
+            float u = (float) j / nx;
+            float v = (float) i / nz;
+            mesh_vertex(mesh, cons3f(2*u - 1, 0, 1 - 2*v), cons2f(u, v), n);
+        }
+    }
+
+    for (uint32_t i = 0; i < nz; i++) {
+        uint32_t row0 = first + i * (nx + 1);
+        uint32_t row1 = row0 + nx + 1;
+        for (uint32_t j = 0; j < nx; j++) {
+            mesh_quad(mesh, row0 + j, row0 + j + 1, row1 + j + 1, row1 + j);
+        }
+    }
+}
+
+void mesh_generate (Mesh* mesh, uint32_t kind, uint32_t a, uint32_t b, float f) {
+    switch (kind) {
+        case MESH_ICOSPHERE: gen_icosphere(mesh, a); break;
+        case MESH_UVSPHERE: gen_uvsphere(mesh, a, b); break;
+        case MESH_BOX: gen_box(mesh); break;
+        case MESH_CYLINDER: gen_cylinder(mesh, a); break;
+        case MESH_CAPSULE: gen_capsule(mesh, a, b, f); break;
+        case MESH_PLANE: gen_plane(mesh, a, b); break;
+    }
+}
+
+
+//
+// Mesh Cache.
+//
+
+MeshCache* meshcache_create () {
+    // Allocate and Initialize.
+    MeshCache* cache = malloc(sizeof(MeshCache));
+    cache->entries = array_create();
+
+    return cache;
+}
+
+static void entry_destroy (void* item) {
+    struct mesh_entry* entry = item;
+    shape_destroy(entry->shape);
+    free(entry);
+}
+
+void meshcache_destroy (MeshCache* cache) {
+    array_destroy_callback(cache->entries, entry_destroy);
+    free(cache);
+}
+
+Shape* meshcache_get (MeshCache* cache, uint32_t kind, uint32_t a, uint32_t b, float f) {
+    // Lookup.
+    for (int i = 0; i < cache->entries->size; i++) {
+        struct mesh_entry* entry = cache->entries->data[i];
+        if (entry->kind == kind && entry->a == a && entry->b == b && entry->f == f) {
+            return entry->shape;
+        }
+    }
+
+    // Generate.
+    Mesh* mesh = mesh_create();
+    mesh_generate(mesh, kind, a, b, f);
+
+    struct mesh_entry* entry = malloc(sizeof(struct mesh_entry));
+    entry->kind = kind;
+    entry->a = a;
+    entry->b = b;
+    entry->f = f;
+    entry->shape = mesh_export(mesh);
+    array_add(cache->entries, entry);
+
+    mesh_destroy(mesh);
+
+    return entry->shape;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "main.h"
+
+// MESH GENERATOR
+//
+// - A Mesh is an indexed vertex list in the shape buffer format (13 floats per vertex,
+//   see render.h), built on the CPU and exported as an indexed Shape (GL_TRIANGLES).
+//   mesh_export uses 16-bit indices whenever the vertex count allows it.
+// - Generators append to a mesh, so several can be combined into one shape.
+//   All of them are unit sized and centered at the origin, with outward normals,
+//   counter-clockwise front faces, and texture coordinates:
+//
+//      MESH_ICOSPHERE  radius 1, a = subdivision level (0 is the icosahedron).
+//      MESH_UVSPHERE   radius 1, a = segments around y, b = rings from pole to pole.
+//      MESH_BOX        [-1,1] on every axis, 24 vertices with flat normals.
+//      MESH_CYLINDER   radius 1, y in [-1,1], a = segments, with caps.
+//      MESH_CAPSULE    radius 1, y in [-1-f, 1+f], a = segments, b = rings per cap,
+//                      f = half height of the straight part (the entity spheroid).
+//      MESH_PLANE      [-1,1] on x and z at y = 0 facing up, a x b quads.
+//
+// - An icosphere has near uniform triangle density: level 3 (642 vertices) looks
+//   as round as a UV sphere with several times as many.
+// - MeshCache memoizes exported shapes by generator parameters. Shapes from the cache
+//   are shared and owned by it, never destroy them directly.
+
+enum mesh_kind {
+    MESH_ICOSPHERE,
+    MESH_UVSPHERE,
+    MESH_BOX,
+    MESH_CYLINDER,
+    MESH_CAPSULE,
+    MESH_PLANE,
+};
+
+struct mesh {
+    float* vertices;
+    uint32_t size;              // Number of vertices.
+    uint32_t capacity;
+
+    uint32_t* indices;
+    uint32_t index_count;
+    uint32_t index_capacity;
+
+    // Vertex Color for following vertices.
+    Vec4f color;
+};
+
+struct mesh_cache {
+    Array* entries;
+};
+
+// Create and Destroy Meshes.
+Mesh* mesh_create ();
+void mesh_destroy (Mesh* mesh);
+void mesh_clear (Mesh* mesh);
+
+// Build Meshes by hand.
+//  - mesh_vertex returns the index of the new vertex.
+void mesh_color (Mesh* mesh, Vec4f color);
+uint32_t mesh_vertex (Mesh* mesh, Vec3f pos, Vec2f texcoord, Vec3f normal);
+void mesh_triangle (Mesh* mesh, uint32_t a, uint32_t b, uint32_t c);
+
+// Append a generated shape (see above for the parameters).
+void mesh_generate (Mesh* mesh, uint32_t kind, uint32_t a, uint32_t b, float f);
+
+// Export to an indexed Shape (GL_STATIC_DRAW).
+Shape* mesh_export (Mesh* mesh);
+
+// Create and Destroy Mesh Caches.
+//  - meshcache_destroy destroys every shape it handed out.
+MeshCache* meshcache_create ();
+void meshcache_destroy (MeshCache* cache);
+
+// Get the shape for a set of generator parameters, generating it on first use.
+Shape* meshcache_get (MeshCache* cache, uint32_t kind, uint32_t a, uint32_t b, float f);
@@ -0,0 +1,151 @@
+#include "noise.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+// 32-bit multiply (low half) without SSE4.1.
+static inline __m128i mullo32 (__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0,0,2,0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0,0,2,0)));
+}
+
+static inline __m128i hash4 (__m128i seed, __m128i x, __m128i y, __m128i z) {
+    __m128i h = _mm_xor_si128(seed, mullo32(x, _mm_set1_epi32(0x8DA6B343)));
+    h = _mm_xor_si128(h, mullo32(y, _mm_set1_epi32(0xD8163841)));
+    h = _mm_xor_si128(h, mullo32(z, _mm_set1_epi32(0xCB1AB31F)));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    h = mullo32(h, _mm_set1_epi32(0x2C1B3C6D));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 12));
+    h = mullo32(h, _mm_set1_epi32(0x297A2D39));
+    h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+    return h;
+}
+
+static inline __m128 select4 (__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 grad4 (__m128i h, __m128 x, __m128 y, __m128 z) {
+    h = _mm_and_si128(h, _mm_set1_epi32(15));
+
+    __m128 lt8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+    __m128 lt4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+    __m128 is12 = _mm_castsi128_ps(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)));
+    __m128 is14 = _mm_castsi128_ps(_mm_cmpeq_epi32(h, _mm_set1_epi32(14)));
+
+    __m128 u = select4(lt8, x, y);
+    __m128 v = select4(lt4, y, select4(_mm_or_ps(is12, is14), x, z));
+
+    // Flip signs with bits 0 and 1.
+    __m128 su = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(1)), 31));
+    __m128 sv = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(h, _mm_set1_epi32(2)), 30));
+    return _mm_add_ps(_mm_xor_ps(u, su), _mm_xor_ps(v, sv));
+}
+
+static inline __m128 fade4 (__m128 t) {
+    __m128 p = _mm_add_ps(_mm_mul_ps(t, _mm_set1_ps(6)), _mm_set1_ps(-15));
+    p = _mm_add_ps(_mm_mul_ps(t, p), _mm_set1_ps(10));
+    return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), p);
+}
+
+static inline __m128 lerp4 (__m128 a, __m128 b, __m128 t) {
+    return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+// Floor (to int and float) without SSE4.1.
+static inline __m128i floor4 (__m128 x, __m128* f) {
+    __m128i i = _mm_cvttps_epi32(x);
+    __m128 t = _mm_cvtepi32_ps(i);
+    __m128i fix = _mm_castps_si128(_mm_cmpgt_ps(t, x));
+    i = _mm_add_epi32(i, fix);
+    *f = _mm_cvtepi32_ps(i);
+    return i;
+}
+
+static inline __m128 noise4 (__m128i seed, __m128 x, __m128 y, __m128 z) {
+    __m128 fx, fy, fz;
+    __m128i ix = floor4(x, &fx);
+    __m128i iy = floor4(y, &fy);
+    __m128i iz = floor4(z, &fz);
+    x = _mm_sub_ps(x, fx);
+    y = _mm_sub_ps(y, fy);
+    z = _mm_sub_ps(z, fz);
+
+    __m128 u = fade4(x), v = fade4(y), w = fade4(z);
+
+    __m128i one = _mm_set1_epi32(1);
+    __m128i jx = _mm_add_epi32(ix, one), jy = _mm_add_epi32(iy, one), jz = _mm_add_epi32(iz, one);
+    __m128 x1 = _mm_sub_ps(x, _mm_set1_ps(1));
+    __m128 y1 = _mm_sub_ps(y, _mm_set1_ps(1));
+    __m128 z1 = _mm_sub_ps(z, _mm_set1_ps(1));
+
+    __m128 n000 = grad4(hash4(seed, ix, iy, iz), x,  y,  z );
+    __m128 n100 = grad4(hash4(seed, jx, iy, iz), x1, y,  z );
+    __m128 n010 = grad4(hash4(seed, ix, jy, iz), x,  y1, z );
+    __m128 n110 = grad4(hash4(seed, jx, jy, iz), x1, y1, z );
+    __m128 n001 = grad4(hash4(seed, ix, iy, jz), x,  y,  z1);
+    __m128 n101 = grad4(hash4(seed, jx, iy, jz), x1, y,  z1);
+    __m128 n011 = grad4(hash4(seed, ix, jy, jz), x,  y1, z1);
+    __m128 n111 = grad4(hash4(seed, jx, jy, jz), x1, y1, z1);
+
+    __m128 n00 = lerp4(n000, n100, u);
+    __m128 n10 = lerp4(n010, n110, u);
+    __m128 n01 = lerp4(n001, n101, u);
+    __m128 n11 = lerp4(n011, n111, u);
+
+    return lerp4(lerp4(n00, n10, v), lerp4(n01, n11, v), w);
+}
+
+void noise3_array (uint32_t seed, const float* x, const float* y, const float* z, float* out, uint32_t count) {
+    __m128i s = _mm_set1_epi32(seed);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(out + i, noise4(s, _mm_loadu_ps(x + i), _mm_loadu_ps(y + i), _mm_loadu_ps(z + i)));
+    }
+    for (; i < count; i++) {
+        out[i] = noise3(seed, x[i], y[i], z[i]);
+    }
+}
+
+void fbm3_array (uint32_t seed, const float* x, const float* y, const float* z, float* out, uint32_t count,
+                 uint32_t octaves, float gain) {
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        __m128 sum = _mm_setzero_ps();
+        float amp = 1, norm = 0;
+
+        for (uint32_t o = 0; o < octaves; o++) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(amp), noise4(_mm_set1_epi32(seed + o), px, py, pz)));
+            norm += amp;
+            amp *= gain;
+            px = _mm_add_ps(px, px);
+            py = _mm_add_ps(py, py);
+            pz = _mm_add_ps(pz, pz);
+        }
+
+        _mm_storeu_ps(out + i, _mm_div_ps(sum, _mm_set1_ps(norm)));
+    }
+    for (; i < count; i++) {
+        out[i] = fbm3(seed, x[i], y[i], z[i], octaves, gain);
+    }
+}
+
+#else
+
+void noise3_array (uint32_t seed, const float* x, const float* y, const float* z, float* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = noise3(seed, x[i], y[i], z[i]);
+    }
+}
+
+void fbm3_array (uint32_t seed, const float* x, const float* y, const float* z, float* out, uint32_t count,
+                 uint32_t octaves, float gain) {
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = fbm3(seed, x[i], y[i], z[i], octaves, gain);
+    }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+/***
+ ***    Gradient Noise mini-Library.
+ ***        - 3D gradient noise (Perlin's improved noise), seeded: lattice gradients come
+ ***          from an integer hash of the cell and the seed instead of a permutation
+ ***          table, so there is no state and any seed is as good as another.
+ ***        - Output is in about [-1, 1], 0 at every lattice point.
+ ***        - Array versions (noise.c) compute 4 values at a time with SSE2, and give
+ ***          the same results as the scalar noise3.
+ ***        - Fractal (fBm) sums: octave i uses seed + i, twice the frequency and
+ ***          'gain' times the amplitude of the previous one, normalized to [-1, 1].
+ ***/
+
+/*  Lattice Hash.
+ */
+static inline
+uint32_t noise_hash (uint32_t seed, int32_t x, int32_t y, int32_t z) {
+    uint32_t h = seed ^ (uint32_t) x * 0x8DA6B343u ^ (uint32_t) y * 0xD8163841u ^ (uint32_t) z * 0xCB1AB31Fu;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return h;
+}
+
+/*  Gradient Dot Product (12 cube edge directions, the low 4 bits of the hash).
+ */
+static inline
+float noise_grad (uint32_t h, float x, float y, float z) {
+    h &= 15;
+    float u = h < 8 ? x : y;
+    float v = h < 4 ? y : (h == 12 || h == 14) ? x : z;
+    return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+static inline
+float noise_fade (float t) {
+    return t*t*t*(t*(t*6 - 15) + 10);
+}
+
+static inline
+float noise_lerp (float a, float b, float t) {
+    return a + t*(b - a);
+}
+
+/*  Scalar 3D Noise.
+ */
+static inline
+float noise3 (uint32_t seed, float x, float y, float z) {
+    float fx = floorf(x), fy = floorf(y), fz = floorf(z);
+    int32_t ix = (int32_t) fx, iy = (int32_t) fy, iz = (int32_t) fz;
+    x -= fx; y -= fy; z -= fz;
+
+    float u = noise_fade(x), v = noise_fade(y), w = noise_fade(z);
+
+    float n000 = noise_grad(noise_hash(seed, ix,     iy,     iz    ), x,     y,     z    );
+    float n100 = noise_grad(noise_hash(seed, ix + 1, iy,     iz    ), x - 1, y,     z    );
+    float n010 = noise_grad(noise_hash(seed, ix,     iy + 1, iz    ), x,     y - 1, z    );
+    float n110 = noise_grad(noise_hash(seed, ix + 1, iy + 1, iz    ), x - 1, y - 1, z    );
+    float n001 = noise_grad(noise_hash(seed, ix,     iy,     iz + 1), x,     y,     z - 1);
+    float n101 = noise_grad(noise_hash(seed, ix + 1, iy,     iz + 1), x - 1, y,     z - 1);
+    float n011 = noise_grad(noise_hash(seed, ix,     iy + 1, iz + 1), x,     y - 1, z - 1);
+    float n111 = noise_grad(noise_hash(seed, ix + 1, iy + 1, iz + 1), x - 1, y - 1, z - 1);
+
+    float n00 = noise_lerp(n000, n100, u);
+    float n10 = noise_lerp(n010, n110, u);
+    float n01 = noise_lerp(n001, n101, u);
+    float n11 = noise_lerp(n011, n111, u);
+
+    return noise_lerp(noise_lerp(n00, n10, v), noise_lerp(n01, n11, v), w);
+}
+
+/*  Scalar fBm.
+ */
+static inline
+float fbm3 (uint32_t seed, float x, float y, float z, uint32_t octaves, float gain) {
+    float sum = 0, amp = 1, norm = 0;
+    for (uint32_t i = 0; i < octaves; i++) {
+        sum += amp * noise3(seed + i, x, y, z);
+        norm += amp;
+        amp *= gain;
+        x *= 2; y *= 2; z *= 2;
+    }
+    return sum / norm;
+}
+
+
+/*  Array Versions (noise.c).
+ *      - 'out' may be one of the inputs.
+ */
+void noise3_array (uint32_t seed, const float* x, const float* y, const float* z, float* out, uint32_t count);
+void fbm3_array (uint32_t seed, const float* x, const float* y, const float* z, float* out, uint32_t count,
+                 uint32_t octaves, float gain);
@@ -4,5 +4,5 @@
 
 
 struct orb {
-    Shape* shape;
+    Shape* shape;   // Shared, owned by env->meshes.
 };
@@ -0,0 +1,603 @@
+#include "physics.h"
+
+#include "array.h"
+#include "bvh.h"
+#include "entity.h"
+#include "environment.h"
+#include "jobs.h"
+#include "world.h"
+
+
+Physics* physics_create (JobPool* jobs) {
+    // Allocate and Initialize.
+    Physics* physics = malloc(sizeof(Physics));
+    physics->jobs = jobs;
+
+    physics->contact_capacity = 64;
+    physics->previous_capacity = 64;
+    physics->contacts = malloc(physics->contact_capacity * sizeof(struct physics_contact));
+    physics->previous = malloc(physics->previous_capacity * sizeof(struct physics_contact));
+    physics->contact_count = 0;
+    physics->previous_count = 0;
+
+    physics->body_capacity = 0;
+    physics->parent = NULL;
+    physics->island_first = NULL;
+    physics->order = NULL;
+    physics->island_count = 0;
+
+    physics->sweep_capacity = 16;
+    physics->sweeps = malloc(physics->sweep_capacity * sizeof(struct physics_sweep));
+    physics->sweep_count = 0;
+
+    return physics;
+}
+
+void physics_destroy (Physics* physics) {
+    free(physics->contacts);
+    free(physics->previous);
+    free(physics->parent);
+    free(physics->island_first);
+    free(physics->order);
+    free(physics->sweeps);
+    free(physics);
+}
+
+static bool is_moving (const Entity* e) {
+    return !(e->flags & FLAG_STATIC) && (e->vel.x != 0 || e->vel.y != 0 || e->vel.z != 0);
+}
+
+static bool is_dynamic (const Entity* e) {
+    return !(e->flags & FLAG_STATIC) && e->radius > 0 && e->mass > 0;
+}
+
+static float inverse_mass (const Entity* e) {
+    return is_dynamic(e) ? 1 / e->mass : 0;
+}
+
+
+//
+// Contacts.
+//
+
+struct contact_query {
+    Physics* physics;
+    Entity* entity;
+};
+
+static int compare_pair (const Entity* a0, const Entity* b0, const Entity* a1, const Entity* b1) {
+    if (a0 != a1) return (uintptr_t) a0 < (uintptr_t) a1 ? -1 : 1;
+    if (b0 != b1) return (uintptr_t) b0 < (uintptr_t) b1 ? -1 : 1;
+    return 0;
+}
+
+static int compare_contacts (const void* x, const void* y) {
+    const struct physics_contact* c0 = x;
+    const struct physics_contact* c1 = y;
+    return compare_pair(c0->a, c0->b, c1->a, c1->b);
+}
+
+// Upright capsule pair: closest features of two vertical segments.
+//  - Returns false if they are further apart than the margin.
+static bool collide_capsules (Entity* a, Entity* b, struct physics_contact* contact) {
+    float ra = a->radius, rb = b->radius;
+    float ha = entity_half_segment(a), hb = entity_half_segment(b);
+
+    Vec3f d = sub3f(b->pos, a->pos);
+    float dxz = sqrtf(d.x*d.x + d.z*d.z);
+
+    // Overlap of the two segments along y.
+    float lo = fmaxf(a->pos.y - ha, b->pos.y - hb);
+    float hi = fminf(a->pos.y + ha, b->pos.y + hb);
+
+    contact->point_count = 0;
+
+    if (lo <= hi) {
+        // Side by side: horizontal normal, one point per end of the overlap.
+        float dist = dxz;
+        float separation = dist - ra - rb;
+        if (separation > PHYSICS_MARGIN) return false;
+
+        contact->normal = dist > 1e-6f ? cons3f(d.x/dist, 0, d.z/dist) : cons3f(1,0,0);
+
+        float ys[2] = {lo, hi};
+        uint32_t count = hi - lo > 1e-4f ? 2 : 1;
+        for (uint32_t i = 0; i < count; i++) {
+            struct physics_point* p = &contact->points[contact->point_count++];
+            p->separation = separation;
+            p->position = add3f(cons3f(a->pos.x, ys[i], a->pos.z), scale3f(ra + separation/2, contact->normal));
+        }
+    } else {
+        // Above each other: closest segment ends.
+        float ya = b->pos.y > a->pos.y ? a->pos.y + ha : a->pos.y - ha;
+        float yb = b->pos.y > a->pos.y ? b->pos.y - hb : b->pos.y + hb;
+        Vec3f pa = cons3f(a->pos.x, ya, a->pos.z);
+        Vec3f pb = cons3f(b->pos.x, yb, b->pos.z);
+
+        Vec3f n = sub3f(pb, pa);
+        float dist = length3f(n);
+        float separation = dist - ra - rb;
+        if (separation > PHYSICS_MARGIN) return false;
+
+        contact->normal = dist > 1e-6f ? scale3f(1/dist, n) : cons3f(0, b->pos.y > a->pos.y ? 1 : -1, 0);
+
+        struct physics_point* p = &contact->points[contact->point_count++];
+        p->separation = separation;
+        p->position = add3f(pa, scale3f(ra + separation/2, contact->normal));
+    }
+
+    // Friction Directions.
+    Vec3f n = contact->normal;
+    Vec3f axis = fabsf(n.y) < 0.9f ? cons3f(0,1,0) : cons3f(1,0,0);
+    contact->tangent[0] = normalize3f(cross3f(n, axis));
+    contact->tangent[1] = cross3f(n, contact->tangent[0]);
+
+    return true;
+}
+
+static void contact_candidate (Entity* other, void* arg) {
+    struct contact_query* query = arg;
+    Physics* physics = query->physics;
+    Entity* e = query->entity;
+
+    if (other == e || other->state == STATE_DESTROY || other->radius <= 0) return;
+
+    // Dynamic pairs are found from both sides, keep one.
+    if (is_dynamic(other) && other->body < e->body) return;
+
+    // Order the pair by address, so the key is the same every tick.
+    Entity* a = (uintptr_t) e < (uintptr_t) other ? e : other;
+    Entity* b = a == e ? other : e;
+
+    if (physics->contact_count == physics->contact_capacity) {
+        physics->contact_capacity *= 2;
+        physics->contacts = realloc(physics->contacts, physics->contact_capacity * sizeof(struct physics_contact));
+    }
+
+    struct physics_contact* contact = &physics->contacts[physics->contact_count];
+    contact->a = a;
+    contact->b = b;
+    if (!collide_capsules(a, b, contact)) return;
+
+    for (uint32_t i = 0; i < contact->point_count; i++) {
+        contact->points[i].normal_impulse = 0;
+        contact->points[i].tangent_impulse[0] = 0;
+        contact->points[i].tangent_impulse[1] = 0;
+    }
+    contact->persisted = false;
+
+    physics->contact_count++;
+}
+
+static void find_contacts (Physics* physics, Array* entities) {
+    physics->contact_count = 0;
+
+    for (int i = 0; i < entities->size; i++) {
+        Entity* e = entities->data[i];
+        if (!is_dynamic(e)) continue;
+
+        Vec3f extent = add3f(entity_extent(e), cons3f(PHYSICS_MARGIN, PHYSICS_MARGIN, PHYSICS_MARGIN));
+        struct contact_query query = { .physics = physics, .entity = e };
+        bvh_query_aabb(e->env->bvh, sub3f(e->pos, extent), add3f(e->pos, extent), contact_candidate, &query);
+    }
+
+    qsort(physics->contacts, physics->contact_count, sizeof(struct physics_contact), compare_contacts);
+
+    // Warm start from last tick's contact of the same pair (both lists are sorted).
+    uint32_t j = 0;
+    for (uint32_t i = 0; i < physics->contact_count; i++) {
+        struct physics_contact* contact = &physics->contacts[i];
+        while (j < physics->previous_count && compare_contacts(&physics->previous[j], contact) < 0) j++;
+        if (j == physics->previous_count) break;
+
+        struct physics_contact* old = &physics->previous[j];
+        if (compare_contacts(old, contact) != 0) continue;
+
+        contact->persisted = true;
+        if (old->point_count != contact->point_count) continue;
+
+        for (uint32_t k = 0; k < contact->point_count; k++) {
+            contact->points[k].normal_impulse = old->points[k].normal_impulse;
+            contact->points[k].tangent_impulse[0] = old->points[k].tangent_impulse[0];
+            contact->points[k].tangent_impulse[1] = old->points[k].tangent_impulse[1];
+        }
+    }
+}
+
+
+//
+// Islands.
+//
+
+static uint32_t find_root (uint32_t* parent, uint32_t i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+static void build_islands (Physics* physics, Array* entities) {
+    uint32_t n = entities->size;
+    if (n > physics->body_capacity) {
+        physics->body_capacity = n;
+        physics->parent = realloc(physics->parent, n * sizeof(uint32_t));
+        physics->island_first = realloc(physics->island_first, (n + 1) * sizeof(uint32_t));
+    }
+    physics->order = realloc(physics->order, (physics->contact_count + 1) * sizeof(uint32_t));
+
+    // Join dynamic entities that touch (support doesn't join islands).
+    for (uint32_t i = 0; i < n; i++) physics->parent[i] = i;
+
+    for (uint32_t i = 0; i < physics->contact_count; i++) {
+        struct physics_contact* c = &physics->contacts[i];
+        if (is_dynamic(c->a) && is_dynamic(c->b)) {
+            uint32_t ra = find_root(physics->parent, c->a->body);
+            uint32_t rb = find_root(physics->parent, c->b->body);
+            if (ra != rb) physics->parent[ra] = rb;
+        }
+    }
+
+    // Number the islands (island_first is used as a root -> island map first).
+    uint32_t* island_of = physics->island_first;
+    for (uint32_t i = 0; i < n; i++) island_of[i] = UINT32_MAX;
+
+    uint32_t islands = 0;
+    for (uint32_t i = 0; i < physics->contact_count; i++) {
+        struct physics_contact* c = &physics->contacts[i];
+        Entity* body = is_dynamic(c->a) ? c->a : c->b;
+        uint32_t root = find_root(physics->parent, body->body);
+        if (island_of[root] == UINT32_MAX) island_of[root] = islands++;
+        c->island = island_of[root];
+    }
+
+    // Group contacts by island (counting sort).
+    uint32_t* first = physics->island_first;
+    for (uint32_t i = 0; i <= islands; i++) first[i] = 0;
+    for (uint32_t i = 0; i < physics->contact_count; i++) first[physics->contacts[i].island + 1]++;
+    for (uint32_t i = 0; i < islands; i++) first[i + 1] += first[i];
+
+    for (uint32_t i = 0; i < physics->contact_count; i++) {
+        physics->order[first[physics->contacts[i].island]++] = i;
+    }
+
+    // Shift back to start offsets.
+    for (uint32_t i = islands; i > 0; i--) first[i] = first[i - 1];
+    first[0] = 0;
+
+    physics->island_count = islands;
+}
+
+
+//
+// Solver.
+//
+
+// Support is shared between islands, so only dynamic entities are written.
+static void apply_impulse (struct physics_contact* c, Vec3f impulse, float ia, float ib) {
+    if (ia > 0) c->a->vel = sub3f(c->a->vel, scale3f(ia, impulse));
+    if (ib > 0) c->b->vel = add3f(c->b->vel, scale3f(ib, impulse));
+}
+
+static void solve_island (void* arg, uint32_t island) {
+    Physics* physics = arg;
+    uint32_t first = physics->island_first[island];
+    uint32_t last = physics->island_first[island + 1];
+
+    // Warm Start.
+    for (uint32_t k = first; k < last; k++) {
+        struct physics_contact* c = &physics->contacts[physics->order[k]];
+        float ia = inverse_mass(c->a), ib = inverse_mass(c->b);
+
+        for (uint32_t i = 0; i < c->point_count; i++) {
+            struct physics_point* p = &c->points[i];
+            Vec3f impulse = scale3f(p->normal_impulse, c->normal);
+            impulse = add3f(impulse, scale3f(p->tangent_impulse[0], c->tangent[0]));
+            impulse = add3f(impulse, scale3f(p->tangent_impulse[1], c->tangent[1]));
+            apply_impulse(c, impulse, ia, ib);
+        }
+    }
+
+    for (int iteration = 0; iteration < PHYSICS_ITERATIONS; iteration++) {
+        for (uint32_t k = first; k < last; k++) {
+            struct physics_contact* c = &physics->contacts[physics->order[k]];
+            float ia = inverse_mass(c->a), ib = inverse_mass(c->b);
+            float mass = 1 / (ia + ib);
+
+            for (uint32_t i = 0; i < c->point_count; i++) {
+                struct physics_point* p = &c->points[i];
+
+                // Normal: approach no further than the gap, push out of overlaps.
+                float target = p->separation > 0
+                    ? -p->separation
+                    : PHYSICS_BAUMGARTE * fmaxf(-p->separation - PHYSICS_SLOP, 0);
+
+                float vn = dot3f(sub3f(c->b->vel, c->a->vel), c->normal);
+                float old = p->normal_impulse;
+                p->normal_impulse = fmaxf(old + (target - vn) * mass, 0);
+                apply_impulse(c, scale3f(p->normal_impulse - old, c->normal), ia, ib);
+
+                // Friction, within the cone of the normal impulse.
+                float limit = PHYSICS_FRICTION * p->normal_impulse;
+                for (int t = 0; t < 2; t++) {
+                    float vt = dot3f(sub3f(c->b->vel, c->a->vel), c->tangent[t]);
+                    float old_t = p->tangent_impulse[t];
+                    float next = old_t - vt * mass;
+                    if (next > limit) next = limit;
+                    if (next < -limit) next = -limit;
+                    p->tangent_impulse[t] = next;
+                    apply_impulse(c, scale3f(next - old_t, c->tangent[t]), ia, ib);
+                }
+            }
+        }
+    }
+}
+
+
+//
+// Sweeps.
+//
+
+// Swept test against one candidate (BVH query callback).
+static void sweep_candidate (Entity* other, void* arg) {
+    struct physics_sweep* sweep = arg;
+    Entity* e = sweep->entity;
+    if (other == e || other->state == STATE_DESTROY) return;
+
+    // Motion relative to the other entity.
+    Vec3f d = sweep->motion;
+    if (!(other->flags & FLAG_STATIC)) d = sub3f(d, other->vel);
+
+    float len = length3f(d);
+    if (len <= 0) return;
+
+    // Two upright capsules touch when the first's center reaches a capsule around the
+    // second with the summed radius and segment.
+    float r = e->radius + other->radius;
+    float hs = entity_half_segment(e) + entity_half_segment(other);
+    float t = bvh_ray_capsule(e->pos, scale3f(1/len, d), other->pos, r, hs) / len;
+
+    if (t <= 1 && t < sweep->time) {
+        sweep->time = t;
+        sweep->other = other;
+    }
+}
+
+static void sweep_entities (Physics* physics, Environment* env) {
+    Array* entities = env->entities;
+
+    // Largest motion this tick, the BVH boxes are at the start positions.
+    float max_motion = 0;
+    for (int i = 0; i < entities->size; i++) {
+        Entity* e = entities->data[i];
+        if (is_moving(e)) {
+            float m = length3f(e->vel);
+            if (m > max_motion) max_motion = m;
+        }
+    }
+
+    physics->sweep_count = 0;
+    for (int i = 0; i < entities->size; i++) {
+        Entity* e = entities->data[i];
+        if (!(e->flags & FLAG_CCD) || e->radius <= 0 || !is_moving(e)) continue;
+
+        if (physics->sweep_count == physics->sweep_capacity) {
+            physics->sweep_capacity *= 2;
+            physics->sweeps = realloc(physics->sweeps, physics->sweep_capacity * sizeof(struct physics_sweep));
+        }
+
+        struct physics_sweep* sweep = &physics->sweeps[physics->sweep_count++];
+        sweep->entity = e;
+        sweep->other = NULL;
+        sweep->motion = e->vel;
+        sweep->time = INFINITY;
+
+        // Candidates: anything within the swept box, widened by the fastest mover.
+        Vec3f end = add3f(e->pos, e->vel);
+        Vec3f margin = add3f(entity_extent(e), cons3f(max_motion, max_motion, max_motion));
+        Vec3f min = sub3f(cons3f(fminf(e->pos.x, end.x), fminf(e->pos.y, end.y), fminf(e->pos.z, end.z)), margin);
+        Vec3f max = add3f(cons3f(fmaxf(e->pos.x, end.x), fmaxf(e->pos.y, end.y), fmaxf(e->pos.z, end.z)), margin);
+
+        bvh_query_aabb(env->bvh, min, max, sweep_candidate, sweep);
+    }
+}
+
+
+//
+// Voxels.
+//
+
+// True if any solid block lies in layer 'n' of axis 'a', within the cell ranges of the other two axes.
+static bool layer_solid (World* world, int a, int32_t n, const int32_t first[3], const int32_t last[3]) {
+    int b = (a + 1) % 3;
+    int c = (a + 2) % 3;
+
+    int32_t p[3];
+    p[a] = n;
+    for (p[b] = first[b]; p[b] <= last[b]; p[b]++) {
+        for (p[c] = first[c]; p[c] <= last[c]; p[c]++) {
+            if (block_is_solid(world_get_block(world, p[0], p[1], p[2]))) return true;
+        }
+    }
+    return false;
+}
+
+// Move a box by 'd' along axis 'a', stopping short of the first solid block on the way.
+//  - Only the layers of blocks the box sweeps over are visited. Blocks the box already
+//    overlaps are ignored, so boxes stuck inside blocks can still move out.
+//  - Returns the distance moved, 'blocked' tells if a block was hit.
+static float sweep_axis (World* world, float lo[3], float hi[3], int a, float d, bool* blocked) {
+    *blocked = false;
+    if (d == 0) return 0;
+
+    // Cells overlapped on the other axes (touching doesn't count).
+    const float e = PHYSICS_SKIN / 2;
+    int32_t first[3], last[3];
+    for (int i = 0; i < 3; i++) {
+        first[i] = (int32_t) floorf(lo[i] + e);
+        last[i] = (int32_t) ceilf(hi[i] - e) - 1;
+    }
+
+    if (d > 0) {
+        int32_t end = (int32_t) floorf(hi[a] + d);
+        for (int32_t n = (int32_t) ceilf(hi[a] - e); n <= end; n++) {
+            if (layer_solid(world, a, n, first, last)) {
+                d = fmaxf(n - hi[a] - PHYSICS_SKIN, 0);
+                *blocked = true;
+                break;
+            }
+        }
+    } else {
+        int32_t end = (int32_t) floorf(lo[a] + d);
+        for (int32_t n = (int32_t) floorf(lo[a] + e) - 1; n >= end; n--) {
+            if (layer_solid(world, a, n, first, last)) {
+                d = fminf(n + 1 - lo[a] + PHYSICS_SKIN, 0);
+                *blocked = true;
+                break;
+            }
+        }
+    }
+
+    lo[a] += d;
+    hi[a] += d;
+    return d;
+}
+
+// Move an entity by 'delta' through the blocks (y first, then x and z, stepping up ledges if grounded).
+static void move_voxels (World* world, Entity* e, Vec3f delta) {
+    Vec3f ext = entity_extent(e);
+    float lo[3] = {e->pos.x - ext.x, e->pos.y - ext.y, e->pos.z - ext.z};
+    float hi[3] = {e->pos.x + ext.x, e->pos.y + ext.y, e->pos.z + ext.z};
+    float start[3] = {lo[0], lo[1], lo[2]};
+
+    bool blocked[3];
+    sweep_axis(world, lo, hi, 1, delta.y, &blocked[1]);
+    bool grounded = blocked[1] && delta.y < 0;
+
+    // Sideways, from where the vertical move ended.
+    float step_lo[3] = {lo[0], lo[1], lo[2]};
+    float step_hi[3] = {hi[0], hi[1], hi[2]};
+
+    float dx = sweep_axis(world, lo, hi, 0, delta.x, &blocked[0]);
+    float dz = sweep_axis(world, lo, hi, 2, delta.z, &blocked[2]);
+
+    // Step Up: go over the ledge, across, and back down, and keep that if it went further.
+    if (grounded && (blocked[0] || blocked[2])) {
+        bool up_blocked, step_blocked[3];
+        float up = sweep_axis(world, step_lo, step_hi, 1, PHYSICS_STEP_HEIGHT, &up_blocked);
+        float sx = sweep_axis(world, step_lo, step_hi, 0, delta.x, &step_blocked[0]);
+        float sz = sweep_axis(world, step_lo, step_hi, 2, delta.z, &step_blocked[2]);
+        sweep_axis(world, step_lo, step_hi, 1, -up, &step_blocked[1]);
+
+        if (sx*sx + sz*sz > dx*dx + dz*dz + PHYSICS_SKIN*PHYSICS_SKIN) {
+            for (int i = 0; i < 3; i++) {
+                lo[i] = step_lo[i];
+                hi[i] = step_hi[i];
+            }
+            blocked[0] = step_blocked[0];
+            blocked[2] = step_blocked[2];
+        }
+    }
+
+    e->pos = add3f(e->pos, cons3f(lo[0] - start[0], lo[1] - start[1], lo[2] - start[2]));
+
+    if (blocked[0]) e->vel.x = 0;
+    if (blocked[1]) e->vel.y = 0;
+    if (blocked[2]) e->vel.z = 0;
+    if (grounded) e->flags |= FLAG_GROUNDED;
+}
+
+
+void physics_step (Physics* physics, Environment* env) {
+    Array* entities = env->entities;
+
+    // Ground Motion and Gravity.
+    for (int i = 0; i < entities->size; i++) {
+        Entity* e = entities->data[i];
+        e->body = i;
+
+        if ((e->flags & FLAG_GROUNDED) && !(e->flags & FLAG_STATIC)) {
+            e->vel.x += (e->motion.x - e->vel.x) * e->friction;
+            e->vel.z += (e->motion.z - e->vel.z) * e->friction;
+        }
+        e->flags &= ~FLAG_GROUNDED;
+
+        if ((e->flags & FLAG_GRAVITY) && !(e->flags & FLAG_STATIC)) {
+            e->vel.y -= PHYSICS_GRAVITY;
+        }
+    }
+
+    // Contacts and Islands.
+    find_contacts(physics, entities);
+    build_islands(physics, entities);
+
+    // Solve (small workloads aren't worth waking the workers).
+    if (physics->contact_count < 64) {
+        for (uint32_t i = 0; i < physics->island_count; i++) solve_island(physics, i);
+    } else {
+        jobs_parallel_for(physics->jobs, physics->island_count, solve_island, physics);
+    }
+
+    // Sweeps (with solved velocities, before anything moves).
+    sweep_entities(physics, env);
+
+    // Integrate (through the blocks, for entities with a radius).
+    for (int i = 0; i < entities->size; i++) {
+        Entity* e = entities->data[i];
+        if (e->flags & FLAG_STATIC) continue;
+        if ((e->flags & FLAG_CCD) && e->radius > 0) continue;
+
+        if (e->radius > 0) {
+            move_voxels(env->world, e, e->vel);
+        } else {
+            e->pos = add3f(e->pos, e->vel);
+        }
+    }
+
+    for (uint32_t i = 0; i < physics->sweep_count; i++) {
+        struct physics_sweep* sweep = &physics->sweeps[i];
+        Entity* e = sweep->entity;
+
+        if (sweep->other == NULL) {
+            move_voxels(env->world, e, e->vel);
+            continue;
+        }
+
+        // Stop just short of the contact.
+        float t = sweep->time - PHYSICS_SKIN / length3f(e->vel);
+        move_voxels(env->world, e, scale3f(t > 0 ? t : 0, e->vel));
+    }
+
+    // Ground Flags and new Contacts.
+    for (uint32_t i = 0; i < physics->contact_count; i++) {
+        struct physics_contact* c = &physics->contacts[i];
+        if (c->points[0].separation > PHYSICS_SLOP) continue;
+
+        if (c->normal.y <= -PHYSICS_GROUND_SLOPE) c->a->flags |= FLAG_GROUNDED;
+        if (c->normal.y >= PHYSICS_GROUND_SLOPE) c->b->flags |= FLAG_GROUNDED;
+
+        if (!c->persisted) {
+            entity_collide(c->a, c->b, 0);
+            entity_collide(c->b, c->a, 0);
+        }
+    }
+
+    for (uint32_t i = 0; i < physics->sweep_count; i++) {
+        struct physics_sweep* sweep = &physics->sweeps[i];
+        if (sweep->other == NULL) continue;
+
+        entity_collide(sweep->entity, sweep->other, sweep->time);
+        if (!(sweep->other->flags & FLAG_CCD)) {
+            entity_collide(sweep->other, sweep->entity, sweep->time);
+        }
+    }
+
+    // Keep this tick's contacts for warm starting.
+    struct physics_contact* swap = physics->previous;
+    uint32_t capacity = physics->previous_capacity;
+    physics->previous = physics->contacts;
+    physics->previous_count = physics->contact_count;
+    physics->previous_capacity = physics->contact_capacity;
+    physics->contacts = swap;
+    physics->contact_capacity = capacity;
+}
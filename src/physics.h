@@ -0,0 +1,116 @@
+#pragma once
+
+#include "main.h"
+
+// PHYSICS
+//
+// - physics_step runs once per tick ("Entity Physics" in env_update). Velocities
+//   are in units per tick, so there is no time step anywhere.
+// - Order of a step:
+//     1. Gravity for entities with FLAG_GRAVITY.
+//     2. Contacts: pairs of overlapping (or nearly touching) capsules from the BVH,
+//        with up to two contact points each (capsules side by side touch along a line).
+//     3. Solver: sequential impulses with friction, warm started from the previous
+//        tick's contacts of the same pair. Contacts are split into islands (groups of
+//        entities touching each other), which are solved in parallel on the job pool.
+//     4. Sweeps: entities with FLAG_CCD are swept against the other entities, so fast
+//        movers can't pass through anything in a single tick.
+//     5. Integration: every non-static entity moves by 'vel'. Entities with a radius
+//        are stopped by solid blocks on the way (see Voxels below).
+// - Dynamic entities are non-static with radius > 0 and mass > 0. Everything else
+//   with a radius acts as immovable support.
+// - FLAG_GROUNDED is set on entities resting on something (an entity or a block).
+//   Grounded entities move towards their 'motion' velocity on the ground plane,
+//   by 'friction' (0 slides freely, 1 follows 'motion' exactly) per tick.
+// - Voxels: entities collide with solid blocks as their bounding box (entity_extent).
+//   Motion is resolved axis by axis (y first, then x and z), each axis only visiting
+//   the blocks the box sweeps over, so the cost doesn't depend on the size of the world.
+//   Velocity along a blocked axis is dropped. Grounded entities blocked sideways step up
+//   onto ledges of at most PHYSICS_STEP_HEIGHT.
+// - on_collide is called on both entities when a contact starts (time 0), and for
+//   swept contacts (with the contact time, a fraction of the tick). When both entities
+//   are swept, each one reports its own earliest contact.
+// - Entities don't rotate, so contacts only change linear velocity.
+
+// Gap left between a swept entity and what it hit.
+#define PHYSICS_SKIN 0.001f
+
+// Contacts are kept from this far apart, so approaching entities slow down in time.
+#define PHYSICS_MARGIN 0.05f
+
+// Allowed overlap, and the fraction of the rest corrected per tick.
+#define PHYSICS_SLOP 0.005f
+#define PHYSICS_BAUMGARTE 0.2f
+
+#define PHYSICS_ITERATIONS 10
+#define PHYSICS_FRICTION 0.5f
+
+// Gravity (units per tick squared, about 9.8 at 60 ticks per second).
+#define PHYSICS_GRAVITY 0.0027f
+
+// Contact normals steeper than this count as ground.
+#define PHYSICS_GROUND_SLOPE 0.7f
+
+// Highest ledge walked onto without jumping.
+#define PHYSICS_STEP_HEIGHT 1.05f
+
+struct physics_point {
+    float separation;           // Negative when overlapping.
+    Vec3f position;
+
+    // Accumulated impulses (warm starting).
+    float normal_impulse;
+    float tangent_impulse[2];
+};
+
+struct physics_contact {
+    Entity* a;
+    Entity* b;
+
+    Vec3f normal;               // From a to b.
+    Vec3f tangent[2];
+
+    struct physics_point points[2];
+    uint32_t point_count;
+
+    uint32_t island;
+    bool persisted;             // Existed last tick.
+};
+
+struct physics_sweep {
+    Entity* entity;
+    Entity* other;              // NULL if nothing was hit.
+    Vec3f motion;
+    float time;
+};
+
+struct physics {
+    JobPool* jobs;
+
+    // Contacts this tick and last tick (sorted by pair).
+    struct physics_contact* contacts;
+    struct physics_contact* previous;
+    uint32_t contact_count;
+    uint32_t previous_count;
+    uint32_t contact_capacity;
+    uint32_t previous_capacity;
+
+    // Islands: union-find parents per entity, and contacts grouped by island.
+    uint32_t* parent;
+    uint32_t* island_first;
+    uint32_t* order;
+    uint32_t island_count;
+    uint32_t body_capacity;
+
+    // Swept entities this tick.
+    struct physics_sweep* sweeps;
+    uint32_t sweep_count;
+    uint32_t sweep_capacity;
+};
+
+// Create and Destroy Physics State.
+Physics* physics_create (JobPool* jobs);
+void physics_destroy (Physics* physics);
+
+// Advance the entities of 'env' by one tick.
+void physics_step (Physics* physics, Environment* env);
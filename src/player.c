@@ -3,19 +3,20 @@
 #include "entity.h"
 #include "environment.h"
 #include "render.h"
+#include "world.h"
 
 /*******************************************
 Entity-Type Definition Template:
 
 static void _init (Entity* entity);
 static void _destroy (Entity* entity);
-static void _load (Entity* entity);
+static void _load (Entity* entity, const uint8_t* data, uint32_t size);
 static void _update (Entity* entity);
-static void _save (Entity* entity);
+static uint32_t _save (Entity* entity, uint8_t* data);
 static void _unload (Entity* entity);
 static void _draw (Entity* entity, Shader* shader, DrawInfo* drawinfo);
 static void _receive (Entity* entity, Entity* sender, Message* message);
-static void _collide (Entity* entity, Entity* other);
+static void _collide (Entity* entity, Entity* other, float time);
 static void _react (Entity* entity, Entity* other, float dist);
 
 EntityType _entity_type = {
@@ -35,13 +36,13 @@ EntityType _entity_type = {
 
 static void player_init (Entity* entity);
 static void player_destroy_ (Entity* entity);
-static void player_load (Entity* entity);
+static void player_load (Entity* entity, const uint8_t* data, uint32_t size);
 static void player_update (Entity* entity);
-static void player_save (Entity* entity);
+static uint32_t player_save (Entity* entity, uint8_t* data);
 static void player_unload (Entity* entity);
 static void player_draw (Entity* entity, Shader* shader, DrawInfo* drawinfo);
 static void player_receive (Entity* entity, Entity* sender, Message* message);
-static void player_collide (Entity* entity, Entity* other);
+static void player_collide (Entity* entity, Entity* other, float time);
 static void player_react (Entity* entity, Entity* other, float dist);
 
 EntityType player_entity_type = {
@@ -67,6 +68,7 @@ Player* player_create (Environment* env) {
 
     player->yaw = 0;
     player->pitch = 0;
+    player->target = (BlockHit) {.type = BLOCK_AIR};
 
     return player;
 }
@@ -86,7 +88,7 @@ void player_destroy_ (Entity* entity) {
 }
 
 static
-void player_load (Entity* entity) {}
+void player_load (Entity* entity, const uint8_t* data, uint32_t size) {}
 
 static
 void player_update (Entity* entity) {
@@ -102,8 +104,10 @@ void player_update (Entity* entity) {
     if (player->pitch > HALF_PI) player->pitch = HALF_PI;
     if (player->pitch < -HALF_PI) player->pitch = -HALF_PI;
 
-    float sy = SPEED * sin(player->yaw);
-    float cy = SPEED * cos(player->yaw);
+    float sy, cy;
+    fsincos(player->yaw, &sy, &cy);
+    sy *= SPEED;
+    cy *= SPEED;
 
     if (env->input->up) {
         entity->pos.x -= sy;
@@ -129,21 +133,24 @@ void player_update (Entity* entity) {
         entity->pos.y -= SPEED;
     }
 
+    // The view direction is the opposite of player_get_direction.
+    Vec3f look = scale3f(-1, player_get_direction(player));
+    world_raycast(env->world, entity->pos, look, PLAYER_REACH, &player->target);
 
 }
 
 static
-void player_save (Entity* entity) {}
+uint32_t player_save (Entity* entity, uint8_t* data) {
+    return 0;
+}
 
 static
 void player_unload (Entity* entity) {}
 
 Vec3f player_get_direction (Player* player) {
-    float sy = sin(player->yaw);
-    float cy = cos(player->yaw);
-
-    float sp = sin(player->pitch);
-    float cp = cos(player->pitch);
+    float sy, cy, sp, cp;
+    fsincos(player->yaw, &sy, &cy);
+    fsincos(player->pitch, &sp, &cp);
 
     return normalize3f(cons3f(cp*sy, sp, cp*cy));
 }
@@ -152,17 +159,10 @@ void player_get_view (Player* player, Mat4f* V) {
     Vec3f t = player->entity->pos;
     Vec3f up = cons3f(0,1,0);
 
-    Vec3f vz = player_get_direction(player);
-    Vec3f vx = normalize3f(cross3f(up, vz));
-    Vec3f vy = normalize3f(cross3f(vz, vx));
-
-    *V = (Mat4f) {
-        vx.x,  vx.y, vx.z, -dot3f(vx,t),
-        vy.x,  vy.y, vy.z, -dot3f(vy,t),
-        vz.x,  vz.y, vz.z, -dot3f(vz,t),
-        0,     0,    0,     1,
-    };
+    // The direction points out the back of the camera.
+    Vec3f dir = player_get_direction(player);
 
+    *V = mat4f_lookat(t, sub3f(t, dir), up);
 }
 
 void player_draw_ui (Player* player) {
@@ -177,7 +177,7 @@ static
 void player_receive (Entity* entity, Entity* sender, Message* message) {}
 
 static
-void player_collide (Entity* entity, Entity* other) {}
+void player_collide (Entity* entity, Entity* other, float time) {}
 
 static
 void player_react (Entity* entity, Entity* other, float dist) {}
@@ -2,6 +2,9 @@
 
 #include "main.h"
 
+#include "raycast.h"
+
+#define PLAYER_REACH 6.0f
 
 struct player {
     Environment* env;
@@ -9,6 +12,9 @@ struct player {
 
 
     float yaw, pitch;
+
+    // Block under the crosshair (type BLOCK_AIR if none within reach).
+    BlockHit target;
 };
 
 
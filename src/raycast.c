@@ -0,0 +1,159 @@
+#include "raycast.h"
+
+#include "world.h"
+
+
+// Longest ray walked, so that rays into empty space always end.
+#define RAYCAST_MAX_DIST 4096.0f
+
+// Recently used chunks (direct mapped).
+#define CACHE_SIZE 16
+
+struct chunk_cache {
+    Vec3i pos[CACHE_SIZE];
+    Chunk* chunk[CACHE_SIZE];
+    uint32_t used;
+};
+
+static Chunk* cache_get (World* world, struct chunk_cache* cache, Vec3i pos) {
+    uint32_t slot = ((uint32_t) pos.i * 3 + (uint32_t) pos.j * 5 + (uint32_t) pos.k * 7) & (CACHE_SIZE - 1);
+
+    if ((cache->used & (1u << slot)) &&
+        cache->pos[slot].i == pos.i && cache->pos[slot].j == pos.j && cache->pos[slot].k == pos.k) {
+        return cache->chunk[slot];
+    }
+
+    Chunk* chunk = world_get_chunk(world, pos);
+    cache->pos[slot] = pos;
+    cache->chunk[slot] = chunk;
+    cache->used |= 1u << slot;
+    return chunk;
+}
+
+static bool cast (World* world, struct chunk_cache* cache, Vec3f origin, Vec3f dir, float maxdist, BlockHit* hit) {
+    if (!(maxdist < RAYCAST_MAX_DIST)) maxdist = RAYCAST_MAX_DIST;
+
+    float o[3] = {origin.x, origin.y, origin.z};
+    float d[3] = {dir.x, dir.y, dir.z};
+
+    // Traversal State.
+    //  - tmax: distance to the next cell boundary on each axis.
+    //  - tdelta: distance between cell boundaries on each axis.
+    int32_t cell[3], step[3];
+    float tmax[3], tdelta[3];
+
+    for (int a = 0; a < 3; a++) {
+        cell[a] = (int32_t) floorf(o[a]);
+        if (d[a] > 0) {
+            step[a] = 1;
+            tdelta[a] = 1 / d[a];
+            tmax[a] = (cell[a] + 1 - o[a]) * tdelta[a];
+        } else if (d[a] < 0) {
+            step[a] = -1;
+            tdelta[a] = -1 / d[a];
+            tmax[a] = (o[a] - cell[a]) * tdelta[a];
+        } else {
+            step[a] = 0;
+            tdelta[a] = INFINITY;
+            tmax[a] = INFINITY;
+        }
+    }
+
+    float t = 0;
+    int axis = -1;
+
+    Vec3i chunk_pos = chunk_coords(cell[0], cell[1], cell[2]);
+    Chunk* chunk = cache_get(world, cache, chunk_pos);
+
+    while (true) {
+        Vec3i pos = chunk_coords(cell[0], cell[1], cell[2]);
+        if (pos.i != chunk_pos.i || pos.j != chunk_pos.j || pos.k != chunk_pos.k) {
+            chunk_pos = pos;
+            chunk = cache_get(world, cache, pos);
+        }
+
+        // Empty Chunk: jump to the first cell past it.
+        if (chunk == NULL || (chunk_is_uniform(chunk) && chunk->palette[0] == BLOCK_AIR)) {
+            int32_t cross[3];
+            float texit = INFINITY;
+            int exit_axis = -1;
+
+            for (int a = 0; a < 3; a++) {
+                if (step[a] == 0) continue;
+                int32_t local = cell[a] & CHUNK_MASK;
+                cross[a] = step[a] > 0 ? CHUNK_SIZE - local : local + 1;
+
+                float ta = tmax[a] + (cross[a] - 1) * tdelta[a];
+                if (ta < texit) {
+                    texit = ta;
+                    exit_axis = a;
+                }
+            }
+
+            if (exit_axis < 0 || texit > maxdist) break;
+
+            // Cell boundaries crossed on each axis before the exit (the exit axis leaves the chunk).
+            for (int a = 0; a < 3; a++) {
+                if (step[a] == 0) continue;
+
+                int32_t k;
+                if (a == exit_axis) {
+                    k = cross[a];
+                } else if (tmax[a] >= texit) {
+                    k = 0;
+                } else {
+                    k = (int32_t) ((texit - tmax[a]) / tdelta[a]) + 1;
+                    if (k > cross[a] - 1) k = cross[a] - 1;
+                }
+
+                cell[a] += k * step[a];
+                tmax[a] += k * tdelta[a];
+            }
+
+            t = texit;
+            axis = exit_axis;
+            continue;
+        }
+
+        uint16_t block = chunk_get(chunk, chunk_index(cell[0], cell[1], cell[2]));
+        if (block != BLOCK_AIR) {
+            int32_t normal[3] = {0, 0, 0};
+            if (axis >= 0) normal[axis] = -step[axis];
+
+            hit->type = block;
+            hit->dist = t;
+            hit->block = (Vec3i) {cell[0], cell[1], cell[2]};
+            hit->normal = (Vec3i) {normal[0], normal[1], normal[2]};
+            return true;
+        }
+
+        // Next Cell.
+        axis = tmax[0] < tmax[1] ? (tmax[0] < tmax[2] ? 0 : 2) : (tmax[1] < tmax[2] ? 1 : 2);
+        t = tmax[axis];
+        if (t > maxdist) break;
+
+        cell[axis] += step[axis];
+        tmax[axis] += tdelta[axis];
+    }
+
+    hit->type = BLOCK_AIR;
+    hit->dist = maxdist;
+    return false;
+}
+
+bool world_raycast (World* world, Vec3f origin, Vec3f dir, float maxdist, BlockHit* hit) {
+    struct chunk_cache cache;
+    cache.used = 0;
+
+    return cast(world, &cache, origin, dir, maxdist, hit);
+}
+
+void world_raycast_batch (World* world, const Vec3f* origins, const Vec3f* dirs, const float* maxdists,
+                          uint32_t count, BlockHit* hits) {
+    struct chunk_cache cache;
+    cache.used = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        cast(world, &cache, origins[i], dirs[i], maxdists[i], &hits[i]);
+    }
+}
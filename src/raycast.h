@@ -0,0 +1,32 @@
+#pragma once
+
+#include "main.h"
+
+// VOXEL RAYCASTS
+//
+// - Rays walk the block grid cell by cell (Amanatides & Woo), so every block the ray
+//   passes through is visited exactly once, in order, and nothing else is.
+// - Missing chunks and uniform air chunks are crossed in one step, straight to the
+//   cell where the ray leaves them. A uniform solid chunk is hit on entry.
+// - Any block but air counts as a hit.
+// - Chunk lookups are cached (the last chunk for single rays, a small table shared by
+//   the rays of a batch), so most cells cost one palette read. Nothing is allocated.
+// - Entities are not considered, see env_raycast for those.
+
+struct block_hit {
+    uint16_t type;      // BLOCK_AIR if nothing was hit.
+    float dist;
+    Vec3i block;
+    Vec3i normal;       // Face the ray entered through, (0,0,0) if it started inside.
+};
+
+// Closest block along a ray.
+//  - 'dir' must be normalized.
+//  - Returns false (and hit->type BLOCK_AIR) if nothing was hit within 'maxdist'.
+bool world_raycast (World* world, Vec3f origin, Vec3f dir, float maxdist, BlockHit* hit);
+
+// Cast 'count' rays in a row, sharing chunk lookups (hits[i] belongs to ray i).
+//  - 'dirs' must be normalized. Each ray has its own 'maxdists[i]'.
+//  - Line of sight: cast towards the target with the distance to it, clear if nothing was hit.
+void world_raycast_batch (World* world, const Vec3f* origins, const Vec3f* dirs, const float* maxdists,
+                          uint32_t count, BlockHit* hits);
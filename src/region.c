@@ -0,0 +1,325 @@
+#include "region.h"
+
+#include "array.h"
+#include "world.h"
+#include "entity.h"
+#include "lodepng.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+// Create a directory and its parents.
+static void make_dirs (const char* dir) {
+    char path[strlen(dir) + 1];
+    strcpy(path, dir);
+    for (char* p = path + 1; *p != '\0'; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            mkdir(path, 0755);
+            *p = '/';
+        }
+    }
+    mkdir(path, 0755);
+}
+
+static Vec3i region_of (Vec3i chunk) {
+    return (Vec3i) {DIV(chunk.i, REGION_SIZE), chunk.j, DIV(chunk.k, REGION_SIZE)};
+}
+
+static uint32_t entry_of (Vec3i chunk) {
+    return MOD(chunk.k, REGION_SIZE) * REGION_SIZE + MOD(chunk.i, REGION_SIZE);
+}
+
+static void region_close (Region* region) {
+    if (region->map != NULL) munmap(region->map, region->map_size);
+    close(region->fd);
+    free(region);
+}
+
+// Map the whole file (lock must be held).
+static bool region_map (Region* region) {
+    struct stat st;
+    if (fstat(region->fd, &st) != 0) return false;
+
+    if (region->map != NULL) munmap(region->map, region->map_size);
+    region->map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, region->fd, 0);
+    if (region->map == MAP_FAILED) {
+        region->map = NULL;
+        region->map_size = 0;
+        return false;
+    }
+    region->map_size = st.st_size;
+    region->sectors = st.st_size / REGION_SECTOR;
+
+    return true;
+}
+
+// Find or open the region holding a chunk (lock must be held).
+//  - Returns NULL if the file doesn't exist and 'create' is false.
+static Region* region_get (RegionStore* store, Vec3i chunk, bool create) {
+    Vec3i pos = region_of(chunk);
+    store->clock++;
+
+    for (int i = 0; i < store->regions->size; i++) {
+        Region* region = store->regions->data[i];
+        if (region->pos.i == pos.i && region->pos.j == pos.j && region->pos.k == pos.k) {
+            region->last_use = store->clock;
+            return region;
+        }
+    }
+
+    // Open (creating an empty table if needed).
+    char file[strlen(store->dir) + 64];
+    snprintf(file, sizeof(file), "%s/r.%d.%d.%d.bin", store->dir, pos.i, pos.j, pos.k);
+
+    int fd = open(file, create ? O_RDWR | O_CREAT : O_RDWR, 0644);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (st.st_size < REGION_SECTOR && ftruncate(fd, REGION_SECTOR) != 0)) {
+        close(fd);
+        return NULL;
+    }
+
+    // Allocate and Initialize.
+    Region* region = malloc(sizeof(Region));
+    region->pos = pos;
+    region->fd = fd;
+    region->map = NULL;
+    region->map_size = 0;
+    region->sectors = 0;
+    region->last_use = store->clock;
+
+    if (!region_map(region)) {
+        region_close(region);
+        return NULL;
+    }
+
+    // Close the least recently used.
+    if (store->regions->size >= REGION_MAX_OPEN) {
+        int oldest = 0;
+        for (int i = 1; i < store->regions->size; i++) {
+            Region* r = store->regions->data[i];
+            if (r->last_use < ((Region*) store->regions->data[oldest])->last_use) oldest = i;
+        }
+        region_close(array_remove(store->regions, oldest));
+    }
+
+    array_add(store->regions, region);
+    return region;
+}
+
+// Check for region files in a directory.
+static bool has_regions (const char* dir) {
+    DIR* d = opendir(dir);
+    if (d == NULL) return false;
+
+    bool found = false;
+    struct dirent* entry;
+    while (!found && (entry = readdir(d)) != NULL) {
+        size_t length = strlen(entry->d_name);
+        found = strncmp(entry->d_name, "r.", 2) == 0 && length > 6 && strcmp(entry->d_name + length - 4, ".bin") == 0;
+    }
+
+    closedir(d);
+    return found;
+}
+
+RegionStore* regionstore_create (const char* dir) {
+    make_dirs(dir);
+
+    // Allocate and Initialize.
+    RegionStore* store = malloc(sizeof(RegionStore));
+    store->dir = strdup(dir);
+    store->empty = !has_regions(dir);
+    store->regions = array_create();
+    store->clock = 0;
+    pthread_mutex_init(&store->lock, NULL);
+
+    return store;
+}
+
+void regionstore_destroy (RegionStore* store) {
+    for (int i = 0; i < store->regions->size; i++) {
+        region_close(store->regions->data[i]);
+    }
+    array_destroy(store->regions);
+    pthread_mutex_destroy(&store->lock);
+    free(store->dir);
+    free(store);
+}
+
+bool regionstore_load (RegionStore* store, Chunk* chunk, SavedEntities* saved) {
+    *saved = (SavedEntities) {0};
+
+    // Copy the compressed record out.
+    pthread_mutex_lock(&store->lock);
+
+    Region* region = region_get(store, chunk->pos, false);
+    uint8_t* record = NULL;
+    uint32_t sizes[2];
+
+    if (region != NULL) {
+        uint32_t entry;
+        memcpy(&entry, region->map + entry_of(chunk->pos) * 4, 4);
+        size_t offset = (size_t) (entry >> 8) * REGION_SECTOR;
+        size_t length = (size_t) (entry & 0xFF) * REGION_SECTOR;
+
+        bool mapped = offset + length <= region->map_size || region_map(region);
+        if (entry != 0 && mapped && offset + length <= region->map_size) {
+            memcpy(sizes, region->map + offset, 8);
+            if (sizes[0] <= length - 8) {
+                record = malloc(sizes[0]);
+                memcpy(record, region->map + offset + 8, sizes[0]);
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&store->lock);
+
+    if (record == NULL) return false;
+
+    // Decompress and Decode.
+    uint8_t* raw = NULL;
+    size_t raw_size = 0;
+    LodePNGDecompressSettings settings;
+    lodepng_decompress_settings_init(&settings);
+    unsigned error = lodepng_zlib_decompress(&raw, &raw_size, record, sizes[0], &settings);
+    free(record);
+
+    // Sections: blocks, entities, payloads (each after a uint32 size or count).
+    bool valid = error == 0 && raw_size == sizes[1] && raw_size >= 12;
+    uint32_t block_bytes = 0, entity_count = 0, data_bytes = 0;
+    size_t entity_offset = 0, data_offset = 0;
+    if (valid) {
+        memcpy(&block_bytes, raw, 4);
+        valid = (size_t) block_bytes + 12 <= raw_size;
+    }
+    if (valid) {
+        memcpy(&entity_count, raw + 4 + block_bytes, 4);
+        entity_offset = 8 + (size_t) block_bytes;
+        valid = entity_offset + (size_t) entity_count * sizeof(SavedEntity) + 4 <= raw_size;
+    }
+    if (valid) {
+        data_offset = entity_offset + (size_t) entity_count * sizeof(SavedEntity) + 4;
+        memcpy(&data_bytes, raw + data_offset - 4, 4);
+        valid = raw_size == data_offset + data_bytes;
+    }
+    if (valid) {
+        valid = chunk_deserialize(chunk, raw + 4, block_bytes);
+    }
+    if (valid && entity_count > 0) {
+        saved->entities = malloc(entity_count * sizeof(SavedEntity));
+        memcpy(saved->entities, raw + entity_offset, entity_count * sizeof(SavedEntity));
+        saved->count = entity_count;
+
+        // Payloads must stay within their section.
+        for (uint32_t i = 0; i < entity_count; i++) {
+            SavedEntity* e = &saved->entities[i];
+            if ((uint64_t) e->data_offset + e->data_size > data_bytes || e->data_size > ENTITY_SAVE_MAX) {
+                e->data_offset = 0;
+                e->data_size = 0;
+            }
+        }
+    }
+    if (valid && data_bytes > 0) {
+        saved->data = malloc(data_bytes);
+        memcpy(saved->data, raw + data_offset, data_bytes);
+        saved->data_size = data_bytes;
+    }
+
+    free(raw);
+    return valid;
+}
+
+bool regionstore_save (RegionStore* store, const Chunk* chunk, const SavedEntities* saved) {
+    // Encode and Compress.
+    size_t entity_bytes = saved->count * sizeof(SavedEntity);
+    size_t raw_capacity = 12 + CHUNK_SERIAL_MAX + entity_bytes + saved->data_size;
+    uint8_t* raw = malloc(raw_capacity);
+    uint32_t block_bytes = chunk_serialize(chunk, raw + 4);
+    memcpy(raw, &block_bytes, 4);
+
+    uint8_t* p = raw + 4 + block_bytes;
+    memcpy(p, &saved->count, 4);
+    if (entity_bytes > 0) memcpy(p + 4, saved->entities, entity_bytes);
+    p += 4 + entity_bytes;
+    memcpy(p, &saved->data_size, 4);
+    if (saved->data_size > 0) memcpy(p + 4, saved->data, saved->data_size);
+    size_t raw_size = (p + 4 + saved->data_size) - raw;
+
+    uint8_t* compressed = NULL;
+    size_t compressed_size = 0;
+    LodePNGCompressSettings settings;
+    lodepng_compress_settings_init(&settings);
+    unsigned error = lodepng_zlib_compress(&compressed, &compressed_size, raw, raw_size, &settings);
+    free(raw);
+
+    uint32_t sectors = (compressed_size + 8 + REGION_SECTOR - 1) / REGION_SECTOR;
+    if (error != 0 || sectors > 0xFF) {
+        free(compressed);
+        return false;
+    }
+
+    // Record (padded to whole sectors).
+    uint8_t* record = calloc(sectors, REGION_SECTOR);
+    uint32_t sizes[2] = {compressed_size, raw_size};
+    memcpy(record, sizes, 8);
+    memcpy(record + 8, compressed, compressed_size);
+    free(compressed);
+
+    pthread_mutex_lock(&store->lock);
+
+    bool written = false;
+    Region* region = region_get(store, chunk->pos, true);
+    if (region != NULL && region->sectors + sectors <= 0xFFFFFF) {
+        uint32_t index = entry_of(chunk->pos);
+
+        // Append the record, then point the table at it (the old record stays valid until then).
+        uint32_t first = region->sectors;
+        region->sectors += sectors;
+
+        uint32_t entry = first << 8 | sectors;
+        written = pwrite(region->fd, record, (size_t) sectors * REGION_SECTOR, (off_t) first * REGION_SECTOR)
+                    == (ssize_t) sectors * REGION_SECTOR
+             && pwrite(region->fd, &entry, 4, index * 4) == 4;
+    }
+    if (written) store->empty = false;
+
+    pthread_mutex_unlock(&store->lock);
+
+    free(record);
+    return written;
+}
+
+bool regionstore_is_empty (RegionStore* store) {
+    pthread_mutex_lock(&store->lock);
+    bool empty = store->empty;
+    pthread_mutex_unlock(&store->lock);
+
+    return empty;
+}
+
+void savedentities_add (SavedEntities* saved, SavedEntity entity, const uint8_t* data, uint32_t size) {
+    entity.data_offset = saved->data_size;
+    entity.data_size = size;
+
+    saved->entities = realloc(saved->entities, (saved->count + 1) * sizeof(SavedEntity));
+    saved->entities[saved->count++] = entity;
+
+    if (size > 0) {
+        saved->data = realloc(saved->data, saved->data_size + size);
+        memcpy(saved->data + saved->data_size, data, size);
+        saved->data_size += size;
+    }
+}
+
+void savedentities_clear (SavedEntities* saved) {
+    free(saved->entities);
+    free(saved->data);
+    *saved = (SavedEntities) {0};
+}
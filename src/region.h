@@ -0,0 +1,102 @@
+#pragma once
+
+#include "main.h"
+
+#include <pthread.h>
+
+// REGION FILES
+//
+// - Saved chunks are grouped into region files of 32x32 chunks (along x and z, one file
+//   per chunk layer along y), named r.<x>.<y>.<z>.bin under the store's directory.
+// - A region file is a list of 4KB sectors. Sector 0 is the allocation table: one
+//   uint32 per chunk, (first sector << 8) | sector count, 0 for chunks never saved.
+// - Each chunk record is: uint32 compressed size, uint32 raw size, then the zlib stream
+//   (lodepng) of: uint32 block bytes, chunk_serialize data, uint32 entity count and
+//   that many SavedEntity, uint32 payload bytes and the payloads (entity on_save data).
+// - Files are memory-mapped for reads, so loading one chunk only touches its own
+//   sectors. Saves go through pwrite: the new record is always appended at the end of
+//   the file, and only then does its table entry change. Records are never overwritten,
+//   so a save cut short leaves the table pointing at the previous, intact record.
+//   The sectors of replaced records are not reclaimed (files only grow).
+// - At most REGION_MAX_OPEN files are kept open (least recently used are closed).
+// - All functions are thread-safe (one lock, held for file access, not for compression).
+
+#define REGION_DIR "save/region"
+#define REGION_SIZE 32
+#define REGION_SECTOR 4096
+#define REGION_MAX_OPEN 16
+
+// Persistent state of an entity (see streamer.h).
+//  - 'parent' is the index of the parent record, or -1.
+//  - The type-specific state (on_save, see entity.h) is 'data_size' bytes at 'data_offset'
+//    in the payloads of the chunk's SavedEntities.
+struct saved_entity {
+    uint32_t id;
+    uint32_t type_id;
+    int32_t parent;
+    uint32_t flags;
+
+    Vec3f pos;
+    Vec3f vel;
+    Vec4f rot;
+    Vec3f scale;
+
+    uint32_t data_offset;
+    uint32_t data_size;
+};
+
+// Saved entities of a chunk, and their payloads.
+struct saved_entities {
+    SavedEntity* entities;
+    uint32_t count;
+
+    uint8_t* data;
+    uint32_t data_size;
+};
+
+struct region {
+    // Region Coordinates (chunk x and z divided by REGION_SIZE, chunk y).
+    Vec3i pos;
+
+    int fd;
+
+    // Read Mapping (remapped when the file grew past it).
+    uint8_t* map;
+    size_t map_size;
+
+    // File Size (sectors).
+    uint32_t sectors;
+
+    uint64_t last_use;
+};
+
+struct region_store {
+    char* dir;
+
+    // Nothing saved yet (no region files when created, and no saves since).
+    bool empty;
+
+    // Open Regions.
+    Array* regions;
+    uint64_t clock;
+
+    pthread_mutex_t lock;
+};
+
+// Create and Destroy Region Stores (creates the directory if needed).
+RegionStore* regionstore_create (const char* dir);
+void regionstore_destroy (RegionStore* store);
+
+// Load a chunk into a detached chunk, with its entities (release them with savedentities_clear).
+//  - Returns false if the chunk was never saved (or the record is damaged).
+bool regionstore_load (RegionStore* store, Chunk* chunk, SavedEntities* saved);
+
+// Save a chunk and its entities.
+bool regionstore_save (RegionStore* store, const Chunk* chunk, const SavedEntities* saved);
+
+// Check if the store holds no saves at all (a new world).
+bool regionstore_is_empty (RegionStore* store);
+
+// Append an entity record with its payload, and free everything.
+void savedentities_add (SavedEntities* saved, SavedEntity entity, const uint8_t* data, uint32_t size);
+void savedentities_clear (SavedEntities* saved);
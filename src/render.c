@@ -1,38 +1,46 @@
 #include "render.h"
 
+#include "glext.h"
+#include "shadercache.h"
 #include "lodepng.h"
 
-// Static helper to load and compile a shader unit from a file.
-static GLuint load_shader_file (const char* file, GLenum stage) {
+// Static helper to read a whole text file (caller frees).
+static char* read_text_file (const char* file) {
     // Open file.
-    FILE* f = fopen(file, "r");
+    FILE* f = fopen(file, "rb");
     if (f == NULL) {
         printf("Cannot open shader file: %s\n", file);
-        return 0;
+        return NULL;
     }
 
-    // Create Buffer (4k max size).
-    int max_size = 1024*4;
-    char text[max_size+1];
+    // Get Size.
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(f);
+        return NULL;
+    }
 
     // Read from file.
-    int c;
-    int text_size = 0;
-    while (text_size < max_size && (c = fgetc(f)) != EOF) {
-        text[text_size] = c;
-        text_size++;
-    }
+    char* text = malloc(size + 1);
+    size_t text_size = fread(text, 1, size, f);
     text[text_size] = '\0';
 
     // Close File.
     fclose(f);
 
+    return text;
+}
+
+// Static helper to compile a shader unit.
+static GLuint compile_shader (const char* text, const char* file, GLenum stage) {
     // Create Shader.
     GLuint shader = glCreateShader(stage);
 
     // Upload Shader Text.
     const char* text_list [] = { text };
-    glShaderSource(shader, 1, text_list , &text_size);
+    glShaderSource(shader, 1, text_list, NULL);
 
     // Compile Shader.
     glCompileShader(shader);
@@ -41,9 +49,10 @@ static GLuint load_shader_file (const char* file, GLenum stage) {
     int result;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE) {
-        printf("SHADER COMPILE ERROR: %s\n", file);
-        glGetShaderInfoLog(shader, max_size, NULL, text);
-        printf("%s\n", text);
+        char log[4096];
+        printf("SHADER COMPILE ERROR: %s%s\n", file, stage == GL_VERTEX_SHADER ? ".vs" : ".fs");
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        printf("%s\n", log);
         glDeleteShader(shader);
         return 0;
     }
@@ -51,48 +60,88 @@ static GLuint load_shader_file (const char* file, GLenum stage) {
     return shader;
 }
 
-Shader* shader_create (const char* name) {
-    // Shader file name buffer.
-    int len = strlen(name) + 24;
-    char file[len];
-
+// Static helper to compile and link a program from source.
+static GLuint link_program (const char* vs_text, const char* fs_text, const char* name) {
     // Vertex Shader.
-    snprintf(file, len, "%s.vs", name);
-    GLuint vs = load_shader_file(file, GL_VERTEX_SHADER);
+    GLuint vs = compile_shader(vs_text, name, GL_VERTEX_SHADER);
     if (vs == 0) {
-        return NULL;
+        return 0;
     }
 
     // Fragment Shader.
-    snprintf(file, len, "%s.fs", name);
-    GLuint fs = load_shader_file(file, GL_FRAGMENT_SHADER);
+    GLuint fs = compile_shader(fs_text, name, GL_FRAGMENT_SHADER);
     if (fs == 0) {
         glDeleteShader(vs);
-        return NULL;
+        return 0;
     }
 
     // Shader Program.
     GLuint shader_id = glCreateProgram();
 
+    // Ask to keep the binary around for the program cache.
+    if (GLEXT.program_binary) {
+        GLEXT.ProgramParameteri(shader_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     // Attach and Link.
     glAttachShader(shader_id, vs);
     glAttachShader(shader_id, fs);
     glLinkProgram(shader_id);
 
+    // Delete Shaders.
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
     int result;
     glGetProgramiv(shader_id, GL_LINK_STATUS, &result);
     if (result == GL_FALSE) {
         char text[4096];
-        printf("SHADER LINK ERROR\n");
+        printf("SHADER LINK ERROR: %s\n", name);
         glGetProgramInfoLog(shader_id, 4096, NULL, text);
         printf("%s\n", text);
-        glDeleteShader(shader_id);
+        glDeleteProgram(shader_id);
+        return 0;
+    }
+
+    return shader_id;
+}
+
+Shader* shader_create (const char* name) {
+    // Shader file name buffer.
+    int len = strlen(name) + 24;
+    char file[len];
+
+    // Vertex Shader Source.
+    snprintf(file, len, "%s.vs", name);
+    char* vs_text = read_text_file(file);
+    if (vs_text == NULL) {
         return NULL;
     }
 
-    // Delete Shaders.
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    // Fragment Shader Source.
+    snprintf(file, len, "%s.fs", name);
+    char* fs_text = read_text_file(file);
+    if (fs_text == NULL) {
+        free(vs_text);
+        return NULL;
+    }
+
+    // Try the program cache first, compile on a miss.
+    uint64_t key = shadercache_key(vs_text, fs_text);
+    GLuint shader_id = shadercache_load(key);
+    if (shader_id == 0) {
+        shader_id = link_program(vs_text, fs_text, name);
+        if (shader_id != 0) {
+            shadercache_store(key, shader_id);
+        }
+    }
+
+    free(vs_text);
+    free(fs_text);
+
+    if (shader_id == 0) {
+        return NULL;
+    }
 
     // Allocate and Initialize.
     Shader* shader = malloc(sizeof(struct shader));
@@ -105,7 +154,9 @@ Shader* shader_create (const char* name) {
     shader->uniforms.obj_color = glGetUniformLocation(shader_id, "C");
     shader->uniforms.obj_texture = glGetUniformLocation(shader_id, "T");
     shader->uniforms.image = glGetUniformLocation(shader_id, "image");
+    shader->uniforms.image_array = glGetUniformLocation(shader_id, "image_array");
     shader->uniforms.use_image = glGetUniformLocation(shader_id, "use_image");
+    shader->uniforms.layer = glGetUniformLocation(shader_id, "layer");
 
     // Slot Initialization.
     for (int i = 0; i < SHADER_MAX_SHAPES; i++) {
@@ -118,6 +169,7 @@ Shader* shader_create (const char* name) {
     // Image Preparation.
     glUseProgram(shader_id);
     glUniform1i(shader->uniforms.image, 0);
+    glUniform1i(shader->uniforms.image_array, 1);
     glUseProgram(0);
 
     return shader;
@@ -136,7 +188,22 @@ void shader_destroy (Shader* shader) {
     free(shader);
 }
 
+void shape_bind_attributes () {
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glVertexAttribPointer(ATTRIB_POSITION, 4, GL_FLOAT, GL_FALSE, 52, 0);
+    glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+    glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 52, (void*)16);
+    glEnableVertexAttribArray(ATTRIB_COLOR);
+    glVertexAttribPointer(ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE, 52, (void*)24);
+    glEnableVertexAttribArray(ATTRIB_NORMAL);
+    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 52, (void*)40);
+}
+
 Shape* shape_create (const float* data, GLuint size, GLenum type) {
+    return shape_create_usage(data, size, type, GL_STATIC_DRAW);
+}
+
+Shape* shape_create_usage (const float* data, GLuint size, GLenum type, GLenum usage) {
     // VAO and VBO IDs.
     GLuint vao_id, vbo_id;
 
@@ -150,17 +217,10 @@ Shape* shape_create (const float* data, GLuint size, GLenum type) {
 
     // Upload Buffer Data.
     GLuint length = size * 13 * sizeof(float);
-    glBufferData(GL_ARRAY_BUFFER, length, data, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, length, data, usage);
 
     // Bind Attributes.
-    glEnableVertexAttribArray(ATTRIB_POSITION);
-    glVertexAttribPointer(ATTRIB_POSITION, 4, GL_FLOAT, GL_FALSE, 52, 0);
-    glEnableVertexAttribArray(ATTRIB_TEXCOORD);
-    glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 52, (void*)16);
-    glEnableVertexAttribArray(ATTRIB_COLOR);
-    glVertexAttribPointer(ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE, 52, (void*)24);
-    glEnableVertexAttribArray(ATTRIB_NORMAL);
-    glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, 52, (void*)40);
+    shape_bind_attributes();
 
     // Cleanup.
     glBindVertexArray(0);
@@ -169,13 +229,167 @@ Shape* shape_create (const float* data, GLuint size, GLenum type) {
     Shape* shape = malloc(sizeof(struct shape));
     shape->vao_id = vao_id;
     shape->vbo_id = vbo_id;
+    shape->ebo_id = 0;
     shape->size = size;
+    shape->capacity = size;
+    shape->index_count = 0;
+    shape->index_type = GL_UNSIGNED_INT;
     shape->type = type;
+    shape->usage = usage;
+    shape->format = SHAPE_FORMAT_FLOAT;
+    shape->stride = 13 * sizeof(float);
+
+    return shape;
+}
+
+// Shared index buffer for packed quads (0,1,2, 0,2,3 per quad).
+static GLuint quad_ebo_id = 0;
+
+static GLuint get_quad_indices () {
+    if (quad_ebo_id != 0) return quad_ebo_id;
+
+    uint16_t* indices = malloc(SHAPE_MAX_QUADS * 6 * sizeof(uint16_t));
+    for (uint32_t q = 0; q < SHAPE_MAX_QUADS; q++) {
+        uint16_t v = q * 4;
+        uint16_t* i = indices + q * 6;
+        i[0] = v; i[1] = v + 1; i[2] = v + 2;
+        i[3] = v; i[4] = v + 2; i[5] = v + 3;
+    }
+
+    glGenBuffers(1, &quad_ebo_id);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_ebo_id);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, SHAPE_MAX_QUADS * 6 * sizeof(uint16_t), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    free(indices);
+
+    return quad_ebo_id;
+}
+
+Shape* shape_create_packed (const uint32_t* data, GLuint size, GLenum usage) {
+    GLuint ebo_id = get_quad_indices();
+
+    // VAO and VBO IDs.
+    GLuint vao_id, vbo_id;
+
+    // Create VAO.
+    glGenVertexArrays(1, &vao_id);
+    glBindVertexArray(vao_id);
+
+    // Create VBO.
+    glGenBuffers(1, &vbo_id);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
+    glBufferData(GL_ARRAY_BUFFER, size * 2 * sizeof(uint32_t), data, usage);
+
+    // Bind Attributes (integer, not normalized).
+    glEnableVertexAttribArray(ATTRIB_PACKED);
+    glVertexAttribIPointer(ATTRIB_PACKED, 2, GL_UNSIGNED_INT, 8, 0);
+
+    // Shared EBO (recorded in the VAO).
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_id);
+
+    // Cleanup.
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    // Allocate and Initalize.
+    Shape* shape = malloc(sizeof(struct shape));
+    shape->vao_id = vao_id;
+    shape->vbo_id = vbo_id;
+    shape->ebo_id = ebo_id;
+    shape->size = size;
+    shape->capacity = size;
+    shape->index_count = size / 4 * 6;
+    shape->index_type = GL_UNSIGNED_SHORT;
+    shape->type = GL_TRIANGLES;
+    shape->usage = usage;
+    shape->format = SHAPE_FORMAT_PACKED;
+    shape->stride = 2 * sizeof(uint32_t);
 
     return shape;
 }
 
+Shape* shape_create_indexed (const float* data, GLuint size, const uint32_t* indices, GLuint index_count, GLenum type) {
+    Shape* shape = shape_create(data, size, type);
+
+    // Create EBO (recorded in the VAO).
+    glBindVertexArray(shape->vao_id);
+    glGenBuffers(1, &shape->ebo_id);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shape->ebo_id);
+
+    if (size <= 0x10000) {
+        // Narrow to 16-bit.
+        uint16_t* narrow = malloc(index_count * sizeof(uint16_t));
+        for (GLuint i = 0; i < index_count; i++) narrow[i] = indices[i];
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(uint16_t), narrow, GL_STATIC_DRAW);
+        free(narrow);
+        shape->index_type = GL_UNSIGNED_SHORT;
+    } else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+        shape->index_type = GL_UNSIGNED_INT;
+    }
+
+    // Cleanup.
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    shape->index_count = index_count;
+
+    return shape;
+}
+
+bool shape_update (Shape* shape, const void* data, GLuint first_vertex, GLuint count) {
+    if (first_vertex + count > shape->capacity) {
+        return false;
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, shape->vbo_id);
+
+    // Orphan the old storage when the whole shape is replaced,
+    // so the upload doesn't wait on draws still using it.
+    if (first_vertex == 0 && count >= shape->size) {
+        glBufferData(GL_ARRAY_BUFFER, shape->capacity * shape->stride, NULL, shape->usage);
+    }
+
+    // Upload Sub-Range.
+    glBufferSubData(GL_ARRAY_BUFFER, first_vertex * shape->stride, count * shape->stride, data);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (first_vertex + count > shape->size) {
+        shape->size = first_vertex + count;
+    }
+
+    if (shape->format == SHAPE_FORMAT_PACKED) {
+        shape->index_count = shape->size / 4 * 6;
+    }
+
+    return true;
+}
+
+void shape_resize (Shape* shape, const void* data, GLuint size) {
+    glBindBuffer(GL_ARRAY_BUFFER, shape->vbo_id);
+
+    if (size > shape->capacity || size < shape->capacity / 4) {
+        // Reallocate Storage.
+        glBufferData(GL_ARRAY_BUFFER, size * shape->stride, data, shape->usage);
+        shape->capacity = size;
+    } else {
+        // Orphan and Upload.
+        glBufferData(GL_ARRAY_BUFFER, shape->capacity * shape->stride, NULL, shape->usage);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size * shape->stride, data);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    shape->size = size;
+
+    if (shape->format == SHAPE_FORMAT_PACKED) {
+        shape->index_count = size / 4 * 6;
+    }
+}
+
 void shape_destroy (Shape* shape) {
+    // Packed shapes share their EBO.
+    if (shape->ebo_id != 0 && shape->format != SHAPE_FORMAT_PACKED) glDeleteBuffers(1, &shape->ebo_id);
     glDeleteBuffers(1, &shape->vbo_id);
     glDeleteVertexArrays(1, &shape->vao_id);
     free(shape);
@@ -195,6 +409,17 @@ Image* image_create (const char* file) {
         return NULL;
     }
 
+    // Upload.
+    Image* image = image_create_pixels(data, width, height);
+
+    // Release Image Data.
+    free(data);
+
+    // Return
+    return image;
+}
+
+Image* image_create_pixels (const uint8_t* data, GLuint width, GLuint height) {
     // Generate OpenGL Texture to store the image.
     GLuint image_id;
     glGenTextures(1, &image_id);
@@ -212,63 +437,118 @@ Image* image_create (const char* file) {
     // Unbind Texture.
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    // Release Image Data.
-    free(data);
-
     // Allocate and Initialize.
     Image* image = malloc(sizeof(Image));
     image->image_id = image_id;
+    image->state = IMAGE_READY;
+    image->target = GL_TEXTURE_2D;
     image->width = width;
     image->height = height;
+    image->layers = 1;
 
     // Return
     return image;
 }
 
+Image* image_create_array (const char** files, GLuint count) {
+    // Size of image (taken from the first layer).
+    GLuint width = 0, height = 0;
+
+    // Generate OpenGL Texture to store the layers.
+    GLuint image_id;
+    glGenTextures(1, &image_id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, image_id);
+
+    for (GLuint i = 0; i < count; i++) {
+        // Decode.
+        uint8_t* data;
+        GLuint w, h;
+        uint32_t result = lodepng_decode32_file(&data, &w, &h, files[i]);
+        if (result != 0) {
+            printf("Texture Load Error %d: %s\n", result, files[i]);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            glDeleteTextures(1, &image_id);
+            return NULL;
+        }
+
+        // Allocate storage for all layers.
+        if (i == 0) {
+            width = w;
+            height = h;
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, count, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+
+        if (w != width || h != height) {
+            printf("Texture Array Size Mismatch: %s\n", files[i]);
+            free(data);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            glDeleteTextures(1, &image_id);
+            return NULL;
+        }
+
+        // Upload Layer.
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        free(data);
+    }
+
+    // Set Texture Parameters.
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    // Unbind Texture.
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // Allocate and Initialize.
+    Image* image = malloc(sizeof(Image));
+    image->image_id = image_id;
+    image->state = IMAGE_READY;
+    image->target = GL_TEXTURE_2D_ARRAY;
+    image->width = width;
+    image->height = height;
+    image->layers = count;
+
+    return image;
+}
+
 void image_destroy (Image* image) {
-    glDeleteTextures(1, &image->image_id);
+    // Still loading, the image loader releases it once the decode is done.
+    if (image->state == IMAGE_LOADING) {
+        image->state = IMAGE_CANCELLED;
+        return;
+    }
+
+    // Failed images only ever referenced the placeholder.
+    if (image->state == IMAGE_READY) {
+        glDeleteTextures(1, &image->image_id);
+    }
     free(image);
 }
 
 void drawinfo_init (DrawInfo* drawinfo) {
     *drawinfo = (DrawInfo) {
         .shape = NULL,
-        .model = (Mat4f) {
-            1,0,0,0,
-            0,1,0,0,
-            0,0,1,0,
-            0,0,0,1,
-        },
+        .model = mat4f_identity(),
         .image = NULL,
         .color = (Vec4f) {1,1,1,1},
         .texture = (Vec4f) {0,0,1,1},
+        .layer = 0,
         .enable_depthtest = true,
         .enable_depthmask = false,
         .enable_culling = true,
+        .first = 0,
+        .count = 0,
     };
 }
 
 void shader_set_projection (Shader* shader, Mat4f* p) {
     glUseProgram(shader->shader_id);
-    // float data[] = {
-    //     p->ax, p->bx, p->cx, p->dx,
-    //     p->ay, p->by, p->cy, p->dy,
-    //     p->az, p->bz, p->cz, p->dz,
-    //     p->aw, p->bw, p->cw, p->dw
-    // };
-    glUniformMatrix4fv(shader->uniforms.projection, 1, GL_TRUE, (float*) p);
+    glUniformMatrix4fv(shader->uniforms.projection, 1, MATRIX_UPLOAD_TRANSPOSE, (float*) p);
     glUseProgram(0);
 }
 
 void shader_set_view (Shader* shader, Mat4f* v) {
     glUseProgram(shader->shader_id);
-    // float data[] = {
-    //     v->ax, v->bx, v->cx, v->dx,
-    //     v->ay, v->by, v->cy, v->dy,
-    //     v->az, v->bz, v->cz, v->dz,
-    //     v->aw, v->bw, v->cw, v->dw
-    // };
-    glUniformMatrix4fv(shader->uniforms.view, 1, GL_TRUE, (float*) v);
+    glUniformMatrix4fv(shader->uniforms.view, 1, MATRIX_UPLOAD_TRANSPOSE, (float*) v);
     glUseProgram(0);
 }
 
@@ -277,14 +557,7 @@ void shader_draw (Shader* shader, struct drawinfo* drawinfo) {
     glUseProgram(shader->shader_id);
 
     // Model Matrix.
-    // Mat4f* m = &drawinfo->obj_transform;
-    // float data[] = {
-    //     m->ax, m->bx, m->cx, m->dx,
-    //     m->ay, m->by, m->cy, m->dy,
-    //     m->az, m->bz, m->cz, m->dz,
-    //     m->aw, m->bw, m->cw, m->dw
-    // };
-    glUniformMatrix4fv(shader->uniforms.model, 1, GL_TRUE, (float*) &drawinfo->model);
+    glUniformMatrix4fv(shader->uniforms.model, 1, MATRIX_UPLOAD_TRANSPOSE, (float*) &drawinfo->model);
 
     // Color Transform.
     Vec4f* c = &drawinfo->color;
@@ -309,8 +582,15 @@ void shader_draw (Shader* shader, struct drawinfo* drawinfo) {
     }
 
     // Image.
-    if (drawinfo->image != NULL) {
-        glBindTexture(GL_TEXTURE_2D, drawinfo->image->image_id);
+    Image* image = drawinfo->image;
+    if (image != NULL && image->target == GL_TEXTURE_2D_ARRAY) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, image->image_id);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(shader->uniforms.use_image, 2);
+        glUniform1f(shader->uniforms.layer, drawinfo->layer);
+    } else if (image != NULL) {
+        glBindTexture(GL_TEXTURE_2D, image->image_id);
         glUniform1i(shader->uniforms.use_image, 1);
     } else {
         glUniform1i(shader->uniforms.use_image, 0);
@@ -323,13 +603,26 @@ void shader_draw (Shader* shader, struct drawinfo* drawinfo) {
     glBindVertexArray(shape->vao_id);
 
     // Draw.
-    glDrawArrays(shape->type, 0, shape->size);
+    if (shape->ebo_id != 0) {
+        GLsizei count = drawinfo->count > 0 ? drawinfo->count : shape->index_count;
+        GLsizeiptr stride = shape->index_type == GL_UNSIGNED_SHORT ? 2 : 4;
+        glDrawElements(shape->type, count, shape->index_type, (void*) (drawinfo->first * stride));
+    } else {
+        GLsizei count = drawinfo->count > 0 ? drawinfo->count : shape->size;
+        glDrawArrays(shape->type, drawinfo->first, count);
+    }
 
     // Unbind Array.
     glBindVertexArray(0);
 
     // Unbind Texture.
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (image != NULL && image->target == GL_TEXTURE_2D_ARRAY) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glActiveTexture(GL_TEXTURE0);
+    } else {
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
 
     // Unbind Shader.
     glUseProgram(0);
@@ -19,6 +19,10 @@
 //
 // - Thus, every buffer passed into shape_create must have a length that is a multiple of 13.
 // - Further, the meaning of parameter 'size' is the number of vertices, not the length of the list directly.
+//
+// - Packed shapes (shape_create_packed) instead hold quads of 2 uint32 per vertex, for voxel
+//   chunks (see chunkmesh.h). They draw as triangles through a shared quad index buffer,
+//   and use the chunk shader, which reads them through ATTRIB_PACKED.
 
 
 // Standard Uniforms.
@@ -29,7 +33,9 @@ struct shader_uniforms {
     GLint obj_color;            // Type: vec4
     GLint obj_texture;          // Type: vec4
     GLint image;                // Type: sampler2d
-    GLint use_image;            // Type: int
+    GLint image_array;          // Type: sampler2DArray
+    GLint use_image;            // Type: int (0: none, 1: image, 2: image_array)
+    GLint layer;                // Type: float
 };
 
 // Attribute Locations.
@@ -38,8 +44,18 @@ enum shader_attributes {
     ATTRIB_TEXCOORD = 2,        // Type: vec2
     ATTRIB_COLOR = 3,           // Type: vec4
     ATTRIB_NORMAL = 4,          // Type: vec3
+    ATTRIB_PACKED = 5,          // Type: uvec2 (packed shapes only)
+};
+
+// Vertex Formats.
+enum shape_format {
+    SHAPE_FORMAT_FLOAT,         // 13 floats per vertex.
+    SHAPE_FORMAT_PACKED,        // 2 uint32 per vertex, 4 vertices per quad.
 };
 
+// Quads a packed shape can hold (limit of the shared 16-bit index buffer).
+#define SHAPE_MAX_QUADS 16384
+
 // Resource Slots.
 enum {
     SHADER_MAX_SHAPES = 16,
@@ -60,13 +76,32 @@ struct shader {
 
 // Shape Object.
 //  - Stores VAO and VBO handle + size and type of the data.
+//  - Indexed shapes also have an element buffer (ebo_id is 0 otherwise).
 struct shape {
     GLuint vao_id;
     GLuint vbo_id;
+    GLuint ebo_id;
 
-    GLuint size;    // Number of vertices
+    GLuint size;        // Number of vertices
+    GLuint capacity;    // Number of vertices the VBO has storage for.
+
+    GLuint index_count; // Number of indices (indexed shapes only).
+    GLenum index_type;  // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
 
     GLenum type;    // One of GL_TRIANGLES, GL_LINES or GL_POINTS.
+    GLenum usage;   // One of GL_STATIC_DRAW, GL_DYNAMIC_DRAW or GL_STREAM_DRAW.
+
+    GLuint format;  // SHAPE_FORMAT_FLOAT or SHAPE_FORMAT_PACKED.
+    GLuint stride;  // Bytes per vertex.
+};
+
+// Image States.
+//  - Images from image_create are always ready, see imageloader.h for the rest.
+enum image_state {
+    IMAGE_READY,
+    IMAGE_LOADING,
+    IMAGE_FAILED,
+    IMAGE_CANCELLED,
 };
 
 // Image Object.
@@ -74,9 +109,16 @@ struct image {
     // Image ID.
     GLuint image_id;
 
+    // Load State.
+    uint32_t state;
+
+    // Texture Target (GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY).
+    GLenum target;
+
     // Image Size.
     GLuint width;
     GLuint height;
+    GLuint layers;
 };
 
 // Drawing Info.
@@ -91,7 +133,10 @@ struct drawinfo {
     // Transforms.
     Mat4f model;
     Vec4f color;
-    Vec4f texture;
+    Vec4f texture;      // Texture Transform (x, y, w, h), selects a sub-image of an atlas.
+
+    // Array Layer (GL_TEXTURE_2D_ARRAY images only).
+    GLuint layer;
 
     // Depth Test Flags.
     bool enable_depthtest;
@@ -99,6 +144,11 @@ struct drawinfo {
 
     // Backface Culling.
     bool enable_culling;
+
+    // Vertex Range (count 0 draws the whole shape).
+    //  - For indexed shapes, the range is in indices.
+    GLint first;
+    GLsizei count;
 };
 
 // Create and Destroy Shader Objects.
@@ -107,12 +157,40 @@ void shader_destroy (Shader* shader);
 
 // Create and Destroy Shape Objets
 //  - Length of list 'data' must be size*13 floats long.
+//  - shape_create uses GL_STATIC_DRAW, shapes that get updated should use GL_DYNAMIC_DRAW.
 Shape* shape_create (const float* data, GLuint size, GLenum type);
+Shape* shape_create_usage (const float* data, GLuint size, GLenum type, GLenum usage);
 void shape_destroy (Shape* shape);
 
+// Create Indexed Shape Objects.
+//  - Indices are stored as 16-bit when 'size' allows it, 32-bit otherwise.
+Shape* shape_create_indexed (const float* data, GLuint size, const uint32_t* indices, GLuint index_count, GLenum type);
+
+// Create Packed Shape Objects.
+//  - 'data' holds size*2 uint32, 'size' must be a multiple of 4 and at most SHAPE_MAX_QUADS*4.
+//  - The index buffer is shared between all packed shapes.
+Shape* shape_create_packed (const uint32_t* data, GLuint size, GLenum usage);
+
+// Update Shape Objects in place.
+//  - shape_update overwrites 'count' vertices starting at 'first_vertex'.
+//    The range may extend the shape, but not past its capacity (returns false).
+//  - shape_resize replaces the whole contents, orphaning the old storage and only
+//    reallocating when 'size' does not fit the current capacity.
+//  - Both take data in the shape's own format (float or packed).
+bool shape_update (Shape* shape, const void* data, GLuint first_vertex, GLuint count);
+void shape_resize (Shape* shape, const void* data, GLuint size);
+
+// Set up the shape buffer format on the currently bound VAO and VBO.
+void shape_bind_attributes ();
+
 
 // Create and Destory Image Objects.
+//  - image_create_pixels takes width*height RGBA8 pixels.
+//  - image_create_array loads each file into one layer of a GL_TEXTURE_2D_ARRAY,
+//    all files must have the same size.
 Image* image_create (const char* file);
+Image* image_create_pixels (const uint8_t* data, GLuint width, GLuint height);
+Image* image_create_array (const char** files, GLuint count);
 void image_destroy (Image* image);
 
 // Initialize DrawInfo with default values.
@@ -0,0 +1,134 @@
+#include "shadercache.h"
+
+#include "glext.h"
+
+#include <sys/stat.h>
+
+#define CACHE_MAGIC 0x43505242  // "BRPC"
+
+// Cache File Header.
+struct cache_header {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t length;
+    uint32_t reserved;
+    uint64_t key;
+};
+
+// FNV-1a, 64 bit.
+static uint64_t hash_string (uint64_t hash, const char* text) {
+    if (text == NULL) return hash;
+
+    for (const uint8_t* c = (const uint8_t*) text; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+    // Separator, so ("ab","c") and ("a","bc") differ.
+    hash ^= 0xff;
+    hash *= 0x100000001b3ULL;
+
+    return hash;
+}
+
+static void cache_file (uint64_t key, char* file, size_t len) {
+    snprintf(file, len, "%s/%016llx.bin", SHADER_CACHE_DIR, (unsigned long long) key);
+}
+
+uint64_t shadercache_key (const char* vs_text, const char* fs_text) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    hash = hash_string(hash, vs_text);
+    hash = hash_string(hash, fs_text);
+    hash = hash_string(hash, (const char*) glGetString(GL_VENDOR));
+    hash = hash_string(hash, (const char*) glGetString(GL_RENDERER));
+    hash = hash_string(hash, (const char*) glGetString(GL_VERSION));
+
+    return hash;
+}
+
+GLuint shadercache_load (uint64_t key) {
+    if (!GLEXT.program_binary) return 0;
+
+    // Open file.
+    char file[256];
+    cache_file(key, file, sizeof(file));
+    FILE* f = fopen(file, "rb");
+    if (f == NULL) return 0;
+
+    // Read and check header.
+    struct cache_header header;
+    if (fread(&header, sizeof(header), 1, f) != 1 || header.magic != CACHE_MAGIC || header.key != key) {
+        fclose(f);
+        return 0;
+    }
+
+    // Read binary.
+    void* binary = malloc(header.length);
+    size_t read = fread(binary, 1, header.length, f);
+    fclose(f);
+    if (read != header.length) {
+        free(binary);
+        return 0;
+    }
+
+    // Create program from binary.
+    GLuint program = glCreateProgram();
+    GLEXT.ProgramBinary(program, header.format, binary, header.length);
+    free(binary);
+
+    // The driver may reject binaries from older builds, treat as a miss.
+    int result;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+void shadercache_store (uint64_t key, GLuint program) {
+    if (!GLEXT.program_binary) return;
+
+    // Get binary.
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    void* binary = malloc(length);
+    GLenum format = 0;
+    GLEXT.GetProgramBinary(program, length, &length, &format, binary);
+
+    // Make sure the cache directory exists.
+    mkdir("cache", 0755);
+    mkdir(SHADER_CACHE_DIR, 0755);
+
+    // Write to a temporary file, then move it in place.
+    char file[256], temp[264];
+    cache_file(key, file, sizeof(file));
+    snprintf(temp, sizeof(temp), "%s.tmp", file);
+
+    FILE* f = fopen(temp, "wb");
+    if (f == NULL) {
+        free(binary);
+        return;
+    }
+
+    struct cache_header header = {
+        .magic = CACHE_MAGIC,
+        .format = format,
+        .length = length,
+        .reserved = 0,
+        .key = key,
+    };
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1
+           && fwrite(binary, 1, length, f) == length;
+    ok = (fclose(f) == 0) && ok;
+    free(binary);
+
+    if (ok) {
+        rename(temp, file);
+    } else {
+        remove(temp);
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "main.h"
+
+#include <glad/glad.h>
+
+// SHADER PROGRAM CACHE
+//
+// - Linked programs are saved as driver binaries under SHADER_CACHE_DIR, and loaded
+//   back with glProgramBinary on the next launch instead of compiling from source.
+// - The cache key hashes both sources together with the GL vendor, renderer and
+//   version strings, so editing a shader or updating the driver misses the cache.
+// - Every failure (no ARB_get_program_binary, missing or stale file, rejected binary)
+//   just returns 0, and the caller compiles from source as usual.
+
+#define SHADER_CACHE_DIR "cache/shader"
+
+// Cache key for a vertex + fragment source pair.
+uint64_t shadercache_key (const char* vs_text, const char* fs_text);
+
+// Create a linked program from the cache (0 if missing or rejected).
+GLuint shadercache_load (uint64_t key);
+
+// Save a linked program to the cache.
+//  - The program should have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+void shadercache_store (uint64_t key, GLuint program);
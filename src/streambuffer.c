@@ -0,0 +1,141 @@
+#include "streambuffer.h"
+
+#include "render.h"
+#include "glext.h"
+
+#define VERTEX_SIZE (13 * sizeof(float))
+
+StreamBuffer* streambuffer_create (GLuint size, GLenum type) {
+    // VAO and VBO IDs.
+    GLuint vao_id, vbo_id;
+
+    // Total size of the ring in bytes.
+    GLsizeiptr length = (GLsizeiptr) size * STREAM_REGIONS * VERTEX_SIZE;
+
+    // Create VAO.
+    glGenVertexArrays(1, &vao_id);
+    glBindVertexArray(vao_id);
+
+    // Create VBO.
+    glGenBuffers(1, &vbo_id);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo_id);
+
+    // Allocate Storage.
+    float* mapping = NULL;
+    if (GLEXT.buffer_storage) {
+        // Dynamic storage keeps glBufferSubData legal if mapping fails (see streambuffer_append).
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLEXT.BufferStorage(GL_ARRAY_BUFFER, length, NULL, flags | GL_DYNAMIC_STORAGE_BIT);
+        mapping = glMapBufferRange(GL_ARRAY_BUFFER, 0, length, flags);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, length, NULL, GL_STREAM_DRAW);
+    }
+
+    // Bind Attributes.
+    shape_bind_attributes();
+
+    // Cleanup.
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Allocate and Initialize.
+    Shape* shape = malloc(sizeof(struct shape));
+    shape->vao_id = vao_id;
+    shape->vbo_id = vbo_id;
+    shape->ebo_id = 0;
+    shape->size = size * STREAM_REGIONS;
+    shape->capacity = size * STREAM_REGIONS;
+    shape->index_count = 0;
+    shape->index_type = GL_UNSIGNED_INT;
+    shape->type = type;
+    shape->usage = GL_STREAM_DRAW;
+    shape->format = SHAPE_FORMAT_FLOAT;
+    shape->stride = VERTEX_SIZE;
+
+    StreamBuffer* streambuffer = malloc(sizeof(StreamBuffer));
+    streambuffer->shape = shape;
+    streambuffer->mapping = mapping;
+    streambuffer->region_size = size;
+    streambuffer->region = 0;
+    streambuffer->used = 0;
+    for (int i = 0; i < STREAM_REGIONS; i++) {
+        streambuffer->fences[i] = NULL;
+    }
+
+    return streambuffer;
+}
+
+void streambuffer_destroy (StreamBuffer* streambuffer) {
+    for (int i = 0; i < STREAM_REGIONS; i++) {
+        if (streambuffer->fences[i] != NULL)
+            glDeleteSync(streambuffer->fences[i]);
+    }
+
+    if (streambuffer->mapping != NULL) {
+        glBindBuffer(GL_ARRAY_BUFFER, streambuffer->shape->vbo_id);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    shape_destroy(streambuffer->shape);
+    free(streambuffer);
+}
+
+void streambuffer_begin (StreamBuffer* streambuffer) {
+    // Advance to next region.
+    streambuffer->region = (streambuffer->region + 1) % STREAM_REGIONS;
+    streambuffer->used = 0;
+
+    // Wait until the GPU is done reading it (normally it already is).
+    GLsync fence = streambuffer->fences[streambuffer->region];
+    if (fence != NULL) {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        glDeleteSync(fence);
+        streambuffer->fences[streambuffer->region] = NULL;
+    }
+}
+
+void streambuffer_end (StreamBuffer* streambuffer) {
+    GLuint region = streambuffer->region;
+    if (streambuffer->fences[region] != NULL)
+        glDeleteSync(streambuffer->fences[region]);
+
+    streambuffer->fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool streambuffer_append (StreamBuffer* streambuffer, const float* data, GLuint size, StreamRange* range) {
+    if (streambuffer->used + size > streambuffer->region_size)
+        return false;
+
+    // First vertex of the range within the whole ring.
+    GLuint first = streambuffer->region * streambuffer->region_size + streambuffer->used;
+    GLsizeiptr length = size * VERTEX_SIZE;
+
+    if (streambuffer->mapping != NULL) {
+        // Persistent + Coherent: just write.
+        memcpy(streambuffer->mapping + first * 13, data, length);
+    } else {
+        // Region is fenced, so no implicit sync is needed.
+        glBindBuffer(GL_ARRAY_BUFFER, streambuffer->shape->vbo_id);
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT;
+        void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, first * VERTEX_SIZE, length, access);
+        if (ptr != NULL) {
+            memcpy(ptr, data, length);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+        } else {
+            glBufferSubData(GL_ARRAY_BUFFER, first * VERTEX_SIZE, length, data);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    streambuffer->used += size;
+
+    range->shape = streambuffer->shape;
+    range->first = first;
+    range->count = size;
+
+    return true;
+}
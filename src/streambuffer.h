@@ -0,0 +1,71 @@
+#pragma once
+
+#include "main.h"
+
+#include <glad/glad.h>
+
+// STREAM BUFFER
+//
+// - A ring buffer of vertices (same 13 float format as shapes) for geometry rebuilt every frame.
+// - The buffer is split into STREAM_REGIONS regions, one for each frame in flight.
+// - A frame only ever writes into its own region, which is fenced when the frame ends.
+// - When the ring wraps back to a region, its fence is waited on (normally already signalled).
+// - Writes use a persistent mapping when ARB_buffer_storage is available, and
+//   unsynchronized mapping otherwise. No GL objects are created after streambuffer_create.
+//
+// Usage:
+//
+//    streambuffer_begin(sb);
+//    if (streambuffer_append(sb, data, size, &range)) {
+//        drawinfo.shape = range.shape;
+//        drawinfo.first = range.first;
+//        drawinfo.count = range.count;
+//        shader_draw(shader, &drawinfo);
+//    }
+//    streambuffer_end(sb);
+
+
+enum {
+    STREAM_REGIONS = 3,
+};
+
+// Range of vertices appended this frame.
+struct stream_range {
+    Shape* shape;
+
+    GLint first;
+    GLsizei count;
+};
+
+// Stream Buffer Object.
+struct streambuffer {
+    // VAO + VBO (wrapped as a shape for drawing).
+    Shape* shape;
+
+    // Persistent Mapping (NULL if unavailable).
+    float* mapping;
+
+    // Region Size and Fences.
+    GLuint region_size;     // Number of vertices per region.
+    GLsync fences[STREAM_REGIONS];
+
+    // Current Region.
+    GLuint region;
+    GLuint used;            // Number of vertices written in the current region.
+};
+
+// Create and Destroy Stream Buffers.
+//  - 'size' is the number of vertices that can be appended each frame.
+//  - 'type' is one of GL_TRIANGLES, GL_LINES or GL_POINTS.
+StreamBuffer* streambuffer_create (GLuint size, GLenum type);
+void streambuffer_destroy (StreamBuffer* streambuffer);
+
+// Frame Boundaries.
+//  - begin moves on to the next region, end fences the current one.
+void streambuffer_begin (StreamBuffer* streambuffer);
+void streambuffer_end (StreamBuffer* streambuffer);
+
+// Append Vertices.
+//  - Length of list 'data' must be size*13 floats long.
+//  - Returns false (and appends nothing) if the region is full.
+bool streambuffer_append (StreamBuffer* streambuffer, const float* data, GLuint size, StreamRange* range);
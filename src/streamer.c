@@ -0,0 +1,561 @@
+#include "streamer.h"
+
+#include "array.h"
+#include "jobs.h"
+#include "world.h"
+#include "entity.h"
+#include "environment.h"
+#include "player.h"
+#include "region.h"
+
+
+struct load_request {
+    Streamer* streamer;
+    Chunk* chunk;
+
+    // Saved entities of the chunk.
+    SavedEntities saved;
+};
+
+// Save of a chunk leaving the world, or of orphaned entities (chunk NULL until the job
+// loads the stored chunk to merge them into).
+struct save_request {
+    Streamer* streamer;
+    Vec3i pos;
+    Chunk* chunk;
+
+    SavedEntities saved;
+};
+
+struct parked_entity {
+    Vec3i chunk;
+    Entity* entity;
+
+    // State written by on_save when it was parked.
+    uint8_t data[ENTITY_SAVE_MAX];
+    uint32_t data_size;
+};
+
+static void flat_source (Chunk* chunk, void* user) {
+    if (chunk->pos.j < -1) {
+        chunk_fill(chunk, BLOCK_STONE);
+    } else if (chunk->pos.j == -1) {
+        chunk_fill(chunk, BLOCK_DIRT);
+        for (int32_t z = 0; z < CHUNK_SIZE; z++) {
+            for (int32_t x = 0; x < CHUNK_SIZE; x++) {
+                chunk_set(chunk, chunk_index(x, CHUNK_SIZE - 1, z), BLOCK_GRASS);
+            }
+        }
+    }
+}
+
+static void load_main (void* arg) {
+    struct load_request* request = arg;
+    Streamer* streamer = request->streamer;
+
+    bool stored = streamer->regions != NULL
+        && regionstore_load(streamer->regions, request->chunk, &request->saved);
+
+    if (!stored) {
+        streamer->source(request->chunk, streamer->source_user);
+    }
+
+    // Entities leaving must clear them from the saved chunk.
+    if (request->saved.count > 0) {
+        request->chunk->modified = true;
+    }
+
+    pthread_mutex_lock(&streamer->lock);
+    array_add(streamer->loaded, request);
+    pthread_mutex_unlock(&streamer->lock);
+}
+
+// Append 'from' to 'into', keeping parents pointing at the same records.
+static void merge_saved (SavedEntities* into, const SavedEntities* from) {
+    uint32_t first = into->count;
+    for (uint32_t i = 0; i < from->count; i++) {
+        SavedEntity record = from->entities[i];
+        if (record.parent >= 0) record.parent += first;
+        savedentities_add(into, record, from->data + record.data_offset, record.data_size);
+    }
+}
+
+static void save_main (void* arg) {
+    struct save_request* request = arg;
+    Streamer* streamer = request->streamer;
+
+    // Orphans join whatever was saved for their chunk before.
+    if (request->chunk == NULL) {
+        request->chunk = chunk_create(request->pos);
+
+        SavedEntities stored;
+        if (!regionstore_load(streamer->regions, request->chunk, &stored)) {
+            streamer->source(request->chunk, streamer->source_user);
+        }
+        merge_saved(&stored, &request->saved);
+        savedentities_clear(&request->saved);
+        request->saved = stored;
+    }
+
+    regionstore_save(streamer->regions, request->chunk, &request->saved);
+
+    pthread_mutex_lock(&streamer->lock);
+    array_add(streamer->saved, request);
+    pthread_mutex_unlock(&streamer->lock);
+}
+
+static int compare_offsets (const void* a, const void* b) {
+    const Vec3i* u = a;
+    const Vec3i* v = b;
+    int32_t du = u->i*u->i + u->j*u->j + u->k*u->k;
+    int32_t dv = v->i*v->i + v->j*v->j + v->k*v->k;
+    return (du > dv) - (du < dv);
+}
+
+static bool in_range (Vec3i center, Vec3i pos, int32_t radius, int32_t height) {
+    int32_t dx = pos.i - center.i;
+    int32_t dy = pos.j - center.j;
+    int32_t dz = pos.k - center.k;
+    return dx*dx + dz*dz <= radius*radius && abs(dy) <= height;
+}
+
+static Vec3i chunk_of (Vec3f pos) {
+    return chunk_coords((int32_t) floorf(pos.x), (int32_t) floorf(pos.y), (int32_t) floorf(pos.z));
+}
+
+Streamer* streamer_create (World* world, JobPool* jobs) {
+    // Allocate and Initialize.
+    Streamer* streamer = malloc(sizeof(Streamer));
+    streamer->world = world;
+    streamer->jobs = jobs;
+    streamer->load_radius = STREAM_LOAD_RADIUS;
+    streamer->height_radius = STREAM_HEIGHT_RADIUS;
+    streamer->unload_margin = STREAM_UNLOAD_MARGIN;
+    streamer->source = flat_source;
+    streamer->source_user = NULL;
+    streamer->regions = NULL;
+    streamer->loading = array_create();
+    streamer->loaded = array_create();
+    streamer->saving = array_create();
+    streamer->saved = array_create();
+    streamer->pending = calloc(1, sizeof(JobCounter));
+    streamer->max_loads = STREAM_MAX_LOADS;
+    streamer->parked = array_create();
+    streamer->chunks_loaded = 0;
+    streamer->chunks_unloaded = 0;
+    streamer->chunks_saved = 0;
+    pthread_mutex_init(&streamer->lock, NULL);
+
+    // Load Offsets (nearest first).
+    int32_t r = streamer->load_radius;
+    int32_t h = streamer->height_radius;
+    streamer->offsets = malloc((2*r + 1) * (2*r + 1) * (2*h + 1) * sizeof(Vec3i));
+    streamer->offset_count = 0;
+    for (int32_t j = -h; j <= h; j++) {
+        for (int32_t k = -r; k <= r; k++) {
+            for (int32_t i = -r; i <= r; i++) {
+                if (i*i + k*k > r*r) continue;
+                streamer->offsets[streamer->offset_count++] = (Vec3i) {i, j, k};
+            }
+        }
+    }
+    qsort(streamer->offsets, streamer->offset_count, sizeof(Vec3i), compare_offsets);
+
+    return streamer;
+}
+
+static void release_parked (Streamer* streamer) {
+    for (int i = 0; i < streamer->parked->size; i++) {
+        struct parked_entity* parked = streamer->parked->data[i];
+        entity_unref(parked->entity);
+        free(parked);
+    }
+    array_clear(streamer->parked);
+}
+
+// Free finished saves (the lock must be held while saves are running).
+static void collect_saves (Streamer* streamer) {
+    for (int i = 0; i < streamer->saved->size; i++) {
+        struct save_request* request = streamer->saved->data[i];
+        array_remove_item(streamer->saving, request);
+
+        chunk_destroy(request->chunk);
+        savedentities_clear(&request->saved);
+        free(request);
+    }
+    array_clear(streamer->saved);
+}
+
+// Wait for every load and save, dropping the loaded chunks.
+static void release_loads (Streamer* streamer) {
+    jobs_wait(streamer->jobs, streamer->pending);
+
+    for (int i = 0; i < streamer->loaded->size; i++) {
+        struct load_request* request = streamer->loaded->data[i];
+        chunk_destroy(request->chunk);
+        savedentities_clear(&request->saved);
+        free(request);
+    }
+    array_clear(streamer->loaded);
+    array_clear(streamer->loading);
+
+    collect_saves(streamer);
+}
+
+void streamer_destroy (Streamer* streamer) {
+    release_loads(streamer);
+    release_parked(streamer);
+
+    array_destroy(streamer->loading);
+    array_destroy(streamer->loaded);
+    array_destroy(streamer->saving);
+    array_destroy(streamer->saved);
+    array_destroy(streamer->parked);
+    pthread_mutex_destroy(&streamer->lock);
+
+    free(streamer->offsets);
+    free(streamer->pending);
+    free(streamer);
+}
+
+void streamer_set_source (Streamer* streamer, chunk_source_fn source, void* user) {
+    streamer->source = source;
+    streamer->source_user = user;
+}
+
+void streamer_set_regions (Streamer* streamer, RegionStore* regions) {
+    streamer->regions = regions;
+}
+
+static bool same_chunk (Vec3i a, Vec3i b) {
+    return a.i == b.i && a.j == b.j && a.k == b.k;
+}
+
+// Park root entities (and their children) outside the unload range.
+//  - A negative radius parks everything.
+static void park_entities (Streamer* streamer, Environment* env, Vec3i center, int32_t radius, int32_t height) {
+    for (int i = 0; i < env->entities->size;) {
+        Entity* e = env->entities->data[i];
+
+        Entity* root = e;
+        while (root->parent != NULL) root = root->parent;
+
+        Vec3i chunk = chunk_of(root->pos);
+        bool keep = radius >= 0 && in_range(center, chunk, radius, height);
+        if (root == env->player->entity || e->state == STATE_DESTROY || keep) {
+            i++;
+            continue;
+        }
+
+        // Hand the environment's reference over.
+        struct parked_entity* parked = malloc(sizeof(struct parked_entity));
+        parked->chunk = chunk;
+        parked->entity = e;
+        parked->data_size = entity_save(e, parked->data);
+        array_add(streamer->parked, parked);
+
+        array_remove(env->entities, i);
+        entity_unload(e);
+        env->entities_changed = true;
+    }
+}
+
+// Bring back the entities parked with a chunk.
+static void unpark_entities (Streamer* streamer, Environment* env, Vec3i pos) {
+    for (int i = 0; i < streamer->parked->size;) {
+        struct parked_entity* parked = streamer->parked->data[i];
+        if (!same_chunk(parked->chunk, pos)) {
+            i++;
+            continue;
+        }
+
+        array_remove(streamer->parked, i);
+        env_add_entity(env, parked->entity);
+        entity_unref(parked->entity);
+        free(parked);
+    }
+}
+
+// Bring back parked entities whose chunk is in range again, and never left the world
+// (it was waiting for a save slot).
+static void unpark_kept (Streamer* streamer, Environment* env, Vec3i center, int32_t radius, int32_t height) {
+    for (int i = 0; i < streamer->parked->size;) {
+        struct parked_entity* parked = streamer->parked->data[i];
+        if (!in_range(center, parked->chunk, radius, height) || world_get_chunk(streamer->world, parked->chunk) == NULL) {
+            i++;
+            continue;
+        }
+
+        // Takes every entity parked with the chunk, none of them come before 'i'.
+        unpark_entities(streamer, env, parked->chunk);
+    }
+}
+
+// Create the saved entities of a loaded chunk.
+//  - They are loaded with their saved state right away, and join the environment directly.
+static void restore_entities (Environment* env, const SavedEntities* saved) {
+    uint32_t count = saved->count;
+    if (count == 0) return;
+    Entity* entities[count];
+
+    for (uint32_t i = 0; i < count; i++) {
+        const SavedEntity* s = &saved->entities[i];
+
+        // Unknown types (from a damaged or newer save) are dropped. The player is never
+        // saved, and can't be created without its Player.
+        if (s->type_id >= ENTITY_COUNT || s->type_id == ENTITY_PLAYER) {
+            entities[i] = NULL;
+            continue;
+        }
+
+        Entity* e = entity_create(env, s->id, s->type_id, s->pos);
+        e->vel = s->vel;
+        e->flags = (e->flags & ~0xFFu) | (s->flags & 0xFFu);
+        entity_set_rotation(e, s->rot);
+        entity_set_scale(e, s->scale);
+        entities[i] = e;
+    }
+
+    // Parents come back together with their children.
+    for (uint32_t i = 0; i < count; i++) {
+        if (entities[i] == NULL) continue;
+
+        const SavedEntity* s = &saved->entities[i];
+        if (s->parent >= 0 && (uint32_t) s->parent < count && entities[s->parent] != NULL) {
+            entity_set_parent(entities[i], entities[s->parent]);
+        }
+    }
+
+    // Hand the creation reference to the environment.
+    for (uint32_t i = 0; i < count; i++) {
+        if (entities[i] == NULL) continue;
+
+        const SavedEntity* s = &saved->entities[i];
+        entity_load(entities[i], s->data_size > 0 ? saved->data + s->data_offset : NULL, s->data_size);
+        array_add(env->entities, entities[i]);
+        env->entities_changed = true;
+    }
+}
+
+// Take the parked entities of a chunk as saved records, appended to 'saved'.
+static void take_parked (Streamer* streamer, Vec3i pos, SavedEntities* saved) {
+    struct parked_entity** taken = NULL;
+    uint32_t taken_count = 0;
+
+    for (int i = 0; i < streamer->parked->size;) {
+        struct parked_entity* parked = streamer->parked->data[i];
+        if (!same_chunk(parked->chunk, pos)) {
+            i++;
+            continue;
+        }
+
+        taken = realloc(taken, (taken_count + 1) * sizeof(struct parked_entity*));
+        taken[taken_count++] = parked;
+        array_remove(streamer->parked, i);
+    }
+
+    uint32_t first = saved->count;
+    for (uint32_t n = 0; n < taken_count; n++) {
+        Entity* e = taken[n]->entity;
+
+        // Children park with their root, so parents are in the same chunk.
+        int32_t parent = -1;
+        for (uint32_t m = 0; m < taken_count; m++) {
+            if (taken[m]->entity == e->parent) parent = first + m;
+        }
+
+        SavedEntity record = {
+            .id = e->id,
+            .type_id = e->type->id,
+            .parent = parent,
+            .flags = e->flags & 0xFFu,
+            .pos = e->pos,
+            .vel = e->vel,
+            .rot = e->rot,
+            .scale = e->scale,
+        };
+        savedentities_add(saved, record, taken[n]->data, taken[n]->data_size);
+    }
+
+    for (uint32_t n = 0; n < taken_count; n++) {
+        entity_unref(taken[n]->entity);
+        free(taken[n]);
+    }
+    free(taken);
+}
+
+static bool has_parked (Streamer* streamer, Vec3i pos) {
+    for (int i = 0; i < streamer->parked->size; i++) {
+        struct parked_entity* parked = streamer->parked->data[i];
+        if (same_chunk(parked->chunk, pos)) return true;
+    }
+    return false;
+}
+
+// Check for a load or save of a chunk in flight (only one at a time per chunk).
+static bool is_busy (Streamer* streamer, Vec3i pos) {
+    for (int i = 0; i < streamer->loading->size; i++) {
+        struct load_request* request = streamer->loading->data[i];
+        if (same_chunk(request->chunk->pos, pos)) return true;
+    }
+    for (int i = 0; i < streamer->saving->size; i++) {
+        struct save_request* request = streamer->saving->data[i];
+        if (same_chunk(request->pos, pos)) return true;
+    }
+    return false;
+}
+
+// Check if another load or save may start ('bounded' false ignores max_loads).
+static bool has_slot (Streamer* streamer, bool bounded) {
+    return !bounded || streamer->loading->size + streamer->saving->size < streamer->max_loads;
+}
+
+// Start a save, taking the parked entities of its chunk.
+//  - 'chunk' is copied, NULL saves orphans.
+static void submit_save (Streamer* streamer, Vec3i pos, const Chunk* chunk) {
+    struct save_request* request = malloc(sizeof(struct save_request));
+    request->streamer = streamer;
+    request->pos = pos;
+    request->chunk = NULL;
+    request->saved = (SavedEntities) {0};
+
+    if (chunk != NULL) {
+        uint8_t* data = malloc(CHUNK_SERIAL_MAX);
+        size_t size = chunk_serialize(chunk, data);
+        request->chunk = chunk_create(pos);
+        chunk_deserialize(request->chunk, data, size);
+        free(data);
+    }
+
+    take_parked(streamer, pos, &request->saved);
+    array_add(streamer->saving, request);
+    streamer->chunks_saved++;
+
+    jobs_submit(streamer->jobs, save_main, request, JOB_LOW, streamer->pending);
+}
+
+// Save parked entities whose chunk isn't loaded, merged into the saved chunk.
+//  - Entities of chunks still loaded (waiting for a save slot) are saved with them.
+static void save_orphans (Streamer* streamer, bool bounded) {
+    for (int i = 0; i < streamer->parked->size && has_slot(streamer, bounded);) {
+        struct parked_entity* parked = streamer->parked->data[i];
+        Vec3i pos = parked->chunk;
+
+        if (world_get_chunk(streamer->world, pos) != NULL || is_busy(streamer, pos)) {
+            i++;
+            continue;
+        }
+
+        // Takes every entity parked with 'pos', none of them come before 'i'.
+        submit_save(streamer, pos, NULL);
+    }
+}
+
+// Unload chunks (positions first, removing reorders the table).
+//  - Chunks that need saving stay loaded until a save slot is free.
+static uint32_t unload_chunks (Streamer* streamer, Vec3i center, int32_t radius, int32_t height, bool bounded) {
+    World* world = streamer->world;
+
+    uint32_t count = 0;
+    Vec3i* positions = malloc(world->chunk_count * sizeof(Vec3i));
+    for (uint32_t i = 0; i < world->table_size; i++) {
+        Chunk* chunk = world->table[i];
+        if (chunk != NULL && (radius < 0 || !in_range(center, chunk->pos, radius, height))) {
+            positions[count++] = chunk->pos;
+        }
+    }
+
+    uint32_t removed = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        Chunk* chunk = world_get_chunk(world, positions[i]);
+
+        if (streamer->regions != NULL && (chunk->modified || has_parked(streamer, chunk->pos))) {
+            if (!has_slot(streamer, bounded)) continue;
+            submit_save(streamer, chunk->pos, chunk);
+        }
+
+        world_remove_chunk(world, positions[i]);
+        removed++;
+    }
+
+    free(positions);
+    return removed;
+}
+
+void streamer_reset (Streamer* streamer, Environment* env) {
+    release_loads(streamer);
+
+    // Entities added this tick go too.
+    for (int i = 0; i < env->new_entities->size; i++) {
+        entity_load(env->new_entities->data[i], NULL, 0);
+        array_add(env->entities, env->new_entities->data[i]);
+    }
+    array_clear(env->new_entities);
+
+    park_entities(streamer, env, (Vec3i) {0, 0, 0}, -1, -1);
+    unload_chunks(streamer, (Vec3i) {0, 0, 0}, -1, -1, false);
+
+    if (streamer->regions != NULL) {
+        save_orphans(streamer, false);
+    }
+
+    // Everything is saved once the jobs are done.
+    release_loads(streamer);
+    release_parked(streamer);
+}
+
+void streamer_update (Streamer* streamer, Environment* env, Vec3f center) {
+    World* world = streamer->world;
+    Vec3i c = chunk_of(center);
+
+    int32_t unload_radius = streamer->load_radius + streamer->unload_margin;
+    int32_t unload_height = streamer->height_radius + streamer->unload_margin;
+
+    streamer->chunks_loaded = 0;
+    streamer->chunks_unloaded = 0;
+    streamer->chunks_saved = 0;
+
+    // Hand finished loads to the world.
+    pthread_mutex_lock(&streamer->lock);
+    for (int i = 0; i < streamer->loaded->size; i++) {
+        struct load_request* request = streamer->loaded->data[i];
+        Chunk* chunk = request->chunk;
+        array_remove_item(streamer->loading, request);
+
+        if (in_range(c, chunk->pos, unload_radius, unload_height) && world_insert_chunk(world, chunk)) {
+            restore_entities(env, &request->saved);
+            unpark_entities(streamer, env, chunk->pos);
+            streamer->chunks_loaded++;
+        } else {
+            chunk_destroy(chunk);
+        }
+        savedentities_clear(&request->saved);
+        free(request);
+    }
+    array_clear(streamer->loaded);
+    collect_saves(streamer);
+    pthread_mutex_unlock(&streamer->lock);
+
+    // Unload (entities first).
+    unpark_kept(streamer, env, c, unload_radius, unload_height);
+    park_entities(streamer, env, c, unload_radius, unload_height);
+    streamer->chunks_unloaded = unload_chunks(streamer, c, unload_radius, unload_height, true);
+
+    if (streamer->regions != NULL) {
+        save_orphans(streamer, true);
+    }
+
+    // Load, nearest first (not while the chunk is being saved).
+    for (uint32_t i = 0; i < streamer->offset_count && has_slot(streamer, true); i++) {
+        Vec3i pos = add3i(c, streamer->offsets[i]);
+        if (world_get_chunk(world, pos) != NULL || is_busy(streamer, pos)) continue;
+
+        struct load_request* request = malloc(sizeof(struct load_request));
+        request->streamer = streamer;
+        request->chunk = chunk_create(pos);
+        request->saved = (SavedEntities) {0};
+        array_add(streamer->loading, request);
+
+        jobs_submit(streamer->jobs, load_main, request, JOB_LOW, streamer->pending);
+    }
+}
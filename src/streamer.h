@@ -0,0 +1,91 @@
+#pragma once
+
+#include "main.h"
+
+#include <pthread.h>
+
+// CHUNK STREAMER
+//
+// - Keeps the chunks around a center point (the player) loaded, and nothing else:
+//    - Chunks within 'load_radius' (horizontally, in chunks) and 'height_radius'
+//      (vertically) are loaded, nearest first.
+//    - Chunks are only unloaded once they are more than 'unload_margin' chunks further
+//      out, so moving back and forth over a chunk border doesn't reload anything.
+//   The number of loaded chunks is bounded by the radii, however far the center travels.
+// - Loading is asynchronous: a detached chunk is filled by 'source' on the job pool
+//   (JOB_LOW), and handed to the world by streamer_update. At most 'max_loads' loads
+//   are in flight at a time.
+// - Entities follow their chunks: root entities (and their children) beyond the unload
+//   radius are saved and unloaded (on_save, on_unload) and parked with their chunk.
+//   When the chunk loads again they go back to the environment (on_load).
+//   The player is never parked.
+// - With a region store (streamer_set_regions), loads read saved chunks first and only
+//   fall back to 'source' for chunks never saved. Unloading saves chunks that were
+//   edited (or hold entities), and writes their parked entities out as SavedEntity
+//   records instead of keeping them in memory.
+// - Saving is asynchronous too: a copy of the chunk is compressed and written on the job
+//   pool (JOB_LOW). Loads and saves share the 'max_loads' bound, a chunk that needs saving
+//   stays loaded until a slot is free. Only one load or save per chunk is in flight, so a
+//   chunk is never read back while its save is still being written.
+
+#define STREAM_LOAD_RADIUS 6
+#define STREAM_HEIGHT_RADIUS 3
+#define STREAM_UNLOAD_MARGIN 2
+#define STREAM_MAX_LOADS 4
+
+// Fill a detached chunk (called on worker threads).
+typedef void (*chunk_source_fn) (Chunk* chunk, void* user);
+
+struct streamer {
+    World* world;
+    JobPool* jobs;
+
+    // Radii (chunks).
+    int32_t load_radius;
+    int32_t height_radius;
+    int32_t unload_margin;
+
+    // Chunk Source (flat ground by default).
+    chunk_source_fn source;
+    void* source_user;
+
+    // Persistence (may be NULL).
+    RegionStore* regions;
+
+    // Load offsets, nearest first.
+    Vec3i* offsets;
+    uint32_t offset_count;
+
+    // Loads and saves in flight (GL thread), and finished ones (protected by lock).
+    Array* loading;
+    Array* loaded;
+    Array* saving;
+    Array* saved;
+    pthread_mutex_t lock;
+    JobCounter* pending;
+    uint32_t max_loads;
+
+    // Parked Entities (with the chunk they wait for).
+    Array* parked;
+
+    // Statistics (last update).
+    uint32_t chunks_loaded;
+    uint32_t chunks_unloaded;
+    uint32_t chunks_saved;
+};
+
+// Create and Destroy Streamers.
+//  - streamer_destroy waits for outstanding loads and saves, and releases parked entities.
+Streamer* streamer_create (World* world, JobPool* jobs);
+void streamer_destroy (Streamer* streamer);
+
+// Set the chunk source and region store (before the first update).
+void streamer_set_source (Streamer* streamer, chunk_source_fn source, void* user);
+void streamer_set_regions (Streamer* streamer, RegionStore* regions);
+
+// Load and unload around 'center' (once per tick, between entity updates and transforms).
+void streamer_update (Streamer* streamer, Environment* env, Vec3f center);
+
+// Unload everything: wait for loads, park (and save) every entity but the player,
+// and unload (and save) every chunk. Returns once everything is written.
+void streamer_reset (Streamer* streamer, Environment* env);
@@ -0,0 +1,159 @@
+#include "terrain.h"
+
+#include "world.h"
+#include "noise.h"
+
+
+// Seed offsets of the noise fields.
+enum {
+    SEED_HEIGHT = 0,
+    SEED_HILLS = 100,
+    SEED_DRY = 200,
+    SEED_CAVES = 300,
+};
+
+#define CAVE_CELLS (CHUNK_SIZE / TERRAIN_CAVE_STEP + 1)
+
+static inline float smoothstep (float a, float b, float x) {
+    float t = (x - a) / (b - a);
+    t = t < 0 ? 0 : t > 1 ? 1 : t;
+    return t*t*(3 - 2*t);
+}
+
+Terrain* terrain_create (uint32_t seed) {
+    // Allocate and Initialize.
+    Terrain* terrain = malloc(sizeof(Terrain));
+    terrain->seed = seed;
+    terrain->height_scale = 96;
+    terrain->biome_scale = 384;
+    terrain->cave_scale = 48;
+    terrain->cave_width = 0.06;
+
+    return terrain;
+}
+
+void terrain_destroy (Terrain* terrain) {
+    free(terrain);
+}
+
+void terrain_generate (Terrain* terrain, Chunk* chunk) {
+    int32_t x0 = chunk->pos.i * CHUNK_SIZE;
+    int32_t y0 = chunk->pos.j * CHUNK_SIZE;
+    int32_t z0 = chunk->pos.k * CHUNK_SIZE;
+
+    // Nothing reaches this high.
+    if (y0 > TERRAIN_MAX_HEIGHT) {
+        chunk_fill(chunk, BLOCK_AIR);
+        return;
+    }
+
+    // Column Fields (256 columns, x fastest).
+    enum { COLUMNS = CHUNK_SIZE * CHUNK_SIZE };
+    float cx[COLUMNS], cy[COLUMNS], cz[COLUMNS];
+    float height[COLUMNS], hills[COLUMNS], dry[COLUMNS];
+
+    for (int32_t z = 0; z < CHUNK_SIZE; z++) {
+        for (int32_t x = 0; x < CHUNK_SIZE; x++) {
+            cx[z * CHUNK_SIZE + x] = (x0 + x) / terrain->biome_scale;
+            cy[z * CHUNK_SIZE + x] = 0.5f;
+            cz[z * CHUNK_SIZE + x] = (z0 + z) / terrain->biome_scale;
+        }
+    }
+    noise3_array(terrain->seed + SEED_HILLS, cx, cy, cz, hills, COLUMNS);
+    noise3_array(terrain->seed + SEED_DRY, cx, cy, cz, dry, COLUMNS);
+
+    float scale = terrain->biome_scale / terrain->height_scale;
+    for (uint32_t i = 0; i < COLUMNS; i++) {
+        cx[i] *= scale;
+        cz[i] *= scale;
+    }
+    fbm3_array(terrain->seed + SEED_HEIGHT, cx, cy, cz, height, COLUMNS, 4, 0.5f);
+
+    int32_t surface[COLUMNS];
+    int32_t lowest = INT32_MAX;
+    for (uint32_t i = 0; i < COLUMNS; i++) {
+        hills[i] = smoothstep(0.0f, 0.3f, hills[i]);
+        dry[i] = smoothstep(0.15f, 0.35f, dry[i]);
+
+        float amplitude = (6 + 22 * hills[i]) * (1 - 0.5f * dry[i]);
+        surface[i] = (int32_t) floorf(2 + height[i] * 2 * amplitude);
+        if (surface[i] < lowest) lowest = surface[i];
+    }
+
+    // Cave Field (coarse grid, only if any cell is underground).
+    float caves[CAVE_CELLS * CAVE_CELLS * CAVE_CELLS];
+    bool underground = y0 <= lowest;
+    for (uint32_t i = 0; i < COLUMNS && !underground; i++) underground = y0 < surface[i] - 2;
+
+    if (underground) {
+        enum { SAMPLES = CAVE_CELLS * CAVE_CELLS * CAVE_CELLS };
+        float px[SAMPLES], py[SAMPLES], pz[SAMPLES];
+        uint32_t n = 0;
+        for (int32_t y = 0; y < CAVE_CELLS; y++) {
+            for (int32_t z = 0; z < CAVE_CELLS; z++) {
+                for (int32_t x = 0; x < CAVE_CELLS; x++) {
+                    px[n] = (x0 + x * TERRAIN_CAVE_STEP) / terrain->cave_scale;
+                    py[n] = (y0 + y * TERRAIN_CAVE_STEP) / (terrain->cave_scale * 0.5f);
+                    pz[n] = (z0 + z * TERRAIN_CAVE_STEP) / terrain->cave_scale;
+                    n++;
+                }
+            }
+        }
+        fbm3_array(terrain->seed + SEED_CAVES, px, py, pz, caves, SAMPLES, 2, 0.5f);
+    }
+
+    // Cells.
+    uint16_t blocks[CHUNK_VOLUME];
+    const float step = 1.0f / TERRAIN_CAVE_STEP;
+
+    for (int32_t y = 0; y < CHUNK_SIZE; y++) {
+        int32_t wy = y0 + y;
+        int32_t gy = y / TERRAIN_CAVE_STEP;
+        float ty = (y % TERRAIN_CAVE_STEP) * step;
+
+        for (int32_t z = 0; z < CHUNK_SIZE; z++) {
+            int32_t gz = z / TERRAIN_CAVE_STEP;
+            float tz = (z % TERRAIN_CAVE_STEP) * step;
+
+            for (int32_t x = 0; x < CHUNK_SIZE; x++) {
+                uint32_t column = z * CHUNK_SIZE + x;
+                int32_t depth = surface[column] - wy;
+                uint16_t block;
+
+                if (depth < 0) {
+                    block = BLOCK_AIR;
+                } else if (depth == 0) {
+                    block = dry[column] > 0.5f ? BLOCK_SAND : BLOCK_GRASS;
+                } else if (depth < 4) {
+                    block = dry[column] > 0.5f ? BLOCK_SAND : BLOCK_DIRT;
+                } else {
+                    block = BLOCK_STONE;
+                }
+
+                // Carve Caves (trilinear over the coarse grid).
+                if (depth > 2) {
+                    int32_t gx = x / TERRAIN_CAVE_STEP;
+                    float tx = (x % TERRAIN_CAVE_STEP) * step;
+                    const float* c = caves + (gy * CAVE_CELLS + gz) * CAVE_CELLS + gx;
+                    const uint32_t dy = CAVE_CELLS * CAVE_CELLS, dz = CAVE_CELLS;
+
+                    float c00 = noise_lerp(c[0],       c[1],           tx);
+                    float c10 = noise_lerp(c[dz],      c[dz + 1],      tx);
+                    float c01 = noise_lerp(c[dy],      c[dy + 1],      tx);
+                    float c11 = noise_lerp(c[dy + dz], c[dy + dz + 1], tx);
+                    float v = noise_lerp(noise_lerp(c00, c10, tz), noise_lerp(c01, c11, tz), ty);
+
+                    if (fabsf(v) < terrain->cave_width) block = BLOCK_AIR;
+                }
+
+                blocks[chunk_index(x, y, z)] = block;
+            }
+        }
+    }
+
+    chunk_set_blocks(chunk, blocks);
+}
+
+void terrain_source (Chunk* chunk, void* user) {
+    terrain_generate(user, chunk);
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "main.h"
+
+// TERRAIN GENERATOR
+//
+// - Fills chunks from a seed alone, so the same seed always gives the same world and
+//   any chunk can be generated on its own, in any order, on any thread.
+// - Height: fBm gradient noise over the columns (x,z), scaled by two slow biome fields:
+//     - 'hills' blends flat plains (about +-6 blocks) into hills (about +-28).
+//     - 'dry' blends grass and dirt into sand, and flattens the ground somewhat.
+//   Blending is continuous, so there are no seams between biomes.
+// - Caves: 3D fBm carved where it is close to zero (winding tunnels), below the top
+//   few blocks of ground. Cave noise is sampled every 4 blocks and interpolated.
+// - Noise is evaluated 4 lanes at a time (noise.h), over rows of columns and cells.
+// - terrain_source matches chunk_source_fn (streamer.h), so chunks generate on the
+//   streamer's load jobs.
+
+#define TERRAIN_MAX_HEIGHT 48
+#define TERRAIN_CAVE_STEP 4
+
+struct terrain {
+    uint32_t seed;
+
+    // Scales (blocks).
+    float height_scale;         // Wavelength of the height fBm.
+    float biome_scale;          // Wavelength of the biome fields.
+    float cave_scale;           // Wavelength of the cave fBm.
+    float cave_width;           // Tunnels where |cave noise| < cave_width.
+};
+
+// Create and Destroy Terrain Generators.
+Terrain* terrain_create (uint32_t seed);
+void terrain_destroy (Terrain* terrain);
+
+// Generate a (detached) chunk, replacing its contents.
+void terrain_generate (Terrain* terrain, Chunk* chunk);
+
+// chunk_source_fn wrapper ('user' is the Terrain).
+void terrain_source (Chunk* chunk, void* user);
@@ -73,3 +73,17 @@ Shape* vertexbuffer_export (VertexBuffer* vertexbuffer, uint32_t type) {
     uint32_t size = vertexbuffer->size / 13;
     return shape_create(vertexbuffer->data, size, type);
 }
+
+Shape* vertexbuffer_export_usage (VertexBuffer* vertexbuffer, uint32_t type, uint32_t usage) {
+    uint32_t size = vertexbuffer->size / 13;
+    return shape_create_usage(vertexbuffer->data, size, type, usage);
+}
+
+void vertexbuffer_update (VertexBuffer* vertexbuffer, Shape* shape) {
+    uint32_t size = vertexbuffer->size / 13;
+    shape_resize(shape, vertexbuffer->data, size);
+}
+
+void vertexbuffer_clear (VertexBuffer* vertexbuffer) {
+    vertexbuffer->size = 0;
+}
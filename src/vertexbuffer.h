@@ -25,3 +25,8 @@ void vertexbuffer_vertex (VertexBuffer* vertexbuffer, Vec4f vertex);
 void vertexbuffer_vertex3f (VertexBuffer* vertexbuffer, Vec3f vertex);
 
 Shape* vertexbuffer_export (VertexBuffer*, uint32_t type);
+Shape* vertexbuffer_export_usage (VertexBuffer*, uint32_t type, uint32_t usage);
+
+void vertexbuffer_update (VertexBuffer* vertexbuffer, Shape* shape);
+
+void vertexbuffer_clear (VertexBuffer* vertexbuffer);
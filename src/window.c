@@ -1,5 +1,7 @@
 #include "window.h"
 
+#include "glext.h"
+
 #include <GLFW/glfw3.h>
 
 struct window_impl {
@@ -59,6 +61,9 @@ Window* window_create (const char* title, int width, int height) {
         return NULL;
     }
 
+    // Optional Extensions.
+    glext_init((GLADloadproc) glfwGetProcAddress);
+
     // Check version.
     printf("%s\n", glGetString(GL_VERSION));
 
@@ -0,0 +1,473 @@
+#include "world.h"
+
+#include "light.h"
+
+
+//
+// Chunk Storage.
+//
+
+Chunk* chunk_create (Vec3i pos) {
+    // Allocate and Initialize (uniform air).
+    Chunk* chunk = malloc(sizeof(Chunk));
+    chunk->pos = pos;
+    chunk->palette = malloc(sizeof(uint16_t));
+    chunk->refs = malloc(sizeof(uint16_t));
+    chunk->palette[0] = BLOCK_AIR;
+    chunk->refs[0] = CHUNK_VOLUME;
+    chunk->palette_size = 1;
+    chunk->data = NULL;
+    chunk->bits = 0;
+    chunk->version = 0;
+    chunk->modified = false;
+    chunk->draw = NULL;
+    chunk->light = NULL;
+    chunk->light_fill = 0;
+    chunk->lit = false;
+    chunk->light_queued = false;
+    chunk->light_dirty = false;
+
+    return chunk;
+}
+
+void chunk_destroy (Chunk* chunk) {
+    free(chunk->palette);
+    free(chunk->refs);
+    free(chunk->data);
+    free(chunk->light);
+    free(chunk);
+}
+
+static inline uint32_t data_words (uint32_t bits) {
+    return CHUNK_VOLUME * bits / 64;
+}
+
+static inline uint32_t read_index (const uint64_t* data, uint32_t bits, uint32_t index) {
+    uint32_t bit = index * bits;
+    return (data[bit >> 6] >> (bit & 63)) & ((1ull << bits) - 1);
+}
+
+static inline void write_index (uint64_t* data, uint32_t bits, uint32_t index, uint32_t value) {
+    uint32_t bit = index * bits;
+    uint64_t mask = ((1ull << bits) - 1) << (bit & 63);
+    data[bit >> 6] = (data[bit >> 6] & ~mask) | ((uint64_t) value << (bit & 63));
+}
+
+// Repack cell indices at a new width (16 bits stores block ids directly).
+static void chunk_widen (Chunk* chunk, uint32_t bits) {
+    uint64_t* data = calloc(data_words(bits), sizeof(uint64_t));
+
+    for (uint32_t i = 0; i < CHUNK_VOLUME && chunk->data != NULL; i++) {
+        uint32_t value = read_index(chunk->data, chunk->bits, i);
+        if (bits == 16) value = chunk->palette[value];
+        write_index(data, bits, i, value);
+    }
+
+    free(chunk->data);
+    chunk->data = data;
+    chunk->bits = bits;
+
+    uint32_t capacity = bits == 16 ? chunk->palette_size : 1u << bits;
+    chunk->palette = realloc(chunk->palette, capacity * sizeof(uint16_t));
+    chunk->refs = realloc(chunk->refs, capacity * sizeof(uint16_t));
+}
+
+uint16_t chunk_get (const Chunk* chunk, uint32_t index) {
+    if (chunk->bits == 0) return chunk->palette[0];
+    if (chunk->bits == 16) return read_index(chunk->data, 16, index);
+    return chunk->palette[read_index(chunk->data, chunk->bits, index)];
+}
+
+void chunk_fill (Chunk* chunk, uint16_t block) {
+    free(chunk->data);
+    chunk->data = NULL;
+    chunk->bits = 0;
+    chunk->palette = realloc(chunk->palette, sizeof(uint16_t));
+    chunk->refs = realloc(chunk->refs, sizeof(uint16_t));
+    chunk->palette[0] = block;
+    chunk->refs[0] = CHUNK_VOLUME;
+    chunk->palette_size = 1;
+    chunk->version++;
+}
+
+void chunk_set_blocks (Chunk* chunk, const uint16_t* blocks) {
+    // Palette (stops counting past 256 entries, those chunks store ids directly).
+    uint16_t palette[256];
+    uint32_t palette_size = 0;
+    uint8_t seen[BLOCK_COUNT] = {0};
+
+    for (uint32_t i = 0; i < CHUNK_VOLUME && palette_size <= 256; i++) {
+        uint16_t block = blocks[i];
+        if (block < BLOCK_COUNT && seen[block]) continue;
+
+        bool found = false;
+        for (uint32_t p = 0; p < palette_size && !found; p++) found = palette[p] == block;
+        if (found) continue;
+
+        if (palette_size == 256) {
+            palette_size++;
+            break;
+        }
+        palette[palette_size++] = block;
+        if (block < BLOCK_COUNT) seen[block] = 1;
+    }
+
+    if (palette_size == 1) {
+        chunk_fill(chunk, palette[0]);
+        return;
+    }
+
+    uint32_t bits = 1;
+    while (bits < 16 && (1u << bits) < palette_size) bits *= 2;
+    if (palette_size > 256) bits = 16;
+
+    free(chunk->data);
+    chunk->data = calloc(data_words(bits), sizeof(uint64_t));
+    chunk->bits = bits;
+
+    uint32_t capacity = bits == 16 ? 1 : 1u << bits;
+    chunk->palette = realloc(chunk->palette, capacity * sizeof(uint16_t));
+    chunk->refs = realloc(chunk->refs, capacity * sizeof(uint16_t));
+    chunk->palette_size = bits == 16 ? 0 : palette_size;
+    memset(chunk->refs, 0, capacity * sizeof(uint16_t));
+
+    if (bits == 16) {
+        for (uint32_t i = 0; i < CHUNK_VOLUME; i++) write_index(chunk->data, 16, i, blocks[i]);
+    } else {
+        memcpy(chunk->palette, palette, palette_size * sizeof(uint16_t));
+
+        // Block id to palette entry, cached for the last block.
+        uint16_t last = palette[0];
+        uint32_t entry = 0;
+        for (uint32_t i = 0; i < CHUNK_VOLUME; i++) {
+            if (blocks[i] != last) {
+                last = blocks[i];
+                entry = 0;
+                while (palette[entry] != last) entry++;
+            }
+            write_index(chunk->data, bits, i, entry);
+            chunk->refs[entry]++;
+        }
+    }
+
+    chunk->version++;
+}
+
+// Palette entry for 'block', adding (and widening) if needed. Returns UINT32_MAX at 16 bits.
+static uint32_t palette_entry (Chunk* chunk, uint16_t block) {
+    uint32_t free_entry = UINT32_MAX;
+    for (uint32_t i = 0; i < chunk->palette_size; i++) {
+        if (chunk->palette[i] == block && chunk->refs[i] > 0) return i;
+        if (chunk->refs[i] == 0 && free_entry == UINT32_MAX) free_entry = i;
+    }
+
+    if (free_entry != UINT32_MAX) {
+        chunk->palette[free_entry] = block;
+        return free_entry;
+    }
+
+    // Grow the palette, widening once it doesn't fit.
+    if (chunk->palette_size == (1u << chunk->bits)) {
+        uint32_t bits = chunk->bits == 0 ? 1 : chunk->bits * 2;
+        if (bits == 16) {
+            chunk_widen(chunk, 16);
+            return UINT32_MAX;
+        }
+        chunk_widen(chunk, bits);
+    }
+
+    uint32_t entry = chunk->palette_size++;
+    chunk->palette[entry] = block;
+    chunk->refs[entry] = 0;
+    return entry;
+}
+
+bool chunk_set (Chunk* chunk, uint32_t index, uint16_t block) {
+    if (chunk_get(chunk, index) == block) return false;
+    chunk->version++;
+
+    // Uniform: start packing (all cells use entry 0, the old block).
+    if (chunk->bits == 0) {
+        chunk_widen(chunk, 1);
+    }
+
+    // Direct Ids.
+    if (chunk->bits == 16) {
+        write_index(chunk->data, 16, index, block);
+        return true;
+    }
+
+    uint32_t old = read_index(chunk->data, chunk->bits, index);
+    chunk->refs[old]--;
+
+    uint32_t entry = palette_entry(chunk, block);
+    if (entry == UINT32_MAX) {
+        write_index(chunk->data, 16, index, block);
+        return true;
+    }
+
+    write_index(chunk->data, chunk->bits, index, entry);
+    chunk->refs[entry]++;
+
+    // Back to uniform.
+    if (chunk->refs[entry] == CHUNK_VOLUME) {
+        chunk_fill(chunk, block);
+    }
+
+    return true;
+}
+
+
+//
+// Chunk Table.
+//
+
+static inline uint32_t chunk_hash (Vec3i pos) {
+    uint32_t h = (uint32_t) pos.i * 0x8DA6B343u ^ (uint32_t) pos.j * 0xD8163841u ^ (uint32_t) pos.k * 0xCB1AB31Fu;
+    return h ^ (h >> 16);
+}
+
+static inline bool same_pos (Vec3i a, Vec3i b) {
+    return a.i == b.i && a.j == b.j && a.k == b.k;
+}
+
+static void touch_chunk (World* world, Vec3i pos) {
+    Chunk* chunk = world_get_chunk(world, pos);
+    if (chunk != NULL) chunk->version++;
+}
+
+static void touch_neighbours (World* world, Vec3i pos) {
+    touch_chunk(world, (Vec3i) {pos.i - 1, pos.j, pos.k});
+    touch_chunk(world, (Vec3i) {pos.i + 1, pos.j, pos.k});
+    touch_chunk(world, (Vec3i) {pos.i, pos.j - 1, pos.k});
+    touch_chunk(world, (Vec3i) {pos.i, pos.j + 1, pos.k});
+    touch_chunk(world, (Vec3i) {pos.i, pos.j, pos.k - 1});
+    touch_chunk(world, (Vec3i) {pos.i, pos.j, pos.k + 1});
+}
+
+World* world_create () {
+    // Allocate and Initialize.
+    World* world = malloc(sizeof(World));
+    world->table_size = 64;
+    world->table = calloc(world->table_size, sizeof(Chunk*));
+    world->chunk_count = 0;
+    world->on_remove = NULL;
+    world->user = NULL;
+    world->light = NULL;
+
+    return world;
+}
+
+void world_destroy (World* world) {
+    for (uint32_t i = 0; i < world->table_size; i++) {
+        if (world->table[i] != NULL) chunk_destroy(world->table[i]);
+    }
+    free(world->table);
+    free(world);
+}
+
+Chunk* world_get_chunk (World* world, Vec3i pos) {
+    uint32_t mask = world->table_size - 1;
+    for (uint32_t slot = chunk_hash(pos) & mask;; slot = (slot + 1) & mask) {
+        Chunk* chunk = world->table[slot];
+        if (chunk == NULL) return NULL;
+        if (same_pos(chunk->pos, pos)) return chunk;
+    }
+}
+
+static void table_insert (Chunk** table, uint32_t size, Chunk* chunk) {
+    uint32_t mask = size - 1;
+    uint32_t slot = chunk_hash(chunk->pos) & mask;
+    while (table[slot] != NULL) slot = (slot + 1) & mask;
+    table[slot] = chunk;
+}
+
+Chunk* world_add_chunk (World* world, Vec3i pos) {
+    Chunk* chunk = world_get_chunk(world, pos);
+    if (chunk != NULL) return chunk;
+
+    chunk = chunk_create(pos);
+    world_insert_chunk(world, chunk);
+
+    return chunk;
+}
+
+bool world_insert_chunk (World* world, Chunk* chunk) {
+    if (world_get_chunk(world, chunk->pos) != NULL) return false;
+
+    // Grow at half full.
+    if ((world->chunk_count + 1) * 2 > world->table_size) {
+        uint32_t size = world->table_size * 2;
+        Chunk** table = calloc(size, sizeof(Chunk*));
+        for (uint32_t i = 0; i < world->table_size; i++) {
+            if (world->table[i] != NULL) table_insert(table, size, world->table[i]);
+        }
+        free(world->table);
+        world->table = table;
+        world->table_size = size;
+    }
+
+    table_insert(world->table, world->table_size, chunk);
+    world->chunk_count++;
+    touch_neighbours(world, chunk->pos);
+
+    if (world->light != NULL) light_queue_chunk(world->light, chunk);
+
+    return true;
+}
+
+void world_remove_chunk (World* world, Vec3i pos) {
+    uint32_t mask = world->table_size - 1;
+    uint32_t slot = chunk_hash(pos) & mask;
+    while (true) {
+        if (world->table[slot] == NULL) return;
+        if (same_pos(world->table[slot]->pos, pos)) break;
+        slot = (slot + 1) & mask;
+    }
+
+    Chunk* chunk = world->table[slot];
+    if (world->on_remove != NULL) world->on_remove(chunk, world->user);
+    chunk_destroy(chunk);
+    world->table[slot] = NULL;
+    world->chunk_count--;
+
+    // Shift later entries of the probe run back into the gap.
+    for (uint32_t next = (slot + 1) & mask; world->table[next] != NULL; next = (next + 1) & mask) {
+        uint32_t home = chunk_hash(world->table[next]->pos) & mask;
+        // Move if the gap lies between home and next (cyclically).
+        bool move = (next > slot) ? (home <= slot || home > next) : (home <= slot && home > next);
+        if (move) {
+            world->table[slot] = world->table[next];
+            world->table[next] = NULL;
+            slot = next;
+        }
+    }
+
+    touch_neighbours(world, pos);
+}
+
+
+//
+// Blocks.
+//
+
+uint16_t world_get_block (World* world, int32_t x, int32_t y, int32_t z) {
+    Chunk* chunk = world_get_chunk(world, chunk_coords(x, y, z));
+    if (chunk == NULL) return BLOCK_AIR;
+    return chunk_get(chunk, chunk_index(x, y, z));
+}
+
+void world_set_block (World* world, int32_t x, int32_t y, int32_t z, uint16_t block) {
+    Vec3i pos = chunk_coords(x, y, z);
+    Chunk* chunk = world_get_chunk(world, pos);
+    if (chunk == NULL) {
+        if (block == BLOCK_AIR) return;
+        chunk = world_add_chunk(world, pos);
+    }
+    if (!chunk_set(chunk, chunk_index(x, y, z), block)) return;
+    chunk->modified = true;
+
+    if (world->light != NULL) light_queue_block(world->light, chunk, x, y, z);
+
+    // Neighbours see border blocks.
+    int32_t lx = x & CHUNK_MASK, ly = y & CHUNK_MASK, lz = z & CHUNK_MASK;
+    if (lx == 0) touch_chunk(world, (Vec3i) {pos.i - 1, pos.j, pos.k});
+    if (lx == CHUNK_MASK) touch_chunk(world, (Vec3i) {pos.i + 1, pos.j, pos.k});
+    if (ly == 0) touch_chunk(world, (Vec3i) {pos.i, pos.j - 1, pos.k});
+    if (ly == CHUNK_MASK) touch_chunk(world, (Vec3i) {pos.i, pos.j + 1, pos.k});
+    if (lz == 0) touch_chunk(world, (Vec3i) {pos.i, pos.j, pos.k - 1});
+    if (lz == CHUNK_MASK) touch_chunk(world, (Vec3i) {pos.i, pos.j, pos.k + 1});
+}
+
+//
+// Serialization.
+//  - uint16 palette size, uint8 bits, uint8 0, palette (uint16 each, none at 16 bits),
+//    then the packed cell words. Reference counts are rebuilt on load.
+//
+
+size_t chunk_serialize (const Chunk* chunk, uint8_t* out) {
+    uint16_t palette_size = chunk->bits == 16 ? 0 : chunk->palette_size;
+    uint8_t* p = out;
+
+    memcpy(p, &palette_size, 2);
+    p[2] = chunk->bits;
+    p[3] = 0;
+    p += 4;
+
+    // Uniform chunks have no cell data (and 16-bit chunks no palette).
+    size_t size = palette_size * sizeof(uint16_t);
+    if (size > 0) memcpy(p, chunk->palette, size);
+    p += size;
+
+    size = data_words(chunk->bits) * sizeof(uint64_t);
+    if (size > 0) memcpy(p, chunk->data, size);
+    p += size;
+
+    return p - out;
+}
+
+bool chunk_deserialize (Chunk* chunk, const uint8_t* data, size_t size) {
+    if (size < 4) return false;
+
+    uint16_t palette_size;
+    memcpy(&palette_size, data, 2);
+    uint32_t bits = data[2];
+
+    // Validate.
+    bool valid_bits = bits == 0 || bits == 1 || bits == 2 || bits == 4 || bits == 8 || bits == 16;
+    if (!valid_bits) return false;
+    if (bits == 0 && palette_size != 1) return false;
+    if (bits == 16 && palette_size != 0) return false;
+    if (bits != 16 && (palette_size == 0 || (bits > 0 && palette_size > (1u << bits)))) return false;
+    if (size != 4 + palette_size * sizeof(uint16_t) + data_words(bits) * sizeof(uint64_t)) return false;
+
+    uint32_t capacity = bits == 0 ? 1 : bits == 16 ? 1 : 1u << bits;
+    free(chunk->data);
+    chunk->palette = realloc(chunk->palette, capacity * sizeof(uint16_t));
+    chunk->refs = realloc(chunk->refs, capacity * sizeof(uint16_t));
+    chunk->palette_size = bits == 16 ? 0 : palette_size;
+    chunk->bits = bits;
+    chunk->data = NULL;
+
+    memcpy(chunk->palette, data + 4, palette_size * sizeof(uint16_t));
+    memset(chunk->refs, 0, capacity * sizeof(uint16_t));
+
+    if (bits == 0) {
+        chunk->refs[0] = CHUNK_VOLUME;
+    } else {
+        chunk->data = malloc(data_words(bits) * sizeof(uint64_t));
+        memcpy(chunk->data, data + 4 + palette_size * sizeof(uint16_t), data_words(bits) * sizeof(uint64_t));
+
+        // Rebuild reference counts (and reject indices past the palette).
+        for (uint32_t i = 0; i < CHUNK_VOLUME && bits != 16; i++) {
+            uint32_t entry = read_index(chunk->data, bits, i);
+            if (entry >= palette_size) {
+                chunk_fill(chunk, BLOCK_AIR);
+                return false;
+            }
+            chunk->refs[entry]++;
+        }
+    }
+
+    chunk->version++;
+    return true;
+}
+
+void world_get_stats (World* world, WorldStats* stats) {
+    stats->chunks = world->chunk_count;
+    stats->uniform_chunks = 0;
+    stats->bytes = sizeof(World) + world->table_size * sizeof(Chunk*);
+
+    for (uint32_t i = 0; i < world->table_size; i++) {
+        Chunk* chunk = world->table[i];
+        if (chunk == NULL) continue;
+
+        uint32_t capacity = chunk->bits == 0 ? 1 : chunk->bits == 16 ? chunk->palette_size : 1u << chunk->bits;
+        stats->bytes += sizeof(Chunk) + capacity * 2 * sizeof(uint16_t) + data_words(chunk->bits) * sizeof(uint64_t);
+        if (chunk->light != NULL) stats->bytes += CHUNK_VOLUME;
+        if (chunk->bits == 0) stats->uniform_chunks++;
+    }
+
+    size_t blocks = (size_t) world->chunk_count * CHUNK_VOLUME;
+    stats->bytes_per_block = blocks > 0 ? (float) stats->bytes / blocks : 0;
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "main.h"
+
+// VOXEL WORLD
+//
+// - Blocks are stored in chunks of 16x16x16, found through a hash map keyed by
+//   chunk coordinates (open addressing, linear probing).
+// - Block coordinates split into chunk and local coordinates with shifts and masks,
+//   the same as DIV and MOD by CHUNK_SIZE, without the float round trip.
+// - Missing chunks read as BLOCK_AIR, so empty space costs nothing.
+// - Each chunk is palette compressed: a list of the distinct blocks in it, and one
+//   index per cell packed into 64-bit words. The index width grows (1, 2, 4, 8, 16 bits)
+//   as the palette fills up. Palette entries are reference counted, so entries whose
+//   last cell changed are reused before the width grows.
+// - Uniform chunks (one block type throughout) drop their cell data entirely.
+// - Get and set never scan more than a palette (at most 256 entries before the
+//   width reaches 16 bits, which stores block ids directly).
+// - Every change to a chunk bumps its version, for anything caching derived data.
+//   Changes to border blocks, and adding or removing a chunk, also bump the versions of
+//   the neighbouring chunks, since their meshes look across the border.
+// - on_remove is called for every chunk world_remove_chunk takes out (not on world_destroy).
+// - With lighting attached (world->light), block edits and new chunks are queued for it,
+//   see light.h. Every cell also stores its light level, next to the block data.
+
+#define CHUNK_BITS 4
+#define CHUNK_SIZE (1 << CHUNK_BITS)
+#define CHUNK_MASK (CHUNK_SIZE - 1)
+#define CHUNK_VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+
+enum block_type {
+    BLOCK_AIR = 0,
+    BLOCK_STONE,
+    BLOCK_DIRT,
+    BLOCK_GRASS,
+    BLOCK_SAND,
+    BLOCK_TORCH,
+
+    BLOCK_COUNT,
+};
+
+// True for blocks that hide the faces of their neighbours.
+static inline
+bool block_is_opaque (uint16_t block) {
+    return block != BLOCK_AIR && block != BLOCK_TORCH;
+}
+
+// Light level emitted by a block (0..15).
+static inline
+uint8_t block_emission (uint16_t block) {
+    return block == BLOCK_TORCH ? 14 : 0;
+}
+
+// True for blocks that entities collide with.
+static inline
+bool block_is_solid (uint16_t block) {
+    return block != BLOCK_AIR && block != BLOCK_TORCH;
+}
+
+struct chunk {
+    // Chunk Coordinates.
+    Vec3i pos;
+
+    // Palette (block ids, and how many cells use each entry).
+    uint16_t* palette;
+    uint16_t* refs;
+    uint32_t palette_size;
+
+    // Packed Cell Indices (NULL when uniform, or block ids directly at 16 bits).
+    uint64_t* data;
+    uint32_t bits;
+
+    // Bumped on every change.
+    uint32_t version;
+
+    // Set by world_set_block, cleared when saved (see region.h).
+    bool modified;
+
+    // Render Data (see chunkrender.h), NULL until drawn.
+    ChunkDraw* draw;
+
+    // Light per cell (see light.h), NULL while every cell holds 'light_fill'.
+    uint8_t* light;
+    uint8_t light_fill;
+
+    // Lighting State: lit once, changes queued, changed by the running job.
+    bool lit;
+    bool light_queued;
+    bool light_dirty;
+};
+
+struct world {
+    // Chunk Table (power of two, at most half full).
+    Chunk** table;
+    uint32_t table_size;
+    uint32_t chunk_count;
+
+    // Removal Callback (may be NULL).
+    void (*on_remove) (Chunk* chunk, void* user);
+    void* user;
+
+    // Lighting (may be NULL).
+    Lighting* light;
+};
+
+struct world_stats {
+    uint32_t chunks;
+    uint32_t uniform_chunks;
+    size_t bytes;
+    float bytes_per_block;
+};
+
+// Local cell index of block (x,y,z) in its chunk.
+static inline
+uint32_t chunk_index (int32_t x, int32_t y, int32_t z) {
+    return ((y & CHUNK_MASK) << (2*CHUNK_BITS)) | ((z & CHUNK_MASK) << CHUNK_BITS) | (x & CHUNK_MASK);
+}
+
+// Chunk coordinates of block (x,y,z).
+static inline
+Vec3i chunk_coords (int32_t x, int32_t y, int32_t z) {
+    return (Vec3i) {x >> CHUNK_BITS, y >> CHUNK_BITS, z >> CHUNK_BITS};
+}
+
+// Create and Destroy Worlds.
+World* world_create ();
+void world_destroy (World* world);
+
+// Create and Destroy detached Chunks (all air).
+//  - A detached chunk belongs to nobody, so it can be filled on any thread.
+Chunk* chunk_create (Vec3i pos);
+void chunk_destroy (Chunk* chunk);
+
+// Chunks.
+//  - world_get_chunk returns NULL for missing chunks.
+//  - world_add_chunk returns the existing chunk, or a new all-air one.
+//  - world_insert_chunk hands a detached chunk over to the world, it returns false
+//    (and the chunk stays the caller's) if its position is taken.
+Chunk* world_get_chunk (World* world, Vec3i pos);
+Chunk* world_add_chunk (World* world, Vec3i pos);
+bool world_insert_chunk (World* world, Chunk* chunk);
+void world_remove_chunk (World* world, Vec3i pos);
+
+// Blocks (world coordinates).
+//  - world_set_block creates chunks as needed (but not to store air).
+uint16_t world_get_block (World* world, int32_t x, int32_t y, int32_t z);
+void world_set_block (World* world, int32_t x, int32_t y, int32_t z, uint16_t block);
+
+// Blocks (local cell index, see chunk_index).
+//  - chunk_set returns false if the cell already held 'block'.
+uint16_t chunk_get (const Chunk* chunk, uint32_t index);
+bool chunk_set (Chunk* chunk, uint32_t index, uint16_t block);
+
+// Fill a whole chunk with one block (makes it uniform).
+void chunk_fill (Chunk* chunk, uint16_t block);
+
+// Replace every cell at once (CHUNK_VOLUME block ids in chunk_index order).
+//  - Builds the palette in one pass, much faster than a chunk_set per cell.
+void chunk_set_blocks (Chunk* chunk, const uint16_t* blocks);
+
+// Light of a cell (local cell index): sky light in the high nibble, block light in the low one.
+static inline
+uint8_t chunk_get_light (const Chunk* chunk, uint32_t index) {
+    return chunk->light != NULL ? chunk->light[index] : chunk->light_fill;
+}
+
+// True if every cell holds the same block.
+static inline
+bool chunk_is_uniform (const Chunk* chunk) {
+    return chunk->bits == 0;
+}
+
+// Serialized Chunks (blocks only, position not included).
+//  - chunk_serialize writes at most CHUNK_SERIAL_MAX bytes and returns the size.
+//  - chunk_deserialize replaces the contents of a (detached) chunk, false if malformed.
+#define CHUNK_SERIAL_MAX (4 + 2*256 + CHUNK_VOLUME*2)
+
+size_t chunk_serialize (const Chunk* chunk, uint8_t* out);
+bool chunk_deserialize (Chunk* chunk, const uint8_t* data, size_t size);
+
+// Memory used by the world's block storage.
+void world_get_stats (World* world, WorldStats* stats);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../src/main.h"
+
+#include <time.h>
+
+// BENCHMARKS
+//
+// - Every tools/bench_*.c is a standalone program, built against the engine sources
+//   with optimizations on (see 'make bench' in the makefile), and run by 'make bench'.
+// - They print one line per measurement, nothing is checked against a threshold.
+// - bench_sink keeps results alive, so the optimizer can't drop the measured work.
+
+static volatile float bench_sink;
+
+// Monotonic time (seconds).
+static inline
+double bench_now () {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Deterministic random numbers in [lo, hi).
+static inline
+float bench_random (uint32_t* state, float lo, float hi) {
+    *state = *state * 1664525u + 1013904223u;
+    return lo + (hi - lo) * (float) (*state >> 8) / (float) (1u << 24);
+}
@@ -0,0 +1,108 @@
+#include "bench.h"
+
+#include "../src/world.h"
+#include "../src/chunkmesh.h"
+#include "../src/terrain.h"
+
+// Chunk mesher: time per chunk, and greedy quads against one quad per visible face.
+//  - Terrain: the chunks around the spawn, generated from WORLD_SEED, without light.
+//  - Synthetic snapshots for the extremes: a solid cube in air (best case for merging),
+//    a checkerboard (nothing merges), and a random half-filled chunk.
+//  - Triangles are two per quad, so the ratio is the same for triangles.
+
+#define MESH_ROUNDS 200
+#define TERRAIN_RADIUS 6
+
+static uint16_t blocks[CHUNKMESH_VOLUME];
+static uint8_t light[CHUNKMESH_VOLUME];
+
+static void report (const char* name, uint32_t chunks, double seconds, uint64_t faces, uint64_t quads) {
+    printf("  %-12s %5u chunks  %7.1f us/chunk   faces %8llu   quads %7llu   (%.1fx fewer)\n",
+        name, chunks, seconds * 1e6 / chunks, (unsigned long long) faces, (unsigned long long) quads,
+        quads > 0 ? (double) faces / quads : 0.0);
+}
+
+// Mesh the current snapshot MESH_ROUNDS times.
+static void bench_snapshot (const char* name, ChunkMesh* mesh) {
+    double start = bench_now();
+    for (int r = 0; r < MESH_ROUNDS; r++) {
+        chunkmesh_build(mesh, blocks, light);
+    }
+    double seconds = bench_now() - start;
+
+    report(name, MESH_ROUNDS, seconds, (uint64_t) mesh->faces * MESH_ROUNDS, (uint64_t) mesh->quads * MESH_ROUNDS);
+}
+
+static void fill_snapshot (uint32_t pattern, uint32_t* seed) {
+    memset(blocks, 0, sizeof(blocks));
+    memset(light, 0xF0, sizeof(light));
+
+    for (int32_t y = 0; y < CHUNK_SIZE; y++)
+    for (int32_t z = 0; z < CHUNK_SIZE; z++)
+    for (int32_t x = 0; x < CHUNK_SIZE; x++) {
+        bool solid = pattern == 0 ? true
+                   : pattern == 1 ? ((x + y + z) & 1) == 0
+                   : bench_random(seed, 0, 1) < 0.5f;
+        blocks[chunkmesh_index(x, y, z)] = solid ? BLOCK_STONE : BLOCK_AIR;
+    }
+}
+
+static void bench_terrain (ChunkMesh* mesh) {
+    // Allocate and Initialize.
+    World* world = world_create();
+    Terrain* terrain = terrain_create(WORLD_SEED);
+
+    int32_t r = TERRAIN_RADIUS;
+    int32_t height = TERRAIN_MAX_HEIGHT / CHUNK_SIZE + 1;
+    for (int32_t j = -height; j <= height; j++)
+    for (int32_t k = -r; k <= r; k++)
+    for (int32_t i = -r; i <= r; i++) {
+        Chunk* chunk = chunk_create((Vec3i) {i, j, k});
+        terrain_generate(terrain, chunk);
+        world_insert_chunk(world, chunk);
+    }
+
+    // Mesh every chunk away from the edge (so all neighbours are there).
+    uint32_t chunks = 0;
+    uint64_t faces = 0, quads = 0;
+    double gather = 0, build = 0;
+    for (int32_t j = -height + 1; j < height; j++)
+    for (int32_t k = -r + 1; k < r; k++)
+    for (int32_t i = -r + 1; i < r; i++) {
+        double start = bench_now();
+        chunkmesh_gather(world, (Vec3i) {i, j, k}, blocks, light);
+        double mid = bench_now();
+        chunkmesh_build(mesh, blocks, light);
+        double end = bench_now();
+
+        gather += mid - start;
+        build += end - mid;
+        faces += mesh->faces;
+        quads += mesh->quads;
+        chunks++;
+    }
+
+    report("terrain", chunks, build, faces, quads);
+    printf("  %-12s %5u chunks  %7.1f us/chunk\n", "gather", chunks, gather * 1e6 / chunks);
+
+    terrain_destroy(terrain);
+    world_destroy(world);
+}
+
+int main () {
+    ChunkMesh* mesh = chunkmesh_create();
+    uint32_t seed = 5;
+
+    printf("chunk mesher (greedy quads vs one quad per visible face)\n");
+
+    bench_terrain(mesh);
+
+    fill_snapshot(0, &seed);
+    bench_snapshot("solid", mesh);
+    fill_snapshot(1, &seed);
+    bench_snapshot("checkerboard", mesh);
+    fill_snapshot(2, &seed);
+    bench_snapshot("random", mesh);
+
+    chunkmesh_destroy(mesh);
+}
@@ -0,0 +1,93 @@
+#include "bench.h"
+
+#include "../src/array.h"
+#include "../src/entity.h"
+#include "../src/environment.h"
+#include "../src/flock.h"
+#include "../src/jobs.h"
+
+// Flocking step on the 50k-agent scene.
+//  - Agents are spread through a 200x50x200 box with awareness 8 (like orbs), about
+//    50 neighbours each, and moved by their velocity between steps (no physics).
+//  - Only the fields flock_step reads are set, so no entity types (or GL) are needed.
+//  - Reports ms per step against the 60 Hz tick budget, with the whole pool and with
+//    one worker.
+
+#define AGENT_COUNT 50000
+#define AGENT_STEPS 20
+#define TICK_BUDGET_MS (1000.0 / 60.0)
+
+static double time_steps (Environment* env, JobPool* jobs) {
+    Flock* flock = flock_create(jobs);
+    flock_set_target(flock, cons3f(0, 25, 0), 0.1f);
+
+    // Warm up (first step sizes the arrays).
+    flock_step(flock, env);
+
+    double start = bench_now();
+    for (int s = 0; s < AGENT_STEPS; s++) {
+        flock_step(flock, env);
+
+        for (int i = 0; i < env->entities->size; i++) {
+            Entity* e = env->entities->data[i];
+            e->pos = add3f(e->pos, e->vel);
+        }
+    }
+    double ms = (bench_now() - start) * 1e3 / AGENT_STEPS;
+
+    flock_destroy(flock);
+    return ms;
+}
+
+int main () {
+    // Allocate and Initialize.
+    Environment env = {0};
+    env.entities = array_create();
+
+    uint32_t seed = 4;
+    for (uint32_t i = 0; i < AGENT_COUNT; i++) {
+        Entity* e = calloc(1, sizeof(Entity));
+        e->id = i;
+        e->state = STATE_NORMAL;
+        e->flags = FLAG_FLOCK;
+        e->awareness = 8;
+        e->pos = cons3f(bench_random(&seed, -100, 100), bench_random(&seed, 0, 50), bench_random(&seed, -100, 100));
+        e->vel = cons3f(bench_random(&seed, -0.1f, 0.1f), bench_random(&seed, -0.1f, 0.1f), bench_random(&seed, -0.1f, 0.1f));
+        array_add(env.entities, e);
+    }
+
+    // Each run starts from the same scene.
+    Vec3f* pos = malloc(AGENT_COUNT * sizeof(Vec3f));
+    Vec3f* vel = malloc(AGENT_COUNT * sizeof(Vec3f));
+    for (uint32_t i = 0; i < AGENT_COUNT; i++) {
+        Entity* e = env.entities->data[i];
+        pos[i] = e->pos;
+        vel[i] = e->vel;
+    }
+
+    printf("flock step (%d agents, 60 Hz budget %.1f ms)\n", AGENT_COUNT, TICK_BUDGET_MS);
+
+    JobPool* single = jobs_create(1);
+    double single_ms = time_steps(&env, single);
+    printf("  %2d threads  %7.2f ms\n", single->thread_count + 1, single_ms);
+    jobs_destroy(single);
+
+    for (uint32_t i = 0; i < AGENT_COUNT; i++) {
+        Entity* e = env.entities->data[i];
+        e->pos = pos[i];
+        e->vel = vel[i];
+    }
+
+    JobPool* pool = jobs_create(0);
+    double pool_ms = time_steps(&env, pool);
+    printf("  %2d threads  %7.2f ms%s\n", pool->thread_count + 1, pool_ms,
+        pool_ms <= TICK_BUDGET_MS ? "" : "   over budget");
+    jobs_destroy(pool);
+
+    for (uint32_t i = 0; i < AGENT_COUNT; i++) {
+        free(env.entities->data[i]);
+    }
+    array_destroy(env.entities);
+    free(pos);
+    free(vel);
+}
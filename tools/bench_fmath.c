@@ -0,0 +1,104 @@
+#include "bench.h"
+
+// Float sin/cos kernels against libm.
+//  - Accuracy is the largest absolute error against the double sin/cos, over two ranges:
+//    one turn, and the whole range fmath.h promises (|x| up to ~1e4).
+//  - Throughput is ns per value (one sin and one cos) against sinf + cosf.
+
+#define VALUE_COUNT 4096
+#define VALUE_ROUNDS 2000
+#define ACCURACY_SAMPLES 4000000
+
+typedef void (*sincos_fn) (float x, float* s, float* c);
+typedef void (*sincos_array_fn) (const float* x, float* s, float* c, uint32_t count);
+
+static void libm_sincos (float x, float* s, float* c) {
+    *s = sinf(x);
+    *c = cosf(x);
+}
+
+static void libm_sincos_array (const float* x, float* s, float* c, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        s[i] = sinf(x[i]);
+        c[i] = cosf(x[i]);
+    }
+}
+
+static void scalar_array (const float* x, float* s, float* c, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        fsincos(x[i], &s[i], &c[i]);
+    }
+}
+
+static void scalar_array_fast (const float* x, float* s, float* c, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        fsincos_fast(x[i], &s[i], &c[i]);
+    }
+}
+
+static float max_error (sincos_fn f, float range) {
+    double error = 0;
+    for (uint32_t i = 0; i <= ACCURACY_SAMPLES; i++) {
+        float x = -range + 2 * range * (float) i / ACCURACY_SAMPLES;
+        float s, c;
+        f(x, &s, &c);
+        error = fmax(error, fmax(fabs(s - sin(x)), fabs(c - cos(x))));
+    }
+    return error;
+}
+
+static float max_error_array (sincos_array_fn f, float range) {
+    float x[VALUE_COUNT], s[VALUE_COUNT], c[VALUE_COUNT];
+    double error = 0;
+    for (uint32_t i = 0; i <= ACCURACY_SAMPLES; i += VALUE_COUNT) {
+        for (uint32_t n = 0; n < VALUE_COUNT; n++) {
+            x[n] = -range + 2 * range * (float) (i + n) / ACCURACY_SAMPLES;
+        }
+        f(x, s, c, VALUE_COUNT);
+        for (uint32_t n = 0; n < VALUE_COUNT; n++) {
+            error = fmax(error, fmax(fabs(s[n] - sin(x[n])), fabs(c[n] - cos(x[n]))));
+        }
+    }
+    return error;
+}
+
+// Nanoseconds per value.
+static double time_array (sincos_array_fn f, const float* x, float* s, float* c) {
+    double start = bench_now();
+    for (int r = 0; r < VALUE_ROUNDS; r++) {
+        f(x, s, c, VALUE_COUNT);
+    }
+    bench_sink = s[VALUE_COUNT - 1] + c[0];
+    return (bench_now() - start) * 1e9 / ((double) VALUE_ROUNDS * VALUE_COUNT);
+}
+
+static void report (const char* name, sincos_fn f, sincos_array_fn array, const float* x, float* s, float* c) {
+    printf("  %-18s %6.2f ns   max error %.1e (one turn)   %.1e (|x| < 1e4)\n",
+        name, time_array(array, x, s, c), max_error(f, PI), max_error(f, 1e4f));
+}
+
+int main () {
+    // Allocate and Initialize (angles of a few turns, like camera and mesh code uses).
+    float* x = malloc(VALUE_COUNT * sizeof(float));
+    float* s = malloc(VALUE_COUNT * sizeof(float));
+    float* c = malloc(VALUE_COUNT * sizeof(float));
+
+    uint32_t seed = 3;
+    for (int i = 0; i < VALUE_COUNT; i++) {
+        x[i] = bench_random(&seed, -4 * PI, 4 * PI);
+    }
+
+    printf("sin/cos (%d values)\n", VALUE_COUNT);
+    report("sinf + cosf", libm_sincos, libm_sincos_array, x, s, c);
+    report("fsincos", fsincos, scalar_array, x, s, c);
+    report("fsincos_fast", fsincos_fast, scalar_array_fast, x, s, c);
+
+    printf("  %-18s %6.2f ns   max error %.1e (one turn)\n",
+        "fsincos_array", time_array(fsincos_array, x, s, c), max_error_array(fsincos_array, PI));
+    printf("  %-18s %6.2f ns   max error %.1e (one turn)\n",
+        "fsincos_array_fast", time_array(fsincos_array_fast, x, s, c), max_error_array(fsincos_array_fast, PI));
+
+    free(x);
+    free(s);
+    free(c);
+}
@@ -0,0 +1,208 @@
+#include "bench.h"
+
+// Mat4f kernels against their scalar reference versions, and batch transform throughput.
+//  - Matrices are packed in a malloc'd array, so half of them sit on 16-byte (not
+//    32-byte) boundaries, like Mat4f fields in entities do.
+//  - Batches are small enough to stay in L2, so they measure the kernels, not memory.
+
+#define MATRIX_COUNT 1024
+#define MATRIX_ROUNDS 2000
+
+#define POINT_COUNT 16384
+#define POINT_ROUNDS 500
+
+typedef void (*mul_fn) (Mat4f* out, const Mat4f* a, const Mat4f* b);
+typedef void (*transpose_fn) (Mat4f* out, const Mat4f* m);
+typedef bool (*inverse_fn) (Mat4f* out, const Mat4f* m);
+
+static float max_difference (const Mat4f* a, const Mat4f* b) {
+    const float* x = (const float*) a;
+    const float* y = (const float*) b;
+    float diff = 0;
+    for (int i = 0; i < 16; i++) {
+        diff = fmaxf(diff, fabsf(x[i] - y[i]));
+    }
+    return diff;
+}
+
+static double time_mul (mul_fn mul, Mat4f* out, const Mat4f* m) {
+    double start = bench_now();
+    for (int r = 0; r < MATRIX_ROUNDS; r++) {
+        for (int i = 0; i < MATRIX_COUNT; i++) {
+            mul(&out[i], &m[i], &m[(i + r) % MATRIX_COUNT]);
+        }
+    }
+    bench_sink = out[MATRIX_ROUNDS % MATRIX_COUNT].ax;
+    return (bench_now() - start) * 1e9 / ((double) MATRIX_ROUNDS * MATRIX_COUNT);
+}
+
+static double time_transpose (transpose_fn transpose, Mat4f* out, const Mat4f* m) {
+    double start = bench_now();
+    for (int r = 0; r < MATRIX_ROUNDS; r++) {
+        for (int i = 0; i < MATRIX_COUNT; i++) {
+            transpose(&out[i], &m[(i + r) % MATRIX_COUNT]);
+        }
+    }
+    bench_sink = out[0].ax;
+    return (bench_now() - start) * 1e9 / ((double) MATRIX_ROUNDS * MATRIX_COUNT);
+}
+
+static double time_inverse (inverse_fn inverse, Mat4f* out, const Mat4f* m) {
+    double start = bench_now();
+    for (int r = 0; r < MATRIX_ROUNDS; r++) {
+        for (int i = 0; i < MATRIX_COUNT; i++) {
+            inverse(&out[i], &m[(i + r) % MATRIX_COUNT]);
+        }
+    }
+    bench_sink = out[0].ax;
+    return (bench_now() - start) * 1e9 / ((double) MATRIX_ROUNDS * MATRIX_COUNT);
+}
+
+// Scalar baseline for the batch kernels.
+static void transform_points_scalar (const Mat4f* m, const Vec3f* in, Vec3f* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = mat4f_transform_point(m, in[i]);
+    }
+}
+
+static void transform_dirs_scalar (const Mat4f* m, const Vec3f* in, Vec3f* out, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = mat4f_transform_dir(m, in[i]);
+    }
+}
+
+typedef void (*batch_fn) (const Mat4f* m, const Vec3f* in, Vec3f* out, uint32_t count);
+
+// Points per nanosecond.
+static double time_batch (batch_fn batch, const Mat4f* m, const Vec3f* in, Vec3f* out) {
+    double start = bench_now();
+    for (int r = 0; r < POINT_ROUNDS; r++) {
+        batch(m, in, out, POINT_COUNT);
+    }
+    bench_sink = out[POINT_COUNT - 1].x;
+    return (double) POINT_ROUNDS * POINT_COUNT / ((bench_now() - start) * 1e9);
+}
+
+static double time_soa (const Mat4f* m, const float* x, const float* y, const float* z, float* ox, float* oy, float* oz) {
+    double start = bench_now();
+    for (int r = 0; r < POINT_ROUNDS; r++) {
+        transform_points3f_soa(m, x, y, z, ox, oy, oz, POINT_COUNT);
+    }
+    bench_sink = ox[POINT_COUNT - 1];
+    return (double) POINT_ROUNDS * POINT_COUNT / ((bench_now() - start) * 1e9);
+}
+
+static double time_project (const Mat4f* m, const Vec3f* in, Vec4f* out) {
+    double start = bench_now();
+    for (int r = 0; r < POINT_ROUNDS; r++) {
+        project_points(m, in, out, POINT_COUNT);
+    }
+    bench_sink = out[POINT_COUNT - 1].x;
+    return (double) POINT_ROUNDS * POINT_COUNT / ((bench_now() - start) * 1e9);
+}
+
+static float max_difference3 (const Vec3f* a, const Vec3f* b, uint32_t count) {
+    float diff = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        diff = fmaxf(diff, fmaxf(fabsf(a[i].x - b[i].x), fmaxf(fabsf(a[i].y - b[i].y), fabsf(a[i].z - b[i].z))));
+    }
+    return diff;
+}
+
+static void bench_batches (const Mat4f* m) {
+    // Allocate and Initialize.
+    Vec3f* in = malloc(POINT_COUNT * sizeof(Vec3f));
+    Vec3f* out = malloc(POINT_COUNT * sizeof(Vec3f));
+    Vec3f* ref = malloc(POINT_COUNT * sizeof(Vec3f));
+    Vec4f* projected = malloc(POINT_COUNT * sizeof(Vec4f));
+    float* soa = malloc(6 * POINT_COUNT * sizeof(float));
+    float *x = soa, *y = x + POINT_COUNT, *z = y + POINT_COUNT;
+    float *ox = z + POINT_COUNT, *oy = ox + POINT_COUNT, *oz = oy + POINT_COUNT;
+
+    uint32_t seed = 2;
+    for (uint32_t i = 0; i < POINT_COUNT; i++) {
+        in[i] = cons3f(bench_random(&seed, -100, 100), bench_random(&seed, -100, 100), bench_random(&seed, -100, 100));
+        x[i] = in[i].x;
+        y[i] = in[i].y;
+        z[i] = in[i].z;
+    }
+
+    // Accuracy.
+    transform_points3f(m, in, out, POINT_COUNT);
+    transform_points_scalar(m, in, ref, POINT_COUNT);
+    float point_error = max_difference3(out, ref, POINT_COUNT);
+
+    transform_dirs3f(m, in, out, POINT_COUNT);
+    transform_dirs_scalar(m, in, ref, POINT_COUNT);
+    float dir_error = max_difference3(out, ref, POINT_COUNT);
+
+    printf("batch transforms (%d points, points/ns)\n", POINT_COUNT);
+    printf("  points aos %6.2f      scalar %6.2f      max diff %.1e\n",
+        time_batch(transform_points3f, m, in, out), time_batch(transform_points_scalar, m, in, out), point_error);
+    printf("  dirs aos   %6.2f      scalar %6.2f      max diff %.1e\n",
+        time_batch(transform_dirs3f, m, in, out), time_batch(transform_dirs_scalar, m, in, out), dir_error);
+    printf("  points soa %6.2f\n", time_soa(m, x, y, z, ox, oy, oz));
+    printf("  project    %6.2f\n", time_project(m, in, projected));
+
+    free(in);
+    free(out);
+    free(ref);
+    free(projected);
+    free(soa);
+}
+
+int main () {
+    // Allocate and Initialize (random TRS matrices, so they're all invertible).
+    Mat4f* m = malloc(MATRIX_COUNT * sizeof(Mat4f));
+    Mat4f* out = malloc(MATRIX_COUNT * sizeof(Mat4f));
+    Mat4f* ref = malloc(MATRIX_COUNT * sizeof(Mat4f));
+
+    uint32_t seed = 1;
+    for (int i = 0; i < MATRIX_COUNT; i++) {
+        Vec3f t = cons3f(bench_random(&seed, -10, 10), bench_random(&seed, -10, 10), bench_random(&seed, -10, 10));
+        Vec4f q = cons4f(bench_random(&seed, -1, 1), bench_random(&seed, -1, 1), bench_random(&seed, -1, 1), 1);
+        Vec3f s = cons3f(bench_random(&seed, 0.5f, 2), bench_random(&seed, 0.5f, 2), bench_random(&seed, 0.5f, 2));
+        m[i] = mat4f_trs(t, normalize4f(q), s);
+    }
+
+    // Accuracy (against the scalar versions).
+    float mul_error = 0, transpose_error = 0, inverse_error = 0;
+    for (int i = 0; i < MATRIX_COUNT; i++) {
+        const Mat4f* b = &m[(i * 7 + 3) % MATRIX_COUNT];
+
+        mat4f_mul(&out[i], &m[i], b);
+        mat4f_mul_scalar(&ref[i], &m[i], b);
+        mul_error = fmaxf(mul_error, max_difference(&out[i], &ref[i]));
+
+        mat4f_transpose(&out[i], &m[i]);
+        mat4f_transpose_scalar(&ref[i], &m[i]);
+        transpose_error = fmaxf(transpose_error, max_difference(&out[i], &ref[i]));
+
+        mat4f_inverse(&out[i], &m[i]);
+        mat4f_inverse_scalar(&ref[i], &m[i]);
+        inverse_error = fmaxf(inverse_error, max_difference(&out[i], &ref[i]));
+    }
+
+    printf("matrix kernels (%s)\n",
+#if defined(__AVX__)
+        "avx"
+#elif defined(__SSE2__)
+        "sse2"
+#else
+        "scalar only"
+#endif
+    );
+
+    printf("  mul        %6.2f ns   scalar %6.2f ns   max diff %.1e\n",
+        time_mul(mat4f_mul, out, m), time_mul(mat4f_mul_scalar, out, m), mul_error);
+    printf("  transpose  %6.2f ns   scalar %6.2f ns   max diff %.1e\n",
+        time_transpose(mat4f_transpose, out, m), time_transpose(mat4f_transpose_scalar, out, m), transpose_error);
+    printf("  inverse    %6.2f ns   scalar %6.2f ns   max diff %.1e\n",
+        time_inverse(mat4f_inverse, out, m), time_inverse(mat4f_inverse_scalar, out, m), inverse_error);
+
+    bench_batches(&m[0]);
+
+    free(m);
+    free(out);
+    free(ref);
+}
@@ -0,0 +1,72 @@
+#include "bench.h"
+
+#include "../src/world.h"
+#include "../src/terrain.h"
+#include "../src/jobs.h"
+
+// Terrain generation throughput (chunks per second).
+//  - Generates a band of chunks along +x, as a player flying in a straight line would
+//    stream them: every layer from deep rock up to above the highest hills.
+//  - One core (the calling thread), then spread over the job pool like the streamer does.
+
+#define TERRAIN_LENGTH 64
+#define TERRAIN_WIDTH 8
+
+struct generate_job {
+    Terrain* terrain;
+    Chunk** chunks;
+};
+
+static void generate_main (void* arg, uint32_t index) {
+    struct generate_job* job = arg;
+    terrain_generate(job->terrain, job->chunks[index]);
+}
+
+int main () {
+    // Allocate and Initialize.
+    Terrain* terrain = terrain_create(WORLD_SEED);
+
+    int32_t top = TERRAIN_MAX_HEIGHT / CHUNK_SIZE + 1;
+    int32_t bottom = -top - 2;
+    uint32_t count = TERRAIN_LENGTH * TERRAIN_WIDTH * (top - bottom + 1);
+
+    Chunk** chunks = malloc(count * sizeof(Chunk*));
+    uint32_t n = 0;
+    for (int32_t j = bottom; j <= top; j++)
+    for (int32_t k = 0; k < TERRAIN_WIDTH; k++)
+    for (int32_t i = 0; i < TERRAIN_LENGTH; i++) {
+        chunks[n++] = chunk_create((Vec3i) {i, j, k});
+    }
+
+    printf("terrain generation (%u chunks, layers %d..%d)\n", count, bottom, top);
+
+    // One Core.
+    double start = bench_now();
+    for (uint32_t i = 0; i < count; i++) {
+        terrain_generate(terrain, chunks[i]);
+    }
+    double seconds = bench_now() - start;
+    printf("  1 thread    %8.0f chunks/s   %6.1f us/chunk\n", count / seconds, seconds * 1e6 / count);
+
+    // Job Pool.
+    JobPool* pool = jobs_create(0);
+    struct generate_job job = {terrain, chunks};
+
+    start = bench_now();
+    jobs_parallel_for(pool, count, generate_main, &job);
+    seconds = bench_now() - start;
+    printf("  %u threads   %8.0f chunks/s\n", pool->thread_count + 1, count / seconds);
+
+    jobs_destroy(pool);
+
+    // Uniform chunks (stored without cell data).
+    uint32_t uniform = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        uniform += chunk_is_uniform(chunks[i]);
+        chunk_destroy(chunks[i]);
+    }
+    printf("  %u of %u chunks uniform\n", uniform, count);
+
+    free(chunks);
+    terrain_destroy(terrain);
+}